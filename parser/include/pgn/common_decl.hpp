@@ -49,6 +49,7 @@ typedef enum
 class IMove;                                    /**< forward declaration */
 class IGame;                                    /**< forward declaration */
 class IParser;                                  /**< forward declaration */
+class IGameVisitor;                             /**< forward declaration */
 
 } /* namespace pgn */
 
@@ -54,6 +54,28 @@ typedef struct
 /** Invalid value of tag_pair_t. */
 extern const tag_pair_t NULL_TAG_PAIR;
 
+/**
+ * The type describes an identifier of a tag name. Tag names are interned
+ * into a table which is shared by all parsers, thus the same name has the
+ * same identifier in each game (see IGame::getTagId(...)). */
+typedef unsigned tag_id_t;
+
+/** Invalid identifier of a tag name. */
+extern const tag_id_t NULL_TAG_ID;
+
+/**
+ * Fixed identifiers of STR (Seven Tag Roster) tags. */
+typedef enum
+{
+    tiEvent,                                    /**< "Event" tag */
+    tiSite,                                     /**< "Site" tag */
+    tiDate,                                     /**< "Date" tag */
+    tiRound,                                    /**< "Round" tag */
+    tiWhite,                                    /**< "White" tag */
+    tiBlack,                                    /**< "Black" tag */
+    tiResult                                    /**< "Result" tag */
+} roster_tag_t;
+
 /**
  * The class represents information about a game in pgn-file. A PGN game is
  * composed of two sections. The first is the tag pair section and the second
@@ -74,7 +96,14 @@ extern const tag_pair_t NULL_TAG_PAIR;
  * they appear. Although the definition and use of additional tag names
  * and semantics is permitted and encouraged when needed, the STR is
  * the common ground that all programs should follow for public data
- * interchange. */
+ * interchange.
+ *
+ * Note: an IGame object isn't thread-safe even through a const pointer.
+ * The movetext section is parsed on demand (see IParser::readGame(...)),
+ * moves (IMove objects and their SAN) and the movetext are created on
+ * demand and getTagPair() keeps position of the iteration. All of them
+ * change the object, thus a game must not be used by several threads at the
+ * same time. Different games can be used by different threads. */
 class PGN_LIB_API IGame : public IRefObject
 {
 public:
@@ -89,6 +118,25 @@ public:
      * it returns syntax error. */
     static syntax_error_t isMoveValid(IMove const* move);
 
+    /**
+     * Get an identifier of a tag name. Resolve the identifier once and use
+     * getTagValueById(...) for each game, thus tag names aren't compared.
+     * @param [in] name     name of a tag (case-sensitive).
+     *
+     * @return Identifier of the name. The name is added to the table of tag
+     * names if it isn't there yet (names of parsed files are never added,
+     * the table contains well-known names and names which were passed to
+     * the method only). If the table is full NULL_TAG_ID is returned. */
+    static tag_id_t getTagId(char const* name);
+
+    /**
+     * Get a tag name by its identifier.
+     * @param [in] id       identifier of a tag name.
+     *
+     * @return Null-terminated string which contains the name or NULL if
+     * there is no such identifier. */
+    static char const* getTagName(tag_id_t id);
+
     /**
      * Get number of the game. Using the number you can get the game again
      * with help of readGame() method.
@@ -137,6 +185,15 @@ public:
      * @return Null-terminated string which contains tag value. */
     virtual char const* getTagValue(char const* name) const = 0;
 
+    /**
+     * Get an arbitrary value of tag pair section by identifier of tag's
+     * name. It is faster than getTagValue(...), especially for STR tags.
+     * @param [in] id       identifier which was returned by getTagId(...)
+     *                      or a value of roster_tag_t.
+     * @return Null-terminated string which contains tag value or NULL if
+     * the game doesn't have the tag. */
+    virtual char const* getTagValueById(tag_id_t id) const = 0;
+
     /**
      * Get number of tag pairs in tag pair section.
      * @return Number of tag pairs. */
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_LIB_GAME_RANGE_HPP
+#define PGN_LIB_GAME_RANGE_HPP
+
+#include <pgn/parser.hpp>
+#include <pgn/game.hpp>
+
+#include <cstddef>
+#include <iterator>
+
+namespace pgn
+{
+
+/**
+ * Options of pgn::GameRange. They can be combined by bitwise OR. */
+typedef enum
+{
+    roDefault       = 0x00, /**< all games of the file */
+    roSelectedOnly  = 0x01, /**< games which satisfy the filter of the
+                                 parser only (see IParser::create(...) and
+                                 IParser::getSelectedGame(...)) */
+    roPrefetch      = 0x02  /**< data of the next batch of games is read
+                                 ahead in background while the current
+                                 batch is processed (see
+                                 IParser::prefetchGames(...)) */
+} range_option_t;
+
+/**
+ * Games of a PGN file as an input range. Games are read by batches with
+ * IParser::readGames(...), thus the parser is called once per batch and the
+ * range owns the games: the caller doesn't release them. A game is valid
+ * until the iterator leaves its batch, use addRef() to keep it longer.
+ *
+ * @code Example of using pgn::GameRange class:
+ * boost::intrusive_ptr<pgn::IParser> pgnparser;
+ * pgnparser = pgn::IParser::create("/path/to/pgnfile");
+ *
+ * pgn::GameRange games(pgnparser.get(), pgn::roPrefetch);
+ * for (pgn::GameRange::iterator it = games.begin(); it != games.end(); ++it)
+ * {
+ *     std::cout << it->getTagWhite() << std::endl;
+ * }
+ * @endcode
+ *
+ * Note: The range is single pass. Like IParser, it isn't thread-safe. */
+class PGN_LIB_API GameRange
+{
+public:
+    /** Input iterator over games of the range. */
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef IGame value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef IGame const* pointer;
+        typedef IGame const& reference;
+
+        /** The iterator is the end of any range. */
+        iterator() : m_range(NULL) {}
+
+        reference operator*() const { return *m_range->getGame(); }
+        pointer operator->() const { return m_range->getGame(); }
+
+        iterator& operator++()
+        {
+            m_range->next();
+            return *this;
+        }
+
+        bool operator==(iterator const& other) const
+        {
+            return isEnd() ? other.isEnd() :
+                !other.isEnd() && m_range == other.m_range;
+        }
+        bool operator!=(iterator const& other) const
+        {
+            return !( *this == other );
+        }
+
+    private:
+        friend class GameRange;
+
+        explicit iterator(GameRange* range) : m_range(range) {}
+
+        bool isEnd() const
+        {
+            return m_range == NULL || m_range->getGame() == NULL;
+        }
+
+        GameRange* m_range;
+    };
+
+    /**
+     * Create a range over games of the parser.
+     * @param [in] parser       parser of the PGN file. It is kept by the
+     *                          range. Games are read from the first one, the
+     *                          parser shouldn't be used by other threads
+     *                          while the range is iterated.
+     * @param [in] options      combination of range_option_t values.
+     * @param [in] batchSize    number of games which are read at once. */
+    GameRange(IParser* parser, unsigned options = roDefault,
+        unsigned batchSize = DEFAULT_BATCH_SIZE);
+    ~GameRange();
+
+    /**
+     * Get the iterator to the current game. The first batch is read on the
+     * first call. */
+    iterator begin();
+
+    /** Get the end of the range. */
+    iterator end() const { return iterator(); }
+
+    /** Default number of games in a batch. */
+    static const unsigned DEFAULT_BATCH_SIZE = 64;
+
+private:
+    GameRange(GameRange const& ); /* without implementation */
+    GameRange& operator=(GameRange const& ); /* without implementation */
+
+    IGame const* getGame() const
+    {
+        return ( m_position < m_gameCount ) ? m_batch[m_position] : NULL;
+    }
+
+    void next()
+    {
+        if ( ++m_position >= m_gameCount )
+        {
+            readBatch();
+        }
+    }
+
+    void readBatch();
+    unsigned readGames(unsigned next, IGame const** games, bool isPrefetch);
+    void releaseBatch();
+
+    IParser* m_parser;
+    unsigned m_options;
+    unsigned m_batchSize;
+    IGame const** m_batch; /* games of the current batch */
+    unsigned m_gameCount; /* number of games in m_batch */
+    unsigned m_position; /* the current game in m_batch */
+    unsigned m_next; /* the first game of the next batch (from 1 to N) */
+    bool m_isStarted; /* the first batch is read */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_LIB_GAME_RANGE_HPP */
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_LIB_GAME_VISITOR_HPP
+#define PGN_LIB_GAME_VISITOR_HPP
+
+#include <pgn/common_decl.hpp>
+#include <pgn/game.hpp>
+#include <pgn/move.hpp>
+
+#include <cstddef>
+
+namespace pgn
+{
+
+/**
+ * Get elements of a game while it is parsed (see IParser::visitGame(...)).
+ * No IGame or IMove objects are created: strings are passed as views into
+ * the PGN file (they aren't null-terminated and they are valid during the
+ * call only). Methods are called in order of elements in the game. Each
+ * method does nothing by default, thus a visitor can implement the methods
+ * it needs only. */
+class PGN_LIB_API IGameVisitor
+{
+public:
+    /**
+     * A tag pair of the tag pair section.
+     * @param [in] name         name of the tag.
+     * @param [in] nameLength   length of the name.
+     * @param [in] value        value of the tag without quotes. Escaped
+     *                          characters (\" and \\) aren't decoded.
+     * @param [in] valueLength  length of the value. */
+    virtual void onTagPair(char const* /* name */,
+        std::size_t /* nameLength */, char const* /* value */,
+        std::size_t /* valueLength */) {}
+
+    /**
+     * A move of the current variation.
+     * @param [in] san          the move as it is written in the movetext
+     *                          (the move isn't checked on the board).
+     * @param [in] length       length of the move.
+     * @param [in] moveNumber   number of the move. */
+    virtual void onMove(char const* /* san */, std::size_t /* length */,
+        unsigned /* moveNumber */) {}
+
+    /**
+     * A NAG of the last move. Unknown NAGs (e.g. $0) aren't passed.
+     * @param [in] nag          numeric annotation glyph. */
+    virtual void onNAG(NAG_t /* nag */) {}
+
+    /**
+     * A comment of the movetext.
+     * @param [in] comment      the comment without delimiters.
+     * @param [in] length       length of the comment. */
+    virtual void onComment(char const* /* comment */,
+        std::size_t /* length */) {}
+
+    /**
+     * A variation (RAV) is started. It is an alternative to the last move,
+     * next moves belong to it until onVariationEnd() is called. */
+    virtual void onVariationBegin() {}
+
+    /**
+     * The current variation is finished. */
+    virtual void onVariationEnd() {}
+
+    /**
+     * The game is finished.
+     * @param [in] result       result of the game. It is taken from the
+     *                          termination marker (or from Result tag if
+     *                          the marker is absent). */
+    virtual void onResult(game_result_t /* result */) {}
+
+    /**
+     * The game is invalid (see IParser::isGameValid(...)). If the error is
+     * critical then parsing of the game is stopped after the call.
+     * @param [in] code         error code of the syntax error. */
+    virtual void onSyntaxError(syntax_error_t /* code */) {}
+
+protected:
+    virtual ~IGameVisitor() {}
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_LIB_GAME_VISITOR_HPP */
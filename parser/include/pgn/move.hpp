@@ -359,6 +359,16 @@ public:
      * element is nagNull also it means the move doesn't contain NAGs. */
     virtual NAG_t getNAG(unsigned n = NEXT_ITEM) const = 0;
 
+    /**
+     * Get all NAGs of the move at once. It is faster than getNAG() for
+     * moves with several NAGs.
+     * @param [out] nags    array for NAGs of the move. It can be NULL if
+     *                      size is zero.
+     * @param [in] size     size of the array.
+     * @return Number of NAGs of the move. If it is greater than size then
+     * only first size NAGs are copied into the array. */
+    virtual unsigned getNAGs(NAG_t* nags, unsigned size) const = 0;
+
     /**
      * Get comment for the move.
      * @return If the move contains a comment the method returns it. Otherwise
@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_LIB_PARALLEL_PARSER_HPP
+#define PGN_LIB_PARALLEL_PARSER_HPP
+
+#include <pgn/parser.hpp>
+
+namespace pgn
+{
+
+/**
+ * Order of games which are returned by IParallelParser::readGame(). */
+typedef enum
+{
+    doFileOrder,    /**< games are returned in order of the PGN file */
+    doReadyOrder    /**< games are returned as soon as they are parsed */
+} delivery_order_t;
+
+/**
+ * Parse all games of a PGN file by several threads. Games are found by
+ * lightweight parsing of IParser, after that each game is parsed completely
+ * (tag pair and movetext sections) by one of worker threads. Workers parse
+ * games ahead of the caller, but the number of games which are parsed and
+ * not read yet is limited.
+ *
+ * @code Example of using pgn::IParallelParser interface:
+ * boost::intrusive_ptr<pgn::IParser> pgnparser;
+ * pgnparser = pgn::IParser::create("/path/to/pgnfile");
+ *
+ * boost::intrusive_ptr<pgn::IParallelParser> parallelParser;
+ * parallelParser = pgn::IParallelParser::create(pgnparser.get());
+ *
+ * pgn::IGame const* game;
+ * while ((game = parallelParser->readGame()) != NULL)
+ * {
+ *     ...
+ *
+ *     game->release();
+ * }
+ * @endcode */
+class PGN_LIB_API IParallelParser : public IRefObject
+{
+public:
+    /**
+     * Create an instance of IParallelParser (factory method). Worker threads
+     * are started immediately.
+     * @param [in] parser       parser of the PGN file. The method waits
+     *                          until lightweight parsing of the file is done.
+     *                          The parser is kept by the instance, thus it
+     *                          can be released by the caller. Games which are
+     *                          appended to the file later are ignored.
+     * @param [in] order        order of games which are returned by
+     *                          readGame().
+     * @param [in] threadCount  number of worker threads. By default all CPUs
+     *                          are used.
+     * @return On success it returns an instance of IParallelParser.
+     * Otherwise it returns NULL. */
+    static IParallelParser* create(IParser* parser,
+        delivery_order_t order = doFileOrder, unsigned threadCount = 0);
+
+    /**
+     * Get the next parsed game. The method waits until a game is parsed.
+     *
+     * @return On success the method returns a game which is parsed
+     * completely, the caller is owner of it. Games are independent of each
+     * other, thus they can be used by different threads. If all games are
+     * returned or parsing is cancelled, the method returns NULL.
+     *
+     * Note: Syntax errors are reported by IErrorHandlerCallback of the
+     * parser from worker threads. */
+    virtual IGame const* readGame() = 0;
+
+    /**
+     * Stop worker threads. The method returns when the threads are stopped.
+     * Games which are parsed and not read yet are dropped. */
+    virtual void cancel() = 0;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_LIB_PARALLEL_PARSER_HPP */
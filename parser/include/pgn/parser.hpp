@@ -23,6 +23,8 @@
 #include "ref_object.hpp"
 #include "common_decl.hpp"
 
+#include <cstddef>
+
 namespace pgn
 {
 
@@ -50,6 +52,100 @@ public:
         unsigned column) = 0;
 };
 
+/**
+ * Get notification about modifications of pgn-file (see poWatchFile option).
+ * User can implement the interface and register it using
+ * IParser::setFileChangeHandler(...) method. */
+class PGN_LIB_API IFileChangeCallback : public IRefObject
+{
+public:
+    /**
+     * Notify that pgn-file was changed and the parser has found its games.
+     * The method is called in a background thread of the parser.
+     * @param [in] isRewritten  true if the file was rewritten. In this case
+     *                          all games are new and numbers of games which
+     *                          were read before are invalid.
+     * @param [in] firstGame    number of the first new or changed game (from
+     *                          1 to N). The last game of the file is
+     *                          reported again if new data is appended to it.
+     * @param [in] gameCount    number of new or changed games. */
+    virtual void operator()(bool isRewritten, unsigned firstGame,
+        unsigned gameCount) = 0;
+};
+
+/**
+ * Options of pgn::IParser. They can be combined by bitwise OR and passed to
+ * IParser::create(...) method. */
+typedef enum
+{
+    poDefault           = 0x00, /**< no options */
+    poParallelIndexing  = 0x01, /**< use all CPUs for lightweight parsing */
+    poIndexFile         = 0x02, /**< keep results of lightweight parsing in
+                                     a sidecar file (pgnfile + ".idx") and
+                                     reuse them if pgnfile isn't changed */
+    poAsyncIndexing     = 0x04, /**< do lightweight parsing in a background
+                                     thread. IParser::create(...) returns
+                                     immediately, readGame(N) waits until
+                                     N-th game is found only */
+    poVerifyHash        = 0x08, /**< check hash of each game which is read
+                                     by readGame(...). If the game was
+                                     changed then pgnfile is parsed again
+                                     (e.g. the index file is out of date) */
+    poWatchFile         = 0x10, /**< watch pgnfile for modifications in a
+                                     background thread and update the index
+                                     like refresh() does (see
+                                     IFileChangeCallback). Only Linux is
+                                     supported, on other platforms the option
+                                     is ignored */
+    poRecycleGames      = 0x20  /**< reuse memory of released games for next
+                                     games. If games are read one by one (or
+                                     by batches of GameRange) and released
+                                     before next games are read then memory
+                                     is allocated once. A game must not be
+                                     used after it is released */
+} parser_option_t;
+
+/**
+ * Parts of games which are kept by pgn::IParser (see
+ * IParser::setProjection(...)). They can be combined by bitwise OR. */
+typedef enum
+{
+    gpNone          = 0x00, /**< tag pairs and the result only */
+    gpMoves         = 0x01, /**< moves of the main line */
+    gpVariations    = 0x02, /**< moves of variations (RAV) */
+    gpComments      = 0x04, /**< comments of moves */
+    gpNAGs          = 0x08, /**< NAGs of moves */
+    gpAll           = 0x0f  /**< all parts of games */
+} game_part_t;
+
+/**
+ * Kinds of tag predicates (see tag_predicate_t). */
+typedef enum
+{
+    tpEqual,        /**< the tag value is equal to value */
+    tpPrefix,       /**< the tag value starts with value */
+    tpNumberRange,  /**< the tag value is an integer (e.g. WhiteElo) from
+                         value till maxValue */
+    tpDateRange     /**< the tag value is a date (YYYY.MM.DD) from value
+                         till maxValue. Unknown parts of the date ("??")
+                         match any month or day */
+} tag_predicate_kind_t;
+
+/**
+ * A predicate on a tag which is checked by lightweight parsing (see
+ * IParser::create(...)). Values are compared with unescaped tag values. */
+typedef struct
+{
+    char const* name;               /**< name of the tag (case-sensitive) */
+    tag_predicate_kind_t kind;
+    char const* value;              /**< the value or the lower bound of a
+                                         range (NULL if it is unbounded) */
+    char const* maxValue;           /**< the upper bound of a range (NULL if
+                                         it is unbounded) */
+    bool isAlternative;             /**< the predicate is joined with the
+                                         previous one by OR instead of AND */
+} tag_predicate_t;
+
 /**
  * The main interface for parsing PGN files.
  *
@@ -89,9 +185,21 @@ public:
      *                      true from IErrorHandlerCallback::operator(...). In
      *                      this case parser will fix the problem and continue
      *                      parsing.
+     * @param [in] options  combination of parser_option_t values.
+     * @param [in] filter   predicates on tags, the array is terminated by a
+     *                      predicate with NULL name. Games which satisfy
+     *                      them are selected during lightweight parsing
+     *                      (see getSelectedGame(...)), thus nothing is
+     *                      parsed twice. OR binds tighter than AND, e.g.
+     *                      "White or Black is X, and Date is in 2023" is
+     *                      {White = X}, {Black = X, alternative},
+     *                      {Date in range}. A game which doesn't have the
+     *                      tag doesn't satisfy the predicate. The index file
+     *                      (poIndexFile) isn't loaded if the filter is given.
      * @return On success it returns an instance of IParser. Otherwise it
      * returns NULL. */
-    static IParser* create(char const* pgnfile, bool isStrict = false);
+    static IParser* create(char const* pgnfile, bool isStrict = false,
+        unsigned options = poDefault, tag_predicate_t const* filter = NULL);
 
     /**
      * Create an instance of IParser (factory method).
@@ -103,9 +211,12 @@ public:
      *                      true from IErrorHandlerCallback::operator(...). In
      *                      this case parser will fix the problem and continue
      *                      parsing.
+     * @param [in] options  combination of parser_option_t values.
+     * @param [in] filter   predicates on tags (see above).
      * @return On success it returns an instance of IParser. Otherwise it
      * returns NULL. */
-    static IParser* create(wchar_t const* pgnfile, bool isStrict = false);
+    static IParser* create(wchar_t const* pgnfile, bool isStrict = false,
+        unsigned options = poDefault, tag_predicate_t const* filter = NULL);
 
     /**
      * Validate a game. Usually the method should be called after readGame()
@@ -157,8 +268,152 @@ public:
      *
      * Note: On syntax error IErrorHandlerCallback is called and
      * dummy instance of IGame is returned. Use isGameValid() method for
-     * checking return value. */
+     * checking return value.
+     *
+     * Note: Only tag pair section of the game is parsed by the method.
+     * Movetext section is parsed on the first call of a method which needs
+     * it (getMove(), getMoveCount(), getVariationCount(), getMoveText(),
+     * getResult() or isGameValid()), its syntax errors are reported at the
+     * moment. Thus the returned game is changed by const methods and it
+     * must not be shared between threads without synchronization (see
+     * IGame). */
     virtual IGame const* readGame(unsigned gameN = NEXT_ITEM) = 0;
+
+    /**
+     * Read several consecutive games at once. It is faster than readGame()
+     * for many small games: the index is locked once and data of the games
+     * is read ahead while they are parsed.
+     *
+     * @param [in] firstGame    number of the first game (from 1 to N). If
+     *                          the parameter is NEXT_ITEM then games are read
+     *                          from the next game like readGame() does. After
+     *                          the call readGame(NEXT_ITEM) returns the game
+     *                          which follows the last requested game.
+     * @param [in] count        number of games to read.
+     * @param [out] games       array for count games. The caller is owner of
+     *                          the games which are returned.
+     *
+     * @return Number of games which were put into the array. It is less than
+     * count if the file ends before the last requested game.
+     *
+     * Note: Like readGame() the method parses tag pair sections only, thus
+     * each game must be used by one thread at a time. */
+    virtual unsigned readGames(unsigned firstGame, unsigned count,
+        IGame const** games) = 0;
+
+    /**
+     * Ask the OS to read data of consecutive games ahead in background. The
+     * method returns immediately, thus the data is paged in while the
+     * caller processes other games (see GameRange). Games which aren't
+     * found by lightweight parsing yet are ignored.
+     * @param [in] firstGame    number of the first game (from 1 to N).
+     * @param [in] count        number of games. */
+    virtual void prefetchGames(unsigned firstGame, unsigned count) = 0;
+
+    /**
+     * Parse N-th game and pass its elements to the visitor (see
+     * IGameVisitor). It is faster than readGame() if elements of the game
+     * are needed once: nothing is copied and no objects are created.
+     *
+     * @param [in] visitor  visitor of the game.
+     * @param [in] gameN    number of game (from 1 to N) or NEXT_ITEM like
+     *                      readGame() has.
+     *
+     * @return If there is no game with given number the method returns
+     * false. Otherwise it returns true.
+     *
+     * Note: On syntax error IErrorHandlerCallback and
+     * IGameVisitor::onSyntaxError(...) are called. */
+    virtual bool visitGame(IGameVisitor& visitor,
+        unsigned gameN = NEXT_ITEM) = 0;
+
+    /**
+     * Check the PGN file for modifications. It is useful for files which
+     * grow over time (e.g. live broadcast of a tournament). If new games were
+     * appended to the file, then only new data will be parsed (on demand) and
+     * numbers of already read games stay the same. If the file was rewritten
+     * then it will be parsed from the beginning.
+     *
+     * @return The method returns true if the file wasn't changed or new data
+     * was appended to it. Otherwise (the file was rewritten or it can't be
+     * accessed) it returns false. */
+    virtual bool refresh() = 0;
+
+    /**
+     * Limit the address space which is used for mapping of the PGN file into
+     * memory. The file is mapped by windows on demand, thus it can be much
+     * larger than the limit. By default the limit is 1 Gb (256 Mb for 32-bit
+     * platforms).
+     *
+     * @param [in] size     maximum size of mapped windows in bytes. The limit
+     * can be exceeded temporarily by a game which is larger than it. Games
+     * which are alive keep their windows mapped, such windows are counted in
+     * the limit and other windows are unmapped instead. Thus the limit is
+     * exceeded only while alive games hold more than it. */
+    virtual void setMappedSizeLimit(unsigned long long size) = 0;
+
+    /**
+     * Get progress of lightweight parsing. It is useful with poAsyncIndexing
+     * option, but the method can be called in any mode.
+     *
+     * @param [out] scannedSize number of bytes of the PGN file which were
+     *                          scanned.
+     * @param [out] fileSize    size of the PGN file in bytes.
+     * @param [out] gameCount   number of games which were found. */
+    virtual void getIndexingProgress(unsigned long long& scannedSize,
+        unsigned long long& fileSize, unsigned& gameCount) const = 0;
+
+    /**
+     * Stop the background thread of lightweight parsing (see
+     * poAsyncIndexing). The method returns when the thread is stopped. After
+     * that games are found on demand like without the option. */
+    virtual void cancelIndexing() = 0;
+
+    /**
+     * Set a handler for getting notifications about modifications of the
+     * PGN file (see poWatchFile option). If you want to reset callback just
+     * call setFileChangeHandler(NULL).
+     * @param [in] callback is file change handler callback. */
+    virtual void setFileChangeHandler(IFileChangeCallback* callback) = 0;
+
+    /**
+     * Set parts of games which are needed by the caller. Other parts are
+     * skipped by the parser as fast as possible (e.g. if moves aren't
+     * needed then they aren't resolved on the board, variations are
+     * skipped without tokenizing) and they are absent in IGame. By default
+     * games are parsed completely.
+     *
+     * @param [in] tagNames NULL-terminated array of names of tags which are
+     *                      kept. If it is NULL then all tags are kept.
+     *                      Result tag is kept anyway, FEN and SetUp tags are
+     *                      kept if moves are needed.
+     * @param [in] parts    combination of game_part_t values. Variations,
+     *                      comments and NAGs require gpMoves.
+     *
+     * Note: The projection is applied to games which are read after the
+     * call (readGame(), readGames() and IParallelParser). It can be changed
+     * while games are read by other threads: a game is parsed with the
+     * projection which was set when the game was read, including its
+     * movetext which is parsed later. Syntax errors of skipped parts aren't
+     * reported. */
+    virtual void setProjection(char const* const* tagNames,
+        unsigned parts = gpAll) = 0;
+
+    /**
+     * Get number of games which satisfy the filter (see create(...)). The
+     * method waits until lightweight parsing is done. If there is no filter
+     * then all games are selected.
+     * @return Number of selected games. */
+    virtual unsigned getSelectedGameCount() const = 0;
+
+    /**
+     * Get number of a selected game in the file. Selected games are in
+     * order of the file.
+     * @param [in] n        number of the selected game from 1 till N (see
+     *                      getSelectedGameCount()).
+     * @return Number of the game for readGame(...), readGames(...) or
+     * visitGame(...), or 0 if there is no such selected game. */
+    virtual unsigned getSelectedGame(unsigned n) const = 0;
 };
 
 } /* namespace pgn */
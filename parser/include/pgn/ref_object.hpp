@@ -25,22 +25,26 @@
 namespace pgn
 {
 
+/**
+ * Base interface of reference counting objects. Methods are const, thus
+ * objects which are returned by const pointers (e.g. IGame const*) can be
+ * released and used with boost::intrusive_ptr too. */
 class PGN_LIB_API IRefObject
 {
 public:
-    virtual unsigned addRef() = 0;
-    virtual unsigned release() = 0;
+    virtual unsigned addRef() const = 0;
+    virtual unsigned release() const = 0;
 
 protected:
     virtual ~IRefObject() {}
 };
 
-void intrusive_ptr_add_ref(IRefObject* object)
+inline void intrusive_ptr_add_ref(IRefObject const* object)
 {
     object->addRef();
 }
 
-void intrusive_ptr_release(IRefObject* object)
+inline void intrusive_ptr_release(IRefObject const* object)
 {
     object->release();
 }
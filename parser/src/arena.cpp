@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace pgn
+{
+
+const std::size_t Arena::INITIAL_BLOCK_SIZE;
+const std::size_t Arena::MAX_BLOCK_SIZE;
+
+char* Arena::copyString(char const* data, std::size_t length)
+{
+    char* const copy = allocate<char>(length + 1);
+    std::memcpy(copy, data, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void Arena::reset()
+{
+    if ( m_blocks == NULL )
+    {
+        m_current = m_initialBlock.data;
+        return ;
+    }
+
+    /* Blocks grow, thus the last allocated block is the largest one. */
+    Block* const block = m_blocks;
+    releaseBlocks(block);
+    m_current = getBlockData(block);
+    m_end = m_current + block->size;
+}
+
+void* Arena::allocateInNewBlock(std::size_t size, std::size_t alignment)
+{
+    /* Large objects get a block of their size. */
+    std::size_t const blockSize = std::max(m_nextBlockSize,
+        size + alignment);
+    Block* const block = static_cast<Block*>(
+        std::malloc(sizeof(Block) + blockSize));
+    if ( block == NULL )
+    {
+        throw std::bad_alloc();
+    }
+
+    block->next = m_blocks;
+    block->size = blockSize;
+    m_blocks = block;
+    m_nextBlockSize = std::min(m_nextBlockSize * 2, MAX_BLOCK_SIZE);
+
+    m_current = getBlockData(block);
+    m_end = m_current + blockSize;
+    return allocate(size, alignment);
+}
+
+/* All blocks except keptBlock are released. */
+void Arena::releaseBlocks(Block* keptBlock)
+{
+    Block* block = m_blocks;
+    while ( block != NULL )
+    {
+        Block* const next = block->next;
+        if ( block != keptBlock )
+        {
+            std::free(block);
+        }
+        block = next;
+    }
+
+    m_blocks = keptBlock;
+    if ( keptBlock != NULL )
+    {
+        keptBlock->next = NULL;
+    }
+}
+
+} /* namespace pgn */
@@ -0,0 +1,175 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_ARENA_HPP
+#define PGN_ARENA_HPP
+
+#include <cstddef>
+#include <new>
+
+#include <boost/type_traits/alignment_of.hpp>
+
+namespace pgn
+{
+
+/* Bump-pointer allocator. Memory is released all at once when the arena is
+ * destroyed or reset. Objects in the arena are never destroyed, thus they
+ * should not own any other resources. The first block is inside the arena,
+ * thus small games don't allocate memory at all. Blocks grow geometrically
+ * up to MAX_BLOCK_SIZE. */
+class Arena
+{
+public:
+    static const std::size_t INITIAL_BLOCK_SIZE = 2048;
+    static const std::size_t MAX_BLOCK_SIZE = 64 * 1024;
+
+    Arena() : m_blocks(NULL), m_current(m_initialBlock.data),
+        m_end(m_initialBlock.data + INITIAL_BLOCK_SIZE),
+        m_nextBlockSize(INITIAL_BLOCK_SIZE * 2) {}
+    ~Arena() { releaseBlocks(NULL); }
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        char* const data = align(m_current, alignment);
+        if ( data > m_end || size > static_cast<std::size_t>(m_end - data) )
+        {
+            return allocateInNewBlock(size, alignment);
+        }
+
+        m_current = data + size;
+        return data;
+    }
+
+    template <typename T> T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count,
+            boost::alignment_of<T>::value));
+    }
+
+    /* Copy a string into the arena. The copy is null-terminated. */
+    char* copyString(char const* data, std::size_t length);
+
+    /* Release all objects. The largest block is kept for next objects. */
+    void reset();
+
+private:
+    Arena(Arena const& ); /* without implementation */
+    Arena& operator=(Arena const& ); /* without implementation */
+
+    struct Block
+    {
+        Block* next;
+        std::size_t size; /* size of data after the header */
+    };
+
+    static char* align(char* data, std::size_t alignment)
+    {
+        std::size_t const misalignment =
+            reinterpret_cast<std::size_t>(data) % alignment;
+        return misalignment == 0 ? data : data + ( alignment - misalignment );
+    }
+
+    static char* getBlockData(Block* block)
+    {
+        return reinterpret_cast<char*>(block) + sizeof(Block);
+    }
+
+    void* allocateInNewBlock(std::size_t size, std::size_t alignment);
+    void releaseBlocks(Block* keptBlock);
+
+    Block* m_blocks; /* the last allocated block is the first */
+    char* m_current; /* the next free byte of the current block */
+    char* m_end; /* the end of the current block */
+    std::size_t m_nextBlockSize;
+    union
+    {
+        char data[INITIAL_BLOCK_SIZE];
+        double alignment; /* the block is aligned as any scalar type */
+        void* pointerAlignment;
+    } m_initialBlock;
+};
+
+/* Growable array in an arena. On growth elements are copied into a new
+ * array, the old one is wasted until the arena is released (it is no more
+ * than size of the array). The arena isn't stored inside to keep the array
+ * small. Elements are never destroyed. */
+template <typename T>
+class ArenaVector
+{
+public:
+    ArenaVector() : m_data(NULL), m_size(0), m_capacity(0) {}
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T& operator[](std::size_t index) { return m_data[index]; }
+    T const& operator[](std::size_t index) const { return m_data[index]; }
+    T& back() { return m_data[m_size - 1]; }
+    T const& back() const { return m_data[m_size - 1]; }
+    T const* data() const { return m_data; }
+
+    void push_back(T const& value, Arena& arena)
+    {
+        if ( m_size == m_capacity )
+        {
+            grow(arena);
+        }
+
+        new (m_data + m_size) T(value);
+        ++m_size;
+    }
+
+    /* Capacity is kept. */
+    void clear() { m_size = 0; }
+
+    /* Allocate space for the elements at once if their number is known. */
+    void reserve(std::size_t capacity, Arena& arena)
+    {
+        if ( capacity > m_capacity )
+        {
+            grow(capacity, arena);
+        }
+    }
+
+private:
+    void grow(Arena& arena)
+    {
+        grow(( m_capacity == 0 ) ? 4 : m_capacity * 2, arena);
+    }
+
+    void grow(std::size_t capacity, Arena& arena)
+    {
+        T* const data = arena.allocate<T>(capacity);
+        for ( std::size_t i = 0; i < m_size; ++i )
+        {
+            new (data + i) T(m_data[i]);
+        }
+
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    T* m_data;
+    std::size_t m_size;
+    std::size_t m_capacity;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_ARENA_HPP */
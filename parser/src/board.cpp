@@ -0,0 +1,777 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "board.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace pgn
+{
+
+namespace
+{
+
+struct Direction
+{
+    int file;
+    int rank;
+};
+
+const Direction KNIGHT_JUMPS[] =
+{
+    { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 },
+    { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 }
+};
+
+const Direction KING_STEPS[] =
+{
+    { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 },
+    { 1, 1 }, { 1, -1 }, { -1, -1 }, { -1, 1 }
+};
+
+char const PIECE_LETTERS[] = " PNBRQK";
+
+inline int getFile(int square)
+{
+    return square & 7;
+}
+
+inline int getRank(int square)
+{
+    return square >> 3;
+}
+
+inline int makeSquare(int file, int rank)
+{
+    return rank * 8 + file;
+}
+
+/* The method returns -1 if the square is outside of the board. */
+inline int shift(int square, Direction const& direction)
+{
+    int const file = getFile(square) + direction.file;
+    int const rank = getRank(square) + direction.rank;
+    return ( file >= 0 && file < 8 && rank >= 0 && rank < 8 ) ?
+        makeSquare(file, rank) : -1;
+}
+
+/* Squares which are on the same line or diagonal. */
+inline bool isAligned(int first, int second)
+{
+    int const files = std::abs(getFile(first) - getFile(second));
+    int const ranks = std::abs(getRank(first) - getRank(second));
+    return files == 0 || ranks == 0 || files == ranks;
+}
+
+/* Neighbours of each square are precomputed (-1 is outside of the board).
+ * Rooks use the first half of KING_STEPS, bishops use the second half. */
+class Geometry
+{
+public:
+    Geometry()
+    {
+        for ( int square = 0; square < 64; ++square )
+        {
+            for ( int i = 0; i < 8; ++i )
+            {
+                m_steps[square][i] = static_cast<signed char>(
+                    shift(square, KING_STEPS[i]));
+                m_jumps[square][i] = static_cast<signed char>(
+                    shift(square, KNIGHT_JUMPS[i]));
+            }
+        }
+    }
+
+    int step(int square, int direction) const
+    {
+        return m_steps[square][direction];
+    }
+    int jump(int square, int n) const { return m_jumps[square][n]; }
+
+private:
+    signed char m_steps[64][8];
+    signed char m_jumps[64][8];
+};
+
+/* It is initialized before main(), thus there is no race between threads. */
+const Geometry GEOMETRY;
+
+inline packed_move_t packMove(int from, int to, piece_t promotion = pcNone)
+{
+    packed_move_t move = static_cast<packed_move_t>(from | ( to << 6 ));
+    if ( promotion != pcNone )
+    {
+        move |= static_cast<packed_move_t>(0x4000 |
+            ( ( promotion - pcKnight ) << 12 ));
+    }
+
+    return move;
+}
+
+inline int getFrom(packed_move_t move)
+{
+    return move & 0x3f;
+}
+
+inline int getTo(packed_move_t move)
+{
+    return ( move >> 6 ) & 0x3f;
+}
+
+inline piece_t getPromotion(packed_move_t move)
+{
+    return ( move & 0x4000 ) != 0 ?
+        static_cast<piece_t>(pcKnight + ( ( move >> 12 ) & 0x03 )) : pcNone;
+}
+
+piece_t toPiece(char c)
+{
+    char const* const letter = std::strchr(PIECE_LETTERS + 1, c);
+    return ( c != '\0' && letter != NULL ) ?
+        static_cast<piece_t>(letter - PIECE_LETTERS) : pcNone;
+}
+
+} /* unnamed namespace */
+
+const std::size_t Board::MAX_SAN_LENGTH;
+const unsigned char Board::BLACK;
+
+Board::Board() : m_sideToMove(0), m_castlingRights(crWhiteKingside |
+    crWhiteQueenside | crBlackKingside | crBlackQueenside), m_enPassant(-1)
+{
+    piece_t const pieces[] = { pcRook, pcKnight, pcBishop, pcQueen, pcKing,
+        pcBishop, pcKnight, pcRook };
+    std::memset(m_squares, pcNone, sizeof(m_squares));
+    for ( int file = 0; file < 8; ++file )
+    {
+        m_squares[makeSquare(file, 0)] = pieces[file];
+        m_squares[makeSquare(file, 1)] = pcPawn;
+        m_squares[makeSquare(file, 6)] = pcPawn | BLACK;
+        m_squares[makeSquare(file, 7)] = pieces[file] | BLACK;
+    }
+    m_kings[0] = makeSquare(4, 0);
+    m_kings[1] = makeSquare(4, 7);
+}
+
+bool Board::setFEN(char const* fen)
+{
+    std::memset(m_squares, pcNone, sizeof(m_squares));
+    m_kings[0] = m_kings[1] = -1;
+    m_sideToMove = 0;
+    m_castlingRights = 0;
+    m_enPassant = -1;
+
+    /* Piece placement from the eighth rank. */
+    char const* c = fen;
+    int rank = 7;
+    int file = 0;
+    for ( ; *c != ' ' && *c != '\0'; ++c )
+    {
+        if ( *c == '/' )
+        {
+            if ( file != 8 || rank == 0 )
+            {
+                return false;
+            }
+            --rank;
+            file = 0;
+        } else if ( *c >= '1' && *c <= '8' )
+        {
+            file += *c - '0';
+            if ( file > 8 )
+            {
+                return false;
+            }
+        } else
+        {
+            bool const isBlack = ( *c >= 'a' && *c <= 'z' );
+            piece_t const piece = toPiece(isBlack ? *c - 'a' + 'A' : *c);
+            if ( piece == pcNone || file == 8 )
+            {
+                return false;
+            }
+
+            int const square = makeSquare(file++, rank);
+            m_squares[square] = piece | ( isBlack ? BLACK : 0 );
+            if ( piece == pcKing )
+            {
+                if ( m_kings[isBlack] >= 0 )
+                {
+                    return false;
+                }
+                m_kings[isBlack] = square;
+            }
+        }
+    }
+
+    if ( rank != 0 || file != 8 || m_kings[0] < 0 || m_kings[1] < 0 )
+    {
+        return false;
+    }
+
+    /* Active color. Other fields can be omitted. */
+    while ( *c == ' ' )
+    {
+        ++c;
+    }
+    if ( *c != 'w' && *c != 'b' )
+    {
+        return false;
+    }
+    m_sideToMove = ( *c++ == 'b' ) ? 1 : 0;
+
+    while ( *c == ' ' )
+    {
+        ++c;
+    }
+    for ( ; *c != ' ' && *c != '\0'; ++c )
+    {
+        switch ( *c )
+        {
+        case 'K':
+            m_castlingRights |= crWhiteKingside;
+            break;
+        case 'Q':
+            m_castlingRights |= crWhiteQueenside;
+            break;
+        case 'k':
+            m_castlingRights |= crBlackKingside;
+            break;
+        case 'q':
+            m_castlingRights |= crBlackQueenside;
+            break;
+        case '-':
+            break;
+        default:
+            /* Castling of Chess960 isn't supported. */
+            return false;
+        }
+    }
+
+    while ( *c == ' ' )
+    {
+        ++c;
+    }
+    if ( *c >= 'a' && *c <= 'h' && ( c[1] == '3' || c[1] == '6' ) )
+    {
+        m_enPassant = makeSquare(*c - 'a', c[1] - '1');
+    }
+
+    return true;
+}
+
+bool Board::findMove(char const* san, std::size_t length,
+    packed_move_t& move) const
+{
+    while ( length != 0 && ( san[length - 1] == '+' ||
+        san[length - 1] == '#' ) )
+    {
+        --length;
+    }
+
+    if ( length != 0 && ( san[0] == 'O' || san[0] == '0' ) )
+    {
+        /* O-O or O-O-O */
+        for ( std::size_t i = 0; i < length; ++i )
+        {
+            if ( san[i] != ( i % 2 == 0 ? san[0] : '-' ) )
+            {
+                return false;
+            }
+        }
+        return ( length == 3 || length == 5 ) &&
+            findCastling(length == 3, move);
+    }
+
+    std::size_t first = 0;
+    piece_t piece = pcPawn;
+    if ( length != 0 && toPiece(san[0]) > pcPawn )
+    {
+        piece = toPiece(san[0]);
+        first = 1;
+    }
+
+    piece_t promotion = pcNone;
+    if ( piece == pcPawn && length > 2 && toPiece(san[length - 1]) > pcPawn &&
+        toPiece(san[length - 1]) < pcKing )
+    {
+        promotion = toPiece(san[length - 1]);
+        length -= ( san[length - 2] == '=' ) ? 2 : 1;
+    }
+
+    if ( length < first + 2 || san[length - 2] < 'a' ||
+        san[length - 2] > 'h' || san[length - 1] < '1' ||
+        san[length - 1] > '8' )
+    {
+        return false;
+    }
+    int const target = makeSquare(san[length - 2] - 'a',
+        san[length - 1] - '1');
+
+    /* Disambiguation and capture. */
+    int fromFile = -1;
+    int fromRank = -1;
+    for ( std::size_t i = first; i + 2 < length; ++i )
+    {
+        if ( san[i] >= 'a' && san[i] <= 'h' && fromFile < 0 &&
+            fromRank < 0 )
+        {
+            fromFile = san[i] - 'a';
+        } else if ( san[i] >= '1' && san[i] <= '8' && fromRank < 0 )
+        {
+            fromRank = san[i] - '1';
+        } else if ( san[i] != 'x' && san[i] != ':' )
+        {
+            return false;
+        }
+    }
+
+    if ( piece == pcPawn )
+    {
+        return fromRank < 0 && findPawnMove(fromFile, target, promotion,
+            move);
+    }
+
+    if ( isOwn(target, m_sideToMove) )
+    {
+        return false;
+    }
+
+    int squares[16];
+    std::size_t const count = findAttackers(target, m_sideToMove, piece,
+        squares);
+    bool isFound = false;
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        if ( ( fromFile >= 0 && getFile(squares[i]) != fromFile ) ||
+            ( fromRank >= 0 && getRank(squares[i]) != fromRank ) )
+        {
+            continue;
+        }
+
+        packed_move_t const candidate = packMove(squares[i], target);
+        if ( isLegal(candidate) )
+        {
+            if ( isFound )
+            {
+                /* The move is ambiguous. */
+                return false;
+            }
+            move = candidate;
+            isFound = true;
+        }
+    }
+
+    return isFound;
+}
+
+void Board::makeMove(packed_move_t move)
+{
+    /* Castling rights which are kept after a move from or to the square. */
+    static unsigned char const castlingMasks[64] =
+    {
+        0x0d, 0x0f, 0x0f, 0x0f, 0x0c, 0x0f, 0x0f, 0x0e,
+        0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+        0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+        0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+        0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+        0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+        0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+        0x07, 0x0f, 0x0f, 0x0f, 0x03, 0x0f, 0x0f, 0x0b
+    };
+
+    int const from = getFrom(move);
+    int const to = getTo(move);
+    unsigned char const moving = m_squares[from];
+    piece_t const piece = getPiece(from);
+    if ( piece == pcPawn && to == m_enPassant &&
+        getFile(from) != getFile(to) )
+    {
+        /* En passant capture. */
+        m_squares[makeSquare(getFile(to), getRank(from))] = pcNone;
+    } else if ( piece == pcKing )
+    {
+        m_kings[m_sideToMove] = to;
+        if ( std::abs(getFile(to) - getFile(from)) == 2 )
+        {
+            /* Castling, the rook jumps over the king. */
+            bool const isKingside = getFile(to) > getFile(from);
+            int const rook = makeSquare(isKingside ? 7 : 0, getRank(from));
+            m_squares[makeSquare(isKingside ? 5 : 3, getRank(from))] =
+                m_squares[rook];
+            m_squares[rook] = pcNone;
+        }
+    }
+
+    piece_t const promotion = getPromotion(move);
+    m_squares[to] = ( promotion != pcNone ) ?
+        static_cast<unsigned char>(promotion | ( moving & BLACK )) : moving;
+    m_squares[from] = pcNone;
+    m_enPassant = ( piece == pcPawn &&
+        std::abs(getRank(to) - getRank(from)) == 2 ) ?
+        ( from + to ) / 2 : -1;
+    m_castlingRights &= castlingMasks[from] & castlingMasks[to];
+    m_sideToMove ^= 1;
+}
+
+std::size_t Board::writeSAN(packed_move_t move, char* san) const
+{
+    int const from = getFrom(move);
+    int const to = getTo(move);
+    piece_t const piece = getPiece(from);
+    char* c = san;
+    if ( piece == pcKing && std::abs(getFile(to) - getFile(from)) == 2 )
+    {
+        char const* const castling = getFile(to) > getFile(from) ?
+            "O-O" : "O-O-O";
+        std::strcpy(c, castling);
+        c += std::strlen(castling);
+    } else if ( piece == pcPawn )
+    {
+        if ( getFile(from) != getFile(to) )
+        {
+            *c++ = static_cast<char>('a' + getFile(from));
+            *c++ = 'x';
+        }
+        *c++ = static_cast<char>('a' + getFile(to));
+        *c++ = static_cast<char>('1' + getRank(to));
+        if ( getPromotion(move) != pcNone )
+        {
+            *c++ = '=';
+            *c++ = PIECE_LETTERS[getPromotion(move)];
+        }
+    } else
+    {
+        *c++ = PIECE_LETTERS[piece];
+
+        /* The file is preferred for disambiguation, then the rank. */
+        int squares[16];
+        std::size_t const count = findAttackers(to, m_sideToMove, piece,
+            squares);
+        bool isAmbiguous = false;
+        bool isSameFile = false;
+        bool isSameRank = false;
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            if ( squares[i] != from && isLegal(packMove(squares[i], to)) )
+            {
+                isAmbiguous = true;
+                isSameFile |= ( getFile(squares[i]) == getFile(from) );
+                isSameRank |= ( getRank(squares[i]) == getRank(from) );
+            }
+        }
+        if ( isAmbiguous && ( !isSameFile || isSameRank ) )
+        {
+            *c++ = static_cast<char>('a' + getFile(from));
+        }
+        if ( isAmbiguous && isSameFile )
+        {
+            *c++ = static_cast<char>('1' + getRank(from));
+        }
+
+        if ( m_squares[to] != pcNone )
+        {
+            *c++ = 'x';
+        }
+        *c++ = static_cast<char>('a' + getFile(to));
+        *c++ = static_cast<char>('1' + getRank(to));
+    }
+
+    Board next(*this);
+    next.makeMove(move);
+    if ( next.isAttacked(next.m_kings[next.m_sideToMove], m_sideToMove) )
+    {
+        *c++ = next.hasLegalMove() ? '+' : '#';
+    }
+
+    *c = '\0';
+    return c - san;
+}
+
+std::size_t Board::findAttackers(int target, unsigned color, piece_t piece,
+    int* squares) const
+{
+    unsigned char const attacker = piece | ( color != 0 ? BLACK : 0 );
+    std::size_t count = 0;
+    if ( piece == pcKnight || piece == pcKing )
+    {
+        for ( int i = 0; i < 8; ++i )
+        {
+            int const square = ( piece == pcKnight ) ?
+                GEOMETRY.jump(target, i) : GEOMETRY.step(target, i);
+            if ( square >= 0 && m_squares[square] == attacker )
+            {
+                squares[count++] = square;
+            }
+        }
+        return count;
+    }
+
+    /* Sliding pieces. */
+    int const firstDirection = ( piece == pcBishop ) ? 4 : 0;
+    int const lastDirection = ( piece == pcRook ) ? 4 : 8;
+    for ( int i = firstDirection; i < lastDirection; ++i )
+    {
+        int square = target;
+        while ( ( square = GEOMETRY.step(square, i) ) >= 0 )
+        {
+            if ( m_squares[square] != pcNone )
+            {
+                if ( m_squares[square] == attacker )
+                {
+                    squares[count++] = square;
+                }
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+bool Board::isAttacked(int square, unsigned color) const
+{
+    unsigned char const colorBit = ( color != 0 ) ? BLACK : 0;
+    for ( int i = 0; i < 8; ++i )
+    {
+        int const knight = GEOMETRY.jump(square, i);
+        int const king = GEOMETRY.step(square, i);
+        if ( ( knight >= 0 && m_squares[knight] == ( pcKnight | colorBit ) ) ||
+            ( king >= 0 && m_squares[king] == ( pcKing | colorBit ) ) )
+        {
+            return true;
+        }
+    }
+
+    for ( int i = 0; i < 8; ++i )
+    {
+        /* Rooks and queens on lines, bishops and queens on diagonals. */
+        unsigned char const slider = ( ( i < 4 ) ? pcRook : pcBishop ) |
+            colorBit;
+        int attacker = square;
+        while ( ( attacker = GEOMETRY.step(attacker, i) ) >= 0 )
+        {
+            if ( m_squares[attacker] != pcNone )
+            {
+                if ( m_squares[attacker] == slider ||
+                    m_squares[attacker] == ( pcQueen | colorBit ) )
+                {
+                    return true;
+                }
+                break;
+            }
+        }
+    }
+
+    /* Pawns attack forward, thus they are behind the square diagonally
+     * (see KING_STEPS). */
+    int const first = ( color != 0 ) ? 4 : 5;
+    int const second = ( color != 0 ) ? 7 : 6;
+    int const left = GEOMETRY.step(square, first);
+    int const right = GEOMETRY.step(square, second);
+    return ( left >= 0 && m_squares[left] == ( pcPawn | colorBit ) ) ||
+        ( right >= 0 && m_squares[right] == ( pcPawn | colorBit ) );
+}
+
+bool Board::isLegal(packed_move_t move) const
+{
+    /* A piece which isn't on a line with its king can't open the king,
+     * thus such a move is legal if the king isn't in check. En passant
+     * capture removes another pawn. */
+    int const from = getFrom(move);
+    int const king = m_kings[m_sideToMove];
+    if ( from != king && !isAligned(from, king) &&
+        !( getPiece(from) == pcPawn && getTo(move) == m_enPassant ) &&
+        !isAttacked(king, m_sideToMove ^ 1) )
+    {
+        return true;
+    }
+
+    Board next(*this);
+    next.makeMove(move);
+    return !next.isAttacked(next.m_kings[m_sideToMove], next.m_sideToMove);
+}
+
+bool Board::hasLegalMove() const
+{
+    int const forward = ( m_sideToMove == 0 ) ? 1 : -1;
+    for ( int from = 0; from < 64; ++from )
+    {
+        if ( !isOwn(from, m_sideToMove) )
+        {
+            continue;
+        }
+
+        /* Targets of the piece (without castling: if castling is legal,
+         * then the king can make a step too). */
+        int targets[32];
+        std::size_t count = 0;
+        piece_t const piece = getPiece(from);
+        if ( piece == pcPawn )
+        {
+            Direction const push = { 0, forward };
+            int const square = shift(from, push);
+            if ( square >= 0 && m_squares[square] == pcNone )
+            {
+                targets[count++] = square;
+                int const next = shift(square, push);
+                if ( getRank(from) == ( m_sideToMove == 0 ? 1 : 6 ) &&
+                    m_squares[next] == pcNone )
+                {
+                    targets[count++] = next;
+                }
+            }
+            for ( int side = -1; side <= 1; side += 2 )
+            {
+                Direction const capture = { side, forward };
+                int const target = shift(from, capture);
+                if ( target >= 0 && ( target == m_enPassant ||
+                    isOwn(target, m_sideToMove ^ 1) ) )
+                {
+                    targets[count++] = target;
+                }
+            }
+        } else if ( piece == pcKnight || piece == pcKing )
+        {
+            Direction const* const directions = ( piece == pcKnight ) ?
+                KNIGHT_JUMPS : KING_STEPS;
+            for ( int i = 0; i < 8; ++i )
+            {
+                int const target = shift(from, directions[i]);
+                if ( target >= 0 && !isOwn(target, m_sideToMove) )
+                {
+                    targets[count++] = target;
+                }
+            }
+        } else
+        {
+            int const firstDirection = ( piece == pcBishop ) ? 4 : 0;
+            int const lastDirection = ( piece == pcRook ) ? 4 : 8;
+            for ( int i = firstDirection; i < lastDirection; ++i )
+            {
+                int target = from;
+                while ( ( target = shift(target, KING_STEPS[i]) ) >= 0 &&
+                    !isOwn(target, m_sideToMove) )
+                {
+                    targets[count++] = target;
+                    if ( m_squares[target] != pcNone )
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+
+        for ( std::size_t i = 0; i < count; ++i )
+        {
+            if ( isLegal(packMove(from, targets[i])) )
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool Board::findCastling(bool isKingside, packed_move_t& move) const
+{
+    int const rank = ( m_sideToMove == 0 ) ? 0 : 7;
+    unsigned const right = ( m_sideToMove == 0 ) ?
+        ( isKingside ? crWhiteKingside : crWhiteQueenside ) :
+        ( isKingside ? crBlackKingside : crBlackQueenside );
+    int const king = makeSquare(4, rank);
+    if ( ( m_castlingRights & right ) == 0 || m_kings[m_sideToMove] != king ||
+        m_squares[makeSquare(isKingside ? 7 : 0, rank)] !=
+            ( pcRook | ( m_sideToMove != 0 ? BLACK : 0 ) ) )
+    {
+        return false;
+    }
+
+    /* Squares between the king and the rook are empty. The king isn't in
+     * check and it doesn't pass an attacked square. */
+    int const firstFile = isKingside ? 5 : 1;
+    int const lastFile = isKingside ? 6 : 3;
+    for ( int file = firstFile; file <= lastFile; ++file )
+    {
+        if ( m_squares[makeSquare(file, rank)] != pcNone )
+        {
+            return false;
+        }
+    }
+
+    if ( isAttacked(king, m_sideToMove ^ 1) ||
+        isAttacked(makeSquare(isKingside ? 5 : 3, rank), m_sideToMove ^ 1) )
+    {
+        return false;
+    }
+
+    move = packMove(king, makeSquare(isKingside ? 6 : 2, rank));
+    return isLegal(move);
+}
+
+bool Board::findPawnMove(int fromFile, int target, piece_t promotion,
+    packed_move_t& move) const
+{
+    int const forward = ( m_sideToMove == 0 ) ? 1 : -1;
+    int const fromRank = getRank(target) - forward;
+    bool const isLastRank = getRank(target) == ( m_sideToMove == 0 ? 7 : 0 );
+    unsigned char const pawn = pcPawn | ( m_sideToMove != 0 ? BLACK : 0 );
+    if ( isLastRank != ( promotion != pcNone ) || fromRank < 0 ||
+        fromRank > 7 )
+    {
+        return false;
+    }
+
+    int from = -1;
+    if ( fromFile >= 0 && fromFile != getFile(target) )
+    {
+        /* Capture (the file of the pawn is always given). */
+        from = makeSquare(fromFile, fromRank);
+        if ( std::abs(fromFile - getFile(target)) != 1 ||
+            m_squares[from] != pawn || !( target == m_enPassant ||
+                isOwn(target, m_sideToMove ^ 1) ) )
+        {
+            return false;
+        }
+    } else
+    {
+        /* Push by one or two squares. */
+        from = makeSquare(getFile(target), fromRank);
+        if ( m_squares[target] != pcNone )
+        {
+            return false;
+        }
+        if ( m_squares[from] == pcNone &&
+            fromRank == ( m_sideToMove == 0 ? 2 : 5 ) )
+        {
+            from -= 8 * forward;
+        }
+        if ( m_squares[from] != pawn )
+        {
+            return false;
+        }
+    }
+
+    move = packMove(from, target, promotion);
+    return isLegal(move);
+}
+
+} /* namespace pgn */
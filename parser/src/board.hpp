@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_BOARD_HPP
+#define PGN_BOARD_HPP
+
+#include <cstddef>
+
+namespace pgn
+{
+
+/* A move which is packed into 16 bits: the source square (bits 0-5), the
+ * target square (bits 6-11), the promotion piece (bits 12-13: knight,
+ * bishop, rook or queen) and the promotion flag (bit 14). Squares are
+ * numbered from a1 (0) to h8 (63) rank by rank. Castling is a move of the
+ * king by two files. Thus a move is interpreted in its position only. */
+typedef unsigned short packed_move_t;
+
+/* It isn't a move (the source and target squares are the same). */
+const packed_move_t NULL_MOVE = 0;
+
+typedef enum
+{
+    pcNone,
+    pcPawn,
+    pcKnight,
+    pcBishop,
+    pcRook,
+    pcQueen,
+    pcKing
+} piece_t;
+
+/* Position of a chess game. It is used for resolving of SAN into packed
+ * moves and back. Only legal moves are accepted. */
+class Board
+{
+public:
+    /* "Qa1xb2#", a buffer for SAN should be one character longer. */
+    static const std::size_t MAX_SAN_LENGTH = 7;
+
+    /* The standard starting position. */
+    Board();
+
+    /* Set the position from FEN. Move counters are ignored. On error the
+     * method returns false and the position is undefined. */
+    bool setFEN(char const* fen);
+
+    /* Find the legal move which is written in SAN (check and mate
+     * indicators are optional, castling can be written with zeros). The
+     * method returns false if there is no such move or it is ambiguous. */
+    bool findMove(char const* san, std::size_t length,
+        packed_move_t& move) const;
+
+    /* 0 if white is to move, 1 if black is to move. */
+    unsigned getSideToMove() const { return m_sideToMove; }
+
+    /* Play a move which was found by findMove(). */
+    void makeMove(packed_move_t move);
+
+    /* Write SAN of a legal move with check or mate indicator. The method
+     * returns length of the null-terminated string. */
+    std::size_t writeSAN(packed_move_t move, char* san) const;
+
+private:
+    static const unsigned char BLACK = 0x08; /* color bit of a square */
+
+    typedef enum
+    {
+        crWhiteKingside     = 0x01,
+        crWhiteQueenside    = 0x02,
+        crBlackKingside     = 0x04,
+        crBlackQueenside    = 0x08
+    } castling_right_t;
+
+    piece_t getPiece(int square) const
+    {
+        return static_cast<piece_t>(m_squares[square] & ~BLACK);
+    }
+    bool isOwn(int square, unsigned color) const
+    {
+        return m_squares[square] != pcNone &&
+            ( ( m_squares[square] & BLACK ) != 0 ) == ( color != 0 );
+    }
+
+    /* Squares of pieces of the color and type which attack the target
+     * square (moves of pawns aren't included). The method returns number of
+     * the squares. */
+    std::size_t findAttackers(int target, unsigned color, piece_t piece,
+        int* squares) const;
+    bool isAttacked(int square, unsigned color) const;
+    bool isLegal(packed_move_t move) const;
+    bool hasLegalMove() const;
+    bool findCastling(bool isKingside, packed_move_t& move) const;
+    bool findPawnMove(int fromFile, int target, piece_t promotion,
+        packed_move_t& move) const;
+
+    unsigned char m_squares[64]; /* piece_t and the color bit */
+    unsigned m_sideToMove; /* 0 is white, 1 is black */
+    unsigned m_castlingRights; /* combination of castling_right_t */
+    int m_enPassant; /* square behind a pawn which was moved by two squares
+                        (or -1) */
+    int m_kings[2]; /* squares of kings */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_BOARD_HPP */
@@ -0,0 +1,217 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_info.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace pgn
+{
+
+#ifdef _WIN32
+
+bool getFileInfo(std::string const& path, FileInfo& info)
+{
+    struct _stat64 st;
+    if ( _stat64(path.c_str(), &st) != 0 )
+    {
+        return false;
+    }
+
+    info.size = st.st_size;
+    info.modificationTime = st.st_mtime;
+    return true;
+}
+
+bool getFileInfo(std::wstring const& path, FileInfo& info)
+{
+    struct _stat64 st;
+    if ( _wstat64(path.c_str(), &st) != 0 )
+    {
+        return false;
+    }
+
+    info.size = st.st_size;
+    info.modificationTime = st.st_mtime;
+    return true;
+}
+
+std::FILE* openFile(std::wstring const& path, char const* mode)
+{
+    std::wstring const wmode(mode, mode + std::char_traits<char>::length(mode));
+    return _wfopen(path.c_str(), wmode.c_str());
+}
+
+/* Unlike POSIX rename() the function fails if the target exists. */
+bool renameFile(std::string const& from, std::string const& to)
+{
+    std::remove(to.c_str());
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool renameFile(std::wstring const& from, std::wstring const& to)
+{
+    _wremove(to.c_str());
+    return _wrename(from.c_str(), to.c_str()) == 0;
+}
+
+bool removeFile(std::wstring const& path)
+{
+    return _wremove(path.c_str()) == 0;
+}
+
+std::string toNativePath(std::wstring const& path)
+{
+    /* boost::iostreams accepts wide file names on the platform, thus the
+     * conversion is lossy and shouldn't be used for opening files. */
+    return std::string(path.begin(), path.end());
+}
+
+#else /* #ifdef _WIN32 */
+
+bool getFileInfo(std::string const& path, FileInfo& info)
+{
+    struct stat st;
+    if ( stat(path.c_str(), &st) != 0 )
+    {
+        return false;
+    }
+
+    info.size = st.st_size;
+#if defined(__linux__)
+    info.modificationTime = static_cast<long long>(st.st_mtim.tv_sec) *
+        1000000000LL + st.st_mtim.tv_nsec;
+#else
+    info.modificationTime = st.st_mtime;
+#endif
+    return true;
+}
+
+bool getFileInfo(std::wstring const& path, FileInfo& info)
+{
+    return getFileInfo(toNativePath(path), info);
+}
+
+std::FILE* openFile(std::wstring const& path, char const* mode)
+{
+    return openFile(toNativePath(path), mode);
+}
+
+bool renameFile(std::string const& from, std::string const& to)
+{
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+bool renameFile(std::wstring const& from, std::wstring const& to)
+{
+    return renameFile(toNativePath(from), toNativePath(to));
+}
+
+bool removeFile(std::wstring const& path)
+{
+    return removeFile(toNativePath(path));
+}
+
+std::string toNativePath(std::wstring const& path)
+{
+    std::size_t const length = std::wcstombs(NULL, path.c_str(), 0);
+    if ( length == static_cast<std::size_t>(-1) )
+    {
+        return std::string();
+    }
+
+    std::vector<char> buffer(length + 1);
+    std::wcstombs(&buffer[0], path.c_str(), buffer.size());
+    return std::string(&buffer[0], length);
+}
+
+#endif /* #ifdef _WIN32 */
+
+std::FILE* openFile(std::string const& path, char const* mode)
+{
+    return std::fopen(path.c_str(), mode);
+}
+
+bool removeFile(std::string const& path)
+{
+    return std::remove(path.c_str()) == 0;
+}
+
+FilePath FilePath::withSuffix(char const* suffix) const
+{
+    if ( m_isWide )
+    {
+        return FilePath(m_wpath + std::wstring(suffix,
+            suffix + std::char_traits<char>::length(suffix)));
+    }
+
+    return FilePath(m_path + suffix);
+}
+
+bool getFileInfo(FilePath const& path, FileInfo& info)
+{
+    return path.isWide() ? getFileInfo(path.getWidePath(), info) :
+        getFileInfo(path.getPath(), info);
+}
+
+std::FILE* openFile(FilePath const& path, char const* mode)
+{
+    return path.isWide() ? openFile(path.getWidePath(), mode) :
+        openFile(path.getPath(), mode);
+}
+
+bool renameFile(FilePath const& from, FilePath const& to)
+{
+    if ( from.isWide() != to.isWide() )
+    {
+        return false;
+    }
+
+    return from.isWide() ? renameFile(from.getWidePath(), to.getWidePath()) :
+        renameFile(from.getPath(), to.getPath());
+}
+
+bool removeFile(FilePath const& path)
+{
+    return path.isWide() ? removeFile(path.getWidePath()) :
+        removeFile(path.getPath());
+}
+
+void openMappedFile(boost::iostreams::mapped_file_source& file,
+    FilePath const& path, boost::iostreams::mapped_file_source::size_type length,
+    boost::intmax_t offset)
+{
+    if ( !path.isWide() )
+    {
+        file.open(path.getPath(), length, offset);
+    } else
+    {
+#ifdef _WIN32
+        file.open(path.getWidePath(), length, offset);
+#else
+        file.open(toNativePath(path.getWidePath()), length, offset);
+#endif
+    }
+}
+
+} /* namespace pgn */
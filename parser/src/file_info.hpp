@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_FILE_INFO_HPP
+#define PGN_FILE_INFO_HPP
+
+#include <cstdio>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace pgn
+{
+
+/* Attributes of a file which are used to detect its modification. */
+struct FileInfo
+{
+    FileInfo() : size(), modificationTime() {}
+
+    unsigned long long size; /* size of the file in bytes */
+    long long modificationTime; /* time of last modification (ns or s) */
+};
+
+/* Name of a file in the form which was passed by user (multibyte or wide
+ * string). */
+class FilePath
+{
+public:
+    FilePath() : m_isWide(false) {}
+    FilePath(std::string const& path) : m_path(path), m_isWide(false) {}
+    FilePath(std::wstring const& path) : m_wpath(path), m_isWide(true) {}
+
+    bool isWide() const { return m_isWide; }
+    std::string const& getPath() const { return m_path; }
+    std::wstring const& getWidePath() const { return m_wpath; }
+
+    /* Get name of another file which differs by suffix only. */
+    FilePath withSuffix(char const* suffix) const;
+
+private:
+    std::string m_path;
+    std::wstring m_wpath;
+    bool m_isWide;
+};
+
+/* Get attributes of a file. The method returns false if the file doesn't
+ * exist or can't be accessed. */
+bool getFileInfo(std::string const& path, FileInfo& info);
+bool getFileInfo(std::wstring const& path, FileInfo& info);
+bool getFileInfo(FilePath const& path, FileInfo& info);
+
+/* Thin wrappers over C runtime which accept both types of file names. On
+ * POSIX systems wide file names are converted to multibyte strings using the
+ * current locale. */
+std::FILE* openFile(std::string const& path, char const* mode);
+std::FILE* openFile(std::wstring const& path, char const* mode);
+std::FILE* openFile(FilePath const& path, char const* mode);
+bool renameFile(std::string const& from, std::string const& to);
+bool renameFile(std::wstring const& from, std::wstring const& to);
+bool renameFile(FilePath const& from, FilePath const& to);
+bool removeFile(std::string const& path);
+bool removeFile(std::wstring const& path);
+bool removeFile(FilePath const& path);
+
+/* Map a region of a file into memory (see boost::iostreams). */
+void openMappedFile(boost::iostreams::mapped_file_source& file,
+    FilePath const& path,
+    boost::iostreams::mapped_file_source::size_type length =
+        boost::iostreams::mapped_file_source::max_length,
+    boost::intmax_t offset = 0);
+
+/* Convert a file name to the form which is accepted by 3rd party libraries
+ * on the platform. */
+std::string toNativePath(std::wstring const& path);
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_FILE_INFO_HPP */
@@ -0,0 +1,261 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_watcher.hpp"
+
+#include <string>
+
+#if defined(__linux__)
+#define PGN_LIB_INOTIFY
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace pgn
+{
+
+namespace
+{
+
+/* Modifications which follow each other within the interval are reported
+ * once. */
+const int DEBOUNCE_INTERVAL = 50; /* ms */
+
+} /* unnamed namespace */
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+#ifdef PGN_LIB_INOTIFY
+
+namespace
+{
+
+typedef enum
+{
+    weModified,
+    weTimeout,
+    weStopped,
+    weWatchLost     /* the directory was deleted or moved */
+} watcher_event_t;
+
+} /* unnamed namespace */
+
+struct FileWatcher::State
+{
+    State() : inotify(-1)
+    {
+        stopPipe[0] = stopPipe[1] = -1;
+    }
+
+    ~State()
+    {
+        int const fds[3] = { inotify, stopPipe[0], stopPipe[1] };
+        for ( int i = 0; i < 3; ++i )
+        {
+            if ( fds[i] >= 0 )
+            {
+                close(fds[i]);
+            }
+        }
+    }
+
+    /* The method waits for modification of the file or for stop(). */
+    watcher_event_t waitForEvent(int timeout)
+    {
+        for ( ;; )
+        {
+            pollfd fds[2];
+            fds[0].fd = stopPipe[0];
+            fds[0].events = POLLIN;
+            fds[1].fd = inotify;
+            fds[1].events = POLLIN;
+
+            int const count = poll(fds, 2, timeout);
+            if ( count == 0 )
+            {
+                return weTimeout;
+            }
+
+            if ( count < 0 || fds[0].revents != 0 )
+            {
+                return weStopped;
+            }
+
+            /* Events of other files in the directory are ignored. If the
+             * queue overflowed, then events of the file could be lost,
+             * thus the file is treated as modified. */
+            union
+            {
+                inotify_event event;
+                char buffer[4096];
+            } events;
+            ssize_t const size = read(inotify, events.buffer,
+                sizeof(events.buffer));
+            bool isModified = false;
+            bool isWatchLost = false;
+            for ( ssize_t offset = 0; offset < size; )
+            {
+                inotify_event const* event =
+                    reinterpret_cast<inotify_event const*>(
+                        events.buffer + offset);
+                if ( event->mask & ( IN_IGNORED | IN_DELETE_SELF |
+                    IN_MOVE_SELF ) )
+                {
+                    isWatchLost = true;
+                } else if ( ( event->mask & IN_Q_OVERFLOW ) ||
+                    ( event->len != 0 && name == event->name ) )
+                {
+                    isModified = true;
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+
+            if ( isWatchLost )
+            {
+                return weWatchLost;
+            } else if ( isModified )
+            {
+                return weModified;
+            }
+        }
+    }
+
+    int inotify;
+    int stopPipe[2]; /* it wakes up the thread on stop() */
+    std::string name; /* name of the file without directory */
+    Callback callback;
+};
+
+bool FileWatcher::start(FilePath const& path, Callback const& callback)
+{
+    stop();
+
+    boost::shared_ptr<State> state(new State());
+    std::string const nativePath = path.isWide() ?
+        toNativePath(path.getWidePath()) : path.getPath();
+    std::string::size_type const slash = nativePath.rfind('/');
+    std::string const directory = ( slash == std::string::npos ) ? "." :
+        ( slash == 0 ? "/" : nativePath.substr(0, slash) );
+    state->name = ( slash == std::string::npos ) ? nativePath :
+        nativePath.substr(slash + 1);
+    state->callback = callback;
+
+    state->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if ( state->inotify < 0 ||
+        inotify_add_watch(state->inotify, directory.c_str(), IN_MODIFY |
+            IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+            IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF) < 0 ||
+        pipe(state->stopPipe) != 0 )
+    {
+        return false;
+    }
+    fcntl(state->stopPipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(state->stopPipe[1], F_SETFD, FD_CLOEXEC);
+
+    try
+    {
+        m_thread = boost::thread(&FileWatcher::run, state);
+    } catch ( std::exception const& )
+    {
+        return false;
+    }
+
+    m_state = state;
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if ( !m_state )
+    {
+        return ;
+    }
+
+    char const command = 0;
+    if ( write(m_state->stopPipe[1], &command, sizeof(command)) < 0 )
+    {
+        /* The pipe is empty, thus it can't happen. */
+    }
+
+    if ( m_thread.get_id() == boost::this_thread::get_id() )
+    {
+        /* The watcher is stopped by its callback. The thread will stop
+         * after the callback returns. */
+        m_thread.detach();
+    } else
+    {
+        m_thread.join();
+    }
+    m_state.reset();
+}
+
+/* If the directory isn't watched anymore, then the file is reported as
+ * modified for the last time (it is gone with the directory). */
+void FileWatcher::run(boost::shared_ptr<State> state)
+{
+    watcher_event_t event = state->waitForEvent(-1);
+    while ( event == weModified || event == weWatchLost )
+    {
+        /* Wait until the writer stops. */
+        while ( event == weModified )
+        {
+            event = state->waitForEvent(DEBOUNCE_INTERVAL);
+        }
+
+        if ( event == weStopped )
+        {
+            break;
+        }
+
+        state->callback();
+        if ( event == weWatchLost )
+        {
+            break;
+        }
+        event = state->waitForEvent(-1);
+    }
+}
+
+#else /* #ifdef PGN_LIB_INOTIFY */
+
+struct FileWatcher::State
+{
+};
+
+bool FileWatcher::start(FilePath const& , Callback const& )
+{
+    return false;
+}
+
+void FileWatcher::stop()
+{
+}
+
+void FileWatcher::run(boost::shared_ptr<State> )
+{
+}
+
+#endif /* #ifdef PGN_LIB_INOTIFY */
+
+} /* namespace pgn */
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_FILE_WATCHER_HPP
+#define PGN_FILE_WATCHER_HPP
+
+#include "file_info.hpp"
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace pgn
+{
+
+/* Notify about modifications of a file. The directory of the file is
+ * watched, thus the file can be appended, rewritten or replaced by another
+ * file (e.g. by rename). Bursts of modifications (e.g. a writer appends
+ * the file line by line) are reported once. The callback is called in a
+ * thread of the watcher. The watcher can be stopped (or even destroyed) by
+ * the callback. If the directory is deleted or moved, then the callback is
+ * called for the last time and watching is ended. Only Linux (inotify) is
+ * supported now. */
+class FileWatcher
+{
+public:
+    typedef boost::function<void ()> Callback;
+
+    FileWatcher() {}
+    ~FileWatcher();
+
+    /* Start watching of the file. The method returns false if the file
+     * can't be watched (e.g. the platform isn't supported). */
+    bool start(FilePath const& path, Callback const& callback);
+
+    /* Stop watching. The method waits until the callback returns. */
+    void stop();
+
+private:
+    FileWatcher(FileWatcher const& ); /* without implementation */
+    FileWatcher& operator=(FileWatcher const& ); /* without implementation */
+
+    /* Everything which is used by the thread. It is shared, thus the
+     * thread can outlive the watcher. */
+    struct State;
+    static void run(boost::shared_ptr<State> state);
+
+    boost::shared_ptr<State> m_state;
+    boost::thread m_thread;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_FILE_WATCHER_HPP */
@@ -0,0 +1,547 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game_builder.hpp"
+#include "tag_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace pgn
+{
+
+namespace
+{
+
+/* Decode escaped characters (\" and \\) of a string token. */
+char const* unescape(char const* data, std::size_t length, Arena& arena)
+{
+    char* const value = arena.allocate<char>(length + 1);
+    char* c = value;
+    for ( std::size_t i = 0; i < length; ++i )
+    {
+        if ( data[i] == '\\' && i + 1 < length )
+        {
+            ++i;
+        }
+        *c++ = data[i];
+    }
+    *c = '\0';
+
+    return value;
+}
+
+game_result_t toGameResult(char const* data, std::size_t length)
+{
+    if ( length == 3 && std::strncmp(data, "1-0", 3) == 0 )
+    {
+        return grWhiteWin;
+    } else if ( length == 3 && std::strncmp(data, "0-1", 3) == 0 )
+    {
+        return grBlackWin;
+    } else if ( length == 7 && std::strncmp(data, "1/2-1/2", 7) == 0 )
+    {
+        return grDraw;
+    }
+
+    return grUndefined;
+}
+
+bool isLetter(char c)
+{
+    return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' );
+}
+
+unsigned parseNumber(char const* data, std::size_t length)
+{
+    unsigned number = 0;
+    for ( std::size_t i = 0; i < length && data[i] >= '0' && data[i] <= '9';
+        ++i )
+    {
+        number = number * 10 + ( data[i] - '0' );
+    }
+
+    return number;
+}
+
+/* NAG token is $N or a suffix annotation. */
+NAG_t parseNAG(char const* data, std::size_t length)
+{
+    if ( data[0] == '$' )
+    {
+        unsigned const nag = parseNumber(data + 1, length - 1);
+        return nag < nagLastNumericAnnotationGlyph ? NAG_t(nag) : nagNull;
+    }
+
+    static char const* const SUFFIXES[] = { "!", "?", "!!", "??", "!?", "?!" };
+    static NAG_t const NAGS[] = { nagGoodMove, nagPoorMove, nagVeryGoodMove,
+        nagVeryPoorMove, nagSpeculativeMove, nagQuestionableMove };
+    for ( std::size_t i = 0; i < sizeof(NAGS) / sizeof(NAGS[0]); ++i )
+    {
+        if ( std::strlen(SUFFIXES[i]) == length &&
+            std::strncmp(SUFFIXES[i], data, length) == 0 )
+        {
+            return NAGS[i];
+        }
+    }
+
+    return nagNull;
+}
+
+} /* unnamed namespace */
+
+void GameParser::parse(char const* data, std::size_t size,
+    IGameVisitor& visitor)
+{
+    m_data = data;
+    m_resultTag = NULL;
+    m_moveText = NULL;
+    m_moveTextLength = 0;
+    Tokenizer tokenizer(data, size);
+    Token token;
+    tokenizer.next(token);
+    if ( parseTagPairSection(tokenizer, token, visitor) )
+    {
+        parseMoveTextSection(tokenizer, token, visitor);
+    }
+}
+
+bool GameParser::parseTagPairs(char const* data, std::size_t size,
+    IGameVisitor& visitor, std::size_t& moveTextOffset)
+{
+    m_data = data;
+    m_resultTag = NULL;
+    Tokenizer tokenizer(data, size);
+    Token token;
+    tokenizer.next(token);
+    if ( !parseTagPairSection(tokenizer, token, visitor) )
+    {
+        return false;
+    }
+
+    /* Offset of comment or string token is after its delimiter. */
+    moveTextOffset = ( token.type == ttComment || token.type == ttString ) ?
+        token.offset - 1 : token.offset;
+    return true;
+}
+
+void GameParser::parseMoveText(char const* data, std::size_t size,
+    char const* resultTag, IGameVisitor& visitor)
+{
+    m_data = data;
+    m_resultTag = resultTag;
+    m_resultTagLength = ( resultTag != NULL ) ? std::strlen(resultTag) : 0;
+    m_moveText = NULL;
+    m_moveTextLength = 0;
+    Tokenizer tokenizer(data, size);
+    Token token;
+    tokenizer.next(token);
+    parseMoveTextSection(tokenizer, token, visitor);
+}
+
+/* On success token is the first token of movetext section. */
+bool GameParser::parseTagPairSection(Tokenizer& tokenizer, Token& token,
+    IGameVisitor& visitor)
+{
+    while ( token.type == ttLeftBracket )
+    {
+        Token name;
+        tokenizer.next(name);
+        if ( name.type != ttSymbol || !isLetter(m_data[name.offset]) )
+        {
+            return report(true, seIllegalTagName, L"illegal tag name",
+                name.offset, visitor);
+        }
+
+        Token value;
+        tokenizer.next(value);
+        if ( value.type != ttString )
+        {
+            return report(true, seIllegalTagValue,
+                L"tag value should be a string", value.offset, visitor);
+        }
+
+        tokenizer.next(token);
+        if ( token.type != ttRightBracket )
+        {
+            return report(true, seIllegalToken, L"tag pair isn't closed",
+                token.offset, visitor);
+        }
+
+        /* If a tag is duplicated, then the first value is used. */
+        if ( m_resultTag == NULL && name.length == 6 &&
+            std::strncmp(m_data + name.offset, "Result", 6) == 0 )
+        {
+            m_resultTag = m_data + value.offset;
+            m_resultTagLength = value.length;
+        }
+
+        if ( m_projection == NULL ||
+            m_projection->isTagKept(m_data + name.offset, name.length) )
+        {
+            visitor.onTagPair(m_data + name.offset, name.length,
+                m_data + value.offset, value.length);
+        }
+        tokenizer.next(token);
+    }
+
+    return true;
+}
+
+bool GameParser::parseMoveTextSection(Tokenizer& tokenizer, Token& token,
+    IGameVisitor& visitor)
+{
+    /* Offset of comment or string token is after its delimiter. */
+    std::size_t const moveTextOffset = ( token.type == ttComment ||
+        token.type == ttString ) ? token.offset - 1 : token.offset;
+    m_frames.assign(1, Frame(0));
+    bool const areMovesKept = isKept(gpMoves);
+    bool const areVariationsKept = isKept(gpVariations);
+    bool const areNAGsKept = isKept(gpNAGs);
+    bool const areCommentsKept = isKept(gpComments);
+    while ( token.type != ttEnd && token.type != ttTermination )
+    {
+        Frame& frame = m_frames.back();
+        switch ( token.type )
+        {
+        case ttMoveNumber:
+            {
+                /* Number of the move is taken from the movetext, thus
+                 * games from a position (FEN tag) are numbered right. */
+                unsigned const number = parseNumber(m_data + token.offset,
+                    token.length);
+                bool const isBlack = token.length >= 3 && std::strncmp(
+                    m_data + token.offset + token.length - 3, "...", 3) == 0;
+                if ( number != 0 )
+                {
+                    frame.ply = 2 * ( number - 1 ) + ( isBlack ? 1 : 0 );
+                }
+            }
+            break;
+        case ttSymbol:
+            frame.hasMove = true;
+            frame.lastMovePly = frame.ply++;
+            if ( !areMovesKept )
+            {
+                break;
+            }
+            visitor.onMove(m_data + token.offset, token.length,
+                frame.lastMovePly / 2 + 1);
+            if ( token.length >= 3 &&
+                std::strncmp(m_data + token.offset, "0-0", 3) == 0 &&
+                !report(false, seIllegalMove,
+                    L"castling is written with zeros", token.offset,
+                    visitor) )
+            {
+                return false;
+            }
+            break;
+        case ttNAG:
+            if ( areNAGsKept && frame.hasMove )
+            {
+                /* Unknown NAGs ($0, too big numbers and suffixes which
+                 * aren't in the standard) are dropped. */
+                NAG_t const nag = parseNAG(m_data + token.offset,
+                    token.length);
+                if ( nag != nagNull )
+                {
+                    visitor.onNAG(nag);
+                }
+            }
+            break;
+        case ttComment:
+            if ( areCommentsKept )
+            {
+                visitor.onComment(m_data + token.offset, token.length);
+            }
+            break;
+        case ttRavBegin:
+            if ( !frame.hasMove )
+            {
+                return report(true, seIllegalToken,
+                    L"variation should follow a move", token.offset,
+                    visitor);
+            } else if ( !areVariationsKept )
+            {
+                /* Nested variations are skipped with it. */
+                tokenizer.skipVariation(token);
+                if ( token.type == ttEnd )
+                {
+                    return report(true, seIllegalToken,
+                        L"variation isn't closed", token.offset, visitor);
+                }
+            } else
+            {
+                /* The variation is an alternative to the last move. */
+                m_frames.push_back(Frame(frame.lastMovePly));
+                visitor.onVariationBegin();
+            }
+            break;
+        case ttRavEnd:
+            if ( m_frames.size() == 1 )
+            {
+                return report(true, seIllegalToken,
+                    L"variation isn't opened", token.offset, visitor);
+            }
+            m_frames.pop_back();
+            visitor.onVariationEnd();
+            break;
+        default:
+            return report(true, seIllegalToken, L"illegal token in movetext",
+                token.offset, visitor);
+        }
+
+        tokenizer.next(token);
+    }
+
+    if ( m_frames.size() != 1 )
+    {
+        return report(true, seIllegalToken, L"variation isn't closed",
+            token.offset, visitor);
+    }
+
+    std::size_t moveTextEnd = token.offset;
+    while ( moveTextEnd > moveTextOffset &&
+        std::strchr(" \t\r\n\v\f", m_data[moveTextEnd - 1]) != NULL )
+    {
+        --moveTextEnd;
+    }
+    m_moveText = m_data + moveTextOffset;
+    m_moveTextLength = moveTextEnd - moveTextOffset;
+
+    game_result_t const tagResult = ( m_resultTag != NULL ) ?
+        toGameResult(m_resultTag, m_resultTagLength) : grUndefined;
+    if ( token.type != ttTermination )
+    {
+        visitor.onResult(tagResult);
+        return report(false, seIllegalTerminationMarker,
+            L"termination marker is absent", moveTextEnd, visitor);
+    }
+
+    game_result_t const result = toGameResult(m_data + token.offset,
+        token.length);
+    visitor.onResult(result);
+    if ( m_resultTag != NULL && tagResult != result )
+    {
+        return report(false, seIllegalTerminationMarker,
+            L"termination marker doesn't match Result tag", token.offset,
+            visitor);
+    }
+
+    return true;
+}
+
+/* Non-critical errors are fixed silently if the parser isn't strict. */
+bool GameParser::report(bool isCritical, syntax_error_t code,
+    wchar_t const* description, std::size_t offset, IGameVisitor& visitor)
+{
+    bool isAccepted = true;
+    if ( ( isCritical || m_isStrict ) && m_reporter )
+    {
+        isAccepted = m_reporter(isCritical, code, description, offset);
+    }
+
+    if ( isCritical || !isAccepted )
+    {
+        visitor.onSyntaxError(code);
+        return false;
+    }
+
+    return true;
+}
+
+const std::size_t GameBuilder::NO_MOVE;
+
+bool GameBuilder::buildTagPairs(char const* data, std::size_t size,
+    GameImpl& game, std::size_t& moveTextOffset)
+{
+    m_game = &game;
+    return m_parser.parseTagPairs(data, size, *this, moveTextOffset);
+}
+
+void GameBuilder::buildMoveText(char const* data, std::size_t size,
+    GameImpl& game)
+{
+    m_game = &game;
+    Frame mainLine(MAIN_LINE, true, Board());
+    char const* const fen = game.getTagValue("FEN");
+    if ( fen != NULL )
+    {
+        /* Moves are kept as is if the position isn't supported. */
+        mainLine.isPositionKnown = mainLine.position.setFEN(fen);
+    }
+    m_frames.assign(1, mainLine);
+    m_pendingComments.clear();
+    m_firstMoveNumber = 0;
+    m_isFirstPlyGuessed = false;
+
+    m_parser.parseMoveText(data, size, game.getTagResult(), *this);
+    std::size_t length = 0;
+    char const* const moveText = m_parser.getMoveText(length);
+    if ( moveText != NULL )
+    {
+        game.setMoveText(moveText, length);
+    }
+    game.arrangeMoves();
+}
+
+/* Names of the file aren't added to the table of tag names (they can be
+ * garbage), the game keeps a copy of a name which isn't there. */
+void GameBuilder::onTagPair(char const* name, std::size_t nameLength,
+    char const* value, std::size_t valueLength)
+{
+    Arena& arena = m_game->getArena();
+    char const* tagName = NULL;
+    tag_id_t const id = TagTable::getInstance().find(name, nameLength,
+        &tagName);
+    if ( id == NULL_TAG_ID )
+    {
+        tagName = arena.copyString(name, nameLength);
+    }
+    m_game->addTagPair(id, tagName, unescape(value, valueLength, arena));
+}
+
+void GameBuilder::onMove(char const* san, std::size_t length,
+    unsigned moveNumber)
+{
+    Frame& frame = m_frames.back();
+    if ( frame.variation == MAIN_LINE )
+    {
+        setFirstPly(frame, moveNumber);
+    }
+
+    frame.lastMovePosition = frame.position;
+    frame.isLastMovePositionKnown = frame.isPositionKnown;
+    packed_move_t packedMove = NULL_MOVE;
+    if ( frame.isPositionKnown &&
+        frame.position.findMove(san, length, packedMove) )
+    {
+        frame.position.makeMove(packedMove);
+    }
+
+    frame.lastMove = m_game->addMove(frame.variation, packedMove);
+    frame.lastMoveExtras = NO_MOVE;
+    if ( packedMove == NULL_MOVE )
+    {
+        /* Next moves of the variation can't be resolved too. */
+        MoveExtras& extras = m_game->getMoveExtras(getLastMoveExtras(frame));
+        extras.isIllegal = frame.isPositionKnown;
+        frame.isPositionKnown = false;
+        char* const text = m_game->getArena().copyString(san, length);
+        if ( length >= 3 && std::strncmp(text, "0-0", 3) == 0 )
+        {
+            /* Castling is written with zeros. */
+            std::replace(text, text + length, '0', 'O');
+        }
+        extras.san = text;
+    }
+
+    for ( std::size_t i = 0; i < m_pendingComments.size(); ++i )
+    {
+        m_game->addComment(getLastMoveExtras(frame),
+            m_pendingComments[i].text, m_pendingComments[i].length);
+    }
+    m_pendingComments.clear();
+}
+
+void GameBuilder::onNAG(NAG_t nag)
+{
+    Frame& frame = m_frames.back();
+    if ( frame.lastMove != NO_MOVE )
+    {
+        m_game->addNAG(getLastMoveExtras(frame), nag);
+    }
+}
+
+void GameBuilder::onComment(char const* comment, std::size_t length)
+{
+    Frame& frame = m_frames.back();
+    if ( frame.lastMove != NO_MOVE )
+    {
+        m_game->addComment(getLastMoveExtras(frame), comment, length);
+    } else
+    {
+        /* The comment is before the first move of the variation. */
+        Comment const pendingComment = { comment, length };
+        m_pendingComments.push_back(pendingComment);
+    }
+}
+
+/* The variation is an alternative to the last move, GameParser checks that
+ * the move exists. */
+void GameBuilder::onVariationBegin()
+{
+    Frame& frame = m_frames.back();
+    Frame const variation(m_game->addVariation(frame.lastMove,
+        frame.variation, getLastMoveExtras(frame)),
+        frame.isLastMovePositionKnown, frame.lastMovePosition);
+    m_frames.push_back(variation);
+    m_pendingComments.clear();
+}
+
+void GameBuilder::onVariationEnd()
+{
+    m_frames.pop_back();
+    m_pendingComments.clear();
+}
+
+void GameBuilder::onResult(game_result_t result)
+{
+    m_game->setResult(result);
+}
+
+void GameBuilder::onSyntaxError(syntax_error_t code)
+{
+    m_game->setSyntaxError(code);
+}
+
+std::size_t GameBuilder::getLastMoveExtras(Frame& frame)
+{
+    if ( frame.lastMoveExtras == NO_MOVE )
+    {
+        frame.lastMoveExtras = m_game->addMoveExtras(frame.lastMove);
+    }
+
+    return frame.lastMoveExtras;
+}
+
+/* Numbers of moves are counted from the first move of the main line, it is
+ * made by the side to move. If the position is unknown, then the side is
+ * found by the number of the second move: it is the same if white made the
+ * first move. */
+void GameBuilder::setFirstPly(Frame const& frame, unsigned moveNumber)
+{
+    if ( frame.lastMove == NO_MOVE )
+    {
+        unsigned const side = frame.isPositionKnown ?
+            frame.position.getSideToMove() : 0;
+        m_game->setFirstPly(2 * ( moveNumber - 1 ) + side);
+        m_firstMoveNumber = moveNumber;
+        m_isFirstPlyGuessed = !frame.isPositionKnown;
+    } else if ( m_isFirstPlyGuessed )
+    {
+        m_isFirstPlyGuessed = false;
+        if ( moveNumber != m_firstMoveNumber )
+        {
+            m_game->setFirstPly(2 * ( m_firstMoveNumber - 1 ) + 1);
+        }
+    }
+}
+
+} /* namespace pgn */
@@ -0,0 +1,196 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_GAME_BUILDER_HPP
+#define PGN_GAME_BUILDER_HPP
+
+#include <pgn/game_visitor.hpp>
+#include "game_impl.hpp"
+#include "projection.hpp"
+#include "board.hpp"
+#include "tokenizer.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/function.hpp>
+
+namespace pgn
+{
+
+/* The grammar of a game. Tokens are taken from Tokenizer directly from the
+ * mapped file, elements of the game are passed to the visitor as views into
+ * the data. Syntax errors are reported with offset from the beginning of
+ * the data. Non-critical errors (they can be fixed by the caller) are
+ * reported in strict mode only. If the reporter returns false or an error
+ * is critical then parsing is stopped and the visitor gets onSyntaxError().
+ * If a projection is given, then parts of the game which aren't in it are
+ * skipped: they aren't passed to the visitor and variations aren't
+ * tokenized. The syntax is checked anyway (except skipped variations). */
+class GameParser
+{
+public:
+    typedef boost::function<bool (bool isCritical, syntax_error_t code,
+        wchar_t const* description, std::size_t offset)> ErrorReporter;
+
+    GameParser(bool isStrict, ErrorReporter const& reporter,
+        Projection const* projection = NULL) :
+        m_isStrict(isStrict), m_reporter(reporter), m_projection(projection),
+        m_data(NULL), m_resultTag(NULL), m_resultTagLength(0),
+        m_moveText(NULL), m_moveTextLength(0) {}
+
+    /* Parse the game from data (both tag pair and movetext sections). */
+    void parse(char const* data, std::size_t size, IGameVisitor& visitor);
+
+    /* Parse the tag pair section only. On success the method returns true
+     * and offset of the movetext section in data. */
+    bool parseTagPairs(char const* data, std::size_t size,
+        IGameVisitor& visitor, std::size_t& moveTextOffset);
+
+    /* Parse the movetext section, data starts at the section. The
+     * termination marker is checked against the value of Result tag (NULL
+     * if the game doesn't have it). */
+    void parseMoveText(char const* data, std::size_t size,
+        char const* resultTag, IGameVisitor& visitor);
+
+    /* Get the movetext without trailing spaces. It is NULL unless the end
+     * of the movetext was reached by the last call. */
+    char const* getMoveText(std::size_t& length) const
+    {
+        length = m_moveTextLength;
+        return m_moveText;
+    }
+
+private:
+    /* A variation which is being parsed. */
+    struct Frame
+    {
+        explicit Frame(unsigned _ply) : ply(_ply), lastMovePly(0),
+            hasMove(false) {}
+
+        unsigned ply; /* ply of the next move (0 is the first white move) */
+        unsigned lastMovePly;
+        bool hasMove; /* the variation contains a move */
+    };
+
+    bool isKept(game_part_t part) const
+    {
+        return m_projection == NULL || m_projection->hasPart(part);
+    }
+
+    bool parseTagPairSection(Tokenizer& tokenizer, Token& token,
+        IGameVisitor& visitor);
+    bool parseMoveTextSection(Tokenizer& tokenizer, Token& token,
+        IGameVisitor& visitor);
+    bool report(bool isCritical, syntax_error_t code,
+        wchar_t const* description, std::size_t offset,
+        IGameVisitor& visitor);
+
+    bool const m_isStrict;
+    ErrorReporter m_reporter;
+    Projection const* const m_projection; /* NULL if everything is kept */
+    char const* m_data; /* data of the game which is being parsed */
+    char const* m_resultTag; /* value of Result tag or NULL */
+    std::size_t m_resultTagLength;
+    char const* m_moveText; /* see getMoveText() */
+    std::size_t m_moveTextLength;
+    std::vector<Frame> m_frames; /* the main line and nested RAVs */
+};
+
+/* The class builds GameImpl from elements which are found by GameParser.
+ * Only values which are stored in the game are copied, the movetext and
+ * comments refer to the data. Moves are resolved on the board. */
+class GameBuilder : private IGameVisitor
+{
+public:
+    typedef GameParser::ErrorReporter ErrorReporter;
+
+    GameBuilder(bool isStrict, ErrorReporter const& reporter,
+        Projection const* projection = NULL) :
+        m_parser(isStrict, reporter, projection), m_game(NULL),
+        m_firstMoveNumber(0), m_isFirstPlyGuessed(false) {}
+
+    /* Parse the tag pair section only. On success the method returns true
+     * and offset of the movetext section in data. */
+    bool buildTagPairs(char const* data, std::size_t size, GameImpl& game,
+        std::size_t& moveTextOffset);
+
+    /* Parse the movetext section, data starts at the section. The game
+     * refers to data, thus it should outlive the game. */
+    void buildMoveText(char const* data, std::size_t size, GameImpl& game);
+
+private:
+    /* A variation which is being built. */
+    struct Frame
+    {
+        /* The variation starts from the position, it doesn't have moves
+         * yet. */
+        Frame(variation_t _variation, bool _isPositionKnown,
+            Board const& _position) : variation(_variation),
+            lastMove(NO_MOVE), lastMoveExtras(NO_MOVE),
+            isPositionKnown(_isPositionKnown), isLastMovePositionKnown(true),
+            position(_position) {}
+
+        variation_t variation;
+        std::size_t lastMove; /* index of the last move or NO_MOVE */
+        std::size_t lastMoveExtras; /* index of extras of the last move or
+                                       NO_MOVE if they aren't added yet */
+        bool isPositionKnown; /* moves can be resolved on the board */
+        bool isLastMovePositionKnown;
+        Board position; /* after the last move */
+        Board lastMovePosition; /* before the last move, variations of the
+                                   move start from it */
+    };
+
+    /* A comment before the first move of a variation. */
+    struct Comment
+    {
+        char const* text;
+        std::size_t length;
+    };
+
+    static const std::size_t NO_MOVE = ~std::size_t(0);
+
+    /* Get extras of the last move of the variation, they are added on the
+     * first call. */
+    std::size_t getLastMoveExtras(Frame& frame);
+    void setFirstPly(Frame const& frame, unsigned moveNumber);
+
+    void onTagPair(char const* name, std::size_t nameLength,
+        char const* value, std::size_t valueLength);
+    void onMove(char const* san, std::size_t length, unsigned moveNumber);
+    void onNAG(NAG_t nag);
+    void onComment(char const* comment, std::size_t length);
+    void onVariationBegin();
+    void onVariationEnd();
+    void onResult(game_result_t result);
+    void onSyntaxError(syntax_error_t code);
+
+    GameParser m_parser;
+    GameImpl* m_game; /* the game which is being built */
+    std::vector<Frame> m_frames; /* the main line and nested RAVs */
+    std::vector<Comment> m_pendingComments; /* comments before a move */
+    unsigned m_firstMoveNumber; /* number of the first move of the game */
+    bool m_isFirstPlyGuessed; /* the side which made the first move isn't
+                                 known yet */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_GAME_BUILDER_HPP */
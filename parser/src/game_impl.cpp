@@ -0,0 +1,664 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game_impl.hpp"
+#include "game_builder.hpp"
+#include "tag_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+namespace pgn
+{
+
+namespace
+{
+
+/* Order of extras of moves. */
+bool isBefore(MoveExtras const& left, MoveExtras const& right)
+{
+    return left.move < right.move;
+}
+
+} /* unnamed namespace */
+
+GameImpl::GameImpl(unsigned sequenceNumber)
+{
+    reset(sequenceNumber);
+}
+
+unsigned GameImpl::release() const
+{
+    unsigned const counter = _release();
+    if ( counter != 0 )
+    {
+        return counter;
+    }
+
+    /* The game doesn't keep the pool while it is free, otherwise they would
+     * keep each other. The pool can be destroyed with the game here. */
+    boost::shared_ptr<GamePool> pool;
+    pool.swap(m_pool);
+    m_pendingMoveText = PendingMoveText();
+    m_moveTextRegion.reset();
+    if ( pool )
+    {
+        pool->recycle(const_cast<GameImpl*>(this));
+    } else
+    {
+        delete this;
+    }
+
+    return 0;
+}
+
+/* Arrays have to be dropped before the arena is reset because they point
+ * into it. */
+void GameImpl::reset(unsigned sequenceNumber)
+{
+    m_tagPairs = ArenaVector<tag_pair_t>();
+    m_tagIds = ArenaVector<tag_id_t>();
+    m_moves = ArenaVector<packed_move_t>();
+    m_moveVariations = ArenaVector<variation_t>();
+    m_moveExtras = ArenaVector<MoveExtras>();
+    m_moveNAGs = ArenaVector<MoveNAG>();
+    m_nags = ArenaVector<unsigned char>();
+    m_variations = ArenaVector<Variation>();
+    m_childVariations = ArenaVector<variation_t>();
+    m_arena.reset();
+    m_pendingMoveText = PendingMoveText();
+    m_moveTextRegion.reset();
+
+    m_sequenceNumber = sequenceNumber;
+    m_nextTagPair = 0;
+    std::fill(m_rosterTags, m_rosterTags + ROSTER_TAG_COUNT,
+        static_cast<char const*>(NULL));
+    m_moveText = "";
+    m_rawMoveText = NULL;
+    m_rawMoveTextLength = 0;
+    m_result = grUndefined;
+    m_syntaxError = seValid;
+    m_firstPly = 0;
+    Variation const mainLine = { 0, 0, 0, MAIN_LINE, NULL };
+    m_variations.push_back(mainLine, m_arena);
+}
+
+void GameImpl::parsePendingMoveText() const
+{
+    /* The movetext is forgotten before parsing, thus the game doesn't try
+     * to parse it again while it is being built. */
+    PendingMoveText moveText;
+    std::swap(moveText, m_pendingMoveText);
+    moveText.source->build(const_cast<GameImpl&>(*this), moveText);
+
+    /* The movetext and comments refer to the region. */
+    m_moveTextRegion = moveText.region;
+}
+
+char const* GameImpl::getMoveText() const
+{
+    parseMoveText();
+    if ( m_moveText == NULL )
+    {
+        m_moveText = const_cast<Arena&>(m_arena).copyString(m_rawMoveText,
+            m_rawMoveTextLength);
+    }
+
+    return m_moveText;
+}
+
+char const* GameImpl::getTagValue(char const* name) const
+{
+    if ( name == NULL )
+    {
+        return NULL;
+    }
+
+    tag_id_t const id = TagTable::getInstance().find(name,
+        std::strlen(name));
+    if ( id != NULL_TAG_ID )
+    {
+        return getTagValueById(id);
+    }
+
+    /* Names which aren't interned are compared. */
+    for ( std::size_t i = 0; i < m_tagPairs.size(); ++i )
+    {
+        if ( m_tagIds[i] == NULL_TAG_ID &&
+            std::strcmp(m_tagPairs[i].name, name) == 0 )
+        {
+            return m_tagPairs[i].value;
+        }
+    }
+
+    return NULL;
+}
+
+char const* GameImpl::getTagValueById(tag_id_t id) const
+{
+    if ( id < ROSTER_TAG_COUNT )
+    {
+        return m_rosterTags[id];
+    } else if ( id == NULL_TAG_ID )
+    {
+        return NULL;
+    }
+
+    /* Tags which were added before their name was interned don't have an
+     * identifier, their names are compared. */
+    char const* name = NULL;
+    for ( std::size_t i = 0; i < m_tagIds.size(); ++i )
+    {
+        if ( m_tagIds[i] == id )
+        {
+            return m_tagPairs[i].value;
+        } else if ( m_tagIds[i] != NULL_TAG_ID )
+        {
+            continue;
+        }
+
+        if ( name == NULL )
+        {
+            name = TagTable::getInstance().getName(id);
+        }
+        if ( name != NULL && std::strcmp(m_tagPairs[i].name, name) == 0 )
+        {
+            return m_tagPairs[i].value;
+        }
+    }
+
+    return NULL;
+}
+
+/* If a tag is duplicated, then the first value is used. */
+void GameImpl::addTagPair(tag_id_t id, char const* name, char const* value)
+{
+    tag_pair_t const tagPair = { name, value };
+    m_tagPairs.push_back(tagPair, m_arena);
+    m_tagIds.push_back(id, m_arena);
+    if ( id < ROSTER_TAG_COUNT && m_rosterTags[id] == NULL )
+    {
+        m_rosterTags[id] = value;
+    }
+}
+
+tag_pair_t GameImpl::getTagPair(unsigned n) const
+{
+    if ( n == NEXT_ITEM )
+    {
+        n = ++m_nextTagPair;
+    }
+
+    if ( n == 0 || n > m_tagPairs.size() )
+    {
+        /* The end of the list. Iteration can be started again. */
+        m_nextTagPair = 0;
+        return NULL_TAG_PAIR;
+    }
+
+    return m_tagPairs[n - 1];
+}
+
+IMove const* GameImpl::getMove(unsigned n, variation_t v) const
+{
+    parseMoveText();
+    if ( v >= m_variations.size() || n == 0 ||
+        n > m_variations[v].moveCount )
+    {
+        return NULL;
+    }
+
+    if ( m_variations[v].moves == NULL )
+    {
+        createMoves(v);
+    }
+
+    return m_variations[v].moves + n - 1;
+}
+
+unsigned GameImpl::getMoveCount(variation_t v) const
+{
+    parseMoveText();
+    return v < m_variations.size() ? m_variations[v].moveCount : 0;
+}
+
+unsigned GameImpl::getVariationCount(IMove const* move) const
+{
+    parseMoveText();
+    return move != NULL ?
+        static_cast<MoveImpl const*>(move)->getChildVariationCount() : 0;
+}
+
+variation_t GameImpl::getVariation(IMove const* move, unsigned n) const
+{
+    parseMoveText();
+    return move != NULL ?
+        static_cast<MoveImpl const*>(move)->getChildVariation(n) :
+        NULL_VARIATION;
+}
+
+packed_move_t const* GameImpl::getPackedMoves(variation_t v,
+    unsigned& count) const
+{
+    parseMoveText();
+    if ( v >= m_variations.size() || m_variations[v].moveCount == 0 )
+    {
+        count = 0;
+        return NULL;
+    }
+
+    count = m_variations[v].moveCount;
+    return m_moves.data() + m_variations[v].firstMove;
+}
+
+char const* GameImpl::getComment(MoveExtras const& extras) const
+{
+    if ( extras.comment == NULL && extras.rawComment != NULL )
+    {
+        extras.comment = normalizeComment(extras.rawComment,
+            extras.rawCommentLength, const_cast<Arena&>(m_arena));
+    }
+
+    return extras.comment;
+}
+
+void GameImpl::setSyntaxError(syntax_error_t code)
+{
+    if ( m_syntaxError == seValid )
+    {
+        m_syntaxError = code;
+    }
+}
+
+/* Variations of moves are recorded since the first child variation, moves
+ * before it are in the main line. */
+std::size_t GameImpl::addMove(variation_t v, packed_move_t move)
+{
+    m_moves.push_back(move, m_arena);
+    ++m_variations[v].moveCount;
+    if ( m_variations.size() > 1 )
+    {
+        while ( m_moveVariations.size() + 1 < m_moves.size() )
+        {
+            m_moveVariations.push_back(MAIN_LINE, m_arena);
+        }
+        m_moveVariations.push_back(v, m_arena);
+    }
+
+    return m_moves.size() - 1;
+}
+
+std::size_t GameImpl::addMoveExtras(std::size_t moveIndex)
+{
+    m_moveExtras.push_back(MoveExtras(), m_arena);
+    m_moveExtras.back().move = static_cast<unsigned>(moveIndex);
+    return m_moveExtras.size() - 1;
+}
+
+void GameImpl::addNAG(std::size_t extrasIndex, NAG_t nag)
+{
+    /* nagNull is the end of the list for getNAG(NEXT_ITEM). */
+    if ( nag == nagNull )
+    {
+        return ;
+    }
+
+    MoveNAG const moveNAG = { static_cast<unsigned>(extrasIndex),
+        static_cast<unsigned char>(nag) };
+    m_moveNAGs.push_back(moveNAG, m_arena);
+    ++m_moveExtras[extrasIndex].nagCount;
+}
+
+/* Several comments of the move are joined. Usually there is one comment,
+ * thus it is kept as a reference to the movetext. */
+void GameImpl::addComment(std::size_t extrasIndex, char const* comment,
+    std::size_t length)
+{
+    MoveExtras& extras = m_moveExtras[extrasIndex];
+    extras.comment = NULL;
+    if ( extras.rawComment == NULL )
+    {
+        extras.rawComment = comment;
+        extras.rawCommentLength = length;
+        return ;
+    }
+
+    char* const joined = m_arena.allocate<char>(extras.rawCommentLength + 1 +
+        length);
+    std::memcpy(joined, extras.rawComment, extras.rawCommentLength);
+    joined[extras.rawCommentLength] = ' ';
+    std::memcpy(joined + extras.rawCommentLength + 1, comment, length);
+    extras.rawComment = joined;
+    extras.rawCommentLength += 1 + length;
+}
+
+variation_t GameImpl::addVariation(std::size_t moveIndex, variation_t parent,
+    std::size_t extrasIndex)
+{
+    Variation const variation = { 0, 0, static_cast<unsigned>(moveIndex),
+        parent, NULL };
+    m_variations.push_back(variation, m_arena);
+    ++m_moveExtras[extrasIndex].childVariationCount;
+    return m_variations.size() - 1;
+}
+
+/* Moves are added in order of appearance in the movetext, thus moves of a
+ * variation are interleaved with moves of its children. They are sorted by
+ * variation (counting sort), old arrays are wasted in the arena. Extras are
+ * sorted by new indexes of moves, NAGs and child variations of each move
+ * get ranges of their tables. */
+void GameImpl::arrangeMoves()
+{
+    m_nags.reserve(m_moveNAGs.size(), m_arena);
+    unsigned firstNAG = 0;
+    for ( std::size_t i = 0; i < m_moveExtras.size(); ++i )
+    {
+        m_moveExtras[i].firstNAG = firstNAG;
+        firstNAG += m_moveExtras[i].nagCount;
+        m_moveExtras[i].nagCount = 0;
+    }
+    for ( std::size_t i = 0; i < m_moveNAGs.size(); ++i )
+    {
+        m_nags.push_back(nagNull, m_arena);
+    }
+    for ( std::size_t i = 0; i < m_moveNAGs.size(); ++i )
+    {
+        MoveExtras& extras = m_moveExtras[m_moveNAGs[i].extrasIndex];
+        m_nags[extras.firstNAG + extras.nagCount++] = m_moveNAGs[i].nag;
+    }
+    m_moveNAGs = ArenaVector<MoveNAG>();
+
+    if ( m_variations.size() == 1 )
+    {
+        /* There are moves of the main line only, they are in order. Extras
+         * are added for the last move, thus they are in order too. */
+        return ;
+    }
+
+    unsigned firstMove = 0;
+    for ( std::size_t v = 0; v < m_variations.size(); ++v )
+    {
+        m_variations[v].firstMove = firstMove;
+        firstMove += m_variations[v].moveCount;
+        m_variations[v].moveCount = 0;
+    }
+
+    /* New index of each move, counters of variations are restored. */
+    unsigned* const newIndexes = m_arena.allocate<unsigned>(m_moves.size());
+    ArenaVector<packed_move_t> moves;
+    moves.reserve(m_moves.size(), m_arena);
+    for ( std::size_t i = 0; i < m_moves.size(); ++i )
+    {
+        moves.push_back(NULL_MOVE, m_arena);
+    }
+    for ( std::size_t i = 0; i < m_moves.size(); ++i )
+    {
+        variation_t const v = ( i < m_moveVariations.size() ) ?
+            m_moveVariations[i] : MAIN_LINE;
+        Variation& variation = m_variations[v];
+        newIndexes[i] = variation.firstMove + variation.moveCount++;
+        moves[newIndexes[i]] = m_moves[i];
+    }
+    m_moves = moves;
+    m_moveVariations = ArenaVector<variation_t>();
+
+    for ( std::size_t i = 0; i < m_moveExtras.size(); ++i )
+    {
+        m_moveExtras[i].move = newIndexes[m_moveExtras[i].move];
+    }
+    if ( !m_moveExtras.empty() )
+    {
+        std::sort(&m_moveExtras[0], &m_moveExtras[0] + m_moveExtras.size(),
+            isBefore);
+    }
+
+    /* Children of each move get a range of the table. */
+    unsigned firstChildVariation = 0;
+    for ( std::size_t i = 0; i < m_moveExtras.size(); ++i )
+    {
+        m_moveExtras[i].firstChildVariation = firstChildVariation;
+        firstChildVariation += m_moveExtras[i].childVariationCount;
+        m_moveExtras[i].childVariationCount = 0;
+    }
+
+    m_childVariations.reserve(m_variations.size() - 1, m_arena);
+    for ( std::size_t v = 1; v < m_variations.size(); ++v )
+    {
+        m_childVariations.push_back(NULL_VARIATION, m_arena);
+    }
+
+    /* Variations are visited in order, thus children of a move are in order
+     * of appearance too. */
+    MoveExtras key;
+    for ( std::size_t v = 1; v < m_variations.size(); ++v )
+    {
+        key.move = newIndexes[m_variations[v].parentMove];
+        m_variations[v].parentMove = key.move;
+        MoveExtras& extras = *std::lower_bound(&m_moveExtras[0],
+            &m_moveExtras[0] + m_moveExtras.size(), key, isBefore);
+        m_childVariations[extras.firstChildVariation +
+            extras.childVariationCount++] = v;
+    }
+}
+
+/* Moves of the variation are created at once, thus the variation is
+ * replayed once. */
+void GameImpl::createMoves(variation_t v) const
+{
+    Variation const& variation = m_variations[v];
+    Board board;
+    bool isPositionKnown = replay(v, 0, board);
+
+    /* Created moves and rendered SAN are a part of the game, like other its
+     * strings. */
+    Arena& arena = const_cast<Arena&>(m_arena);
+    MoveImpl* const moves = arena.allocate<MoveImpl>(variation.moveCount);
+    MoveExtras key;
+    key.move = variation.firstMove;
+    MoveExtras const* extras = std::lower_bound(m_moveExtras.data(),
+        m_moveExtras.data() + m_moveExtras.size(), key, isBefore);
+    MoveExtras const* const extrasEnd = m_moveExtras.data() +
+        m_moveExtras.size();
+    unsigned const firstPly = getFirstPly(v);
+    for ( unsigned i = 0; i < variation.moveCount; ++i )
+    {
+        unsigned const index = variation.firstMove + i;
+        MoveExtras const* moveExtras = NULL;
+        if ( extras != extrasEnd && extras->move == index )
+        {
+            moveExtras = extras++;
+        }
+
+        char const* san = ( moveExtras != NULL ) ? moveExtras->san : NULL;
+        packed_move_t const packedMove = m_moves[index];
+        if ( packedMove == NULL_MOVE )
+        {
+            isPositionKnown = false;
+        } else if ( isPositionKnown )
+        {
+            char text[Board::MAX_SAN_LENGTH + 1];
+            san = arena.copyString(text, board.writeSAN(packedMove, text));
+            board.makeMove(packedMove);
+        }
+
+        new (moves + i) MoveImpl(*this, moveExtras, san,
+            ( firstPly + i ) / 2 + 1, v);
+    }
+
+    variation.moves = moves;
+}
+
+bool GameImpl::replay(variation_t v, std::size_t moveCount,
+    Board& board) const
+{
+    if ( v == MAIN_LINE )
+    {
+        char const* const fen = getTagValue("FEN");
+        if ( fen != NULL && !board.setFEN(fen) )
+        {
+            return false;
+        }
+    } else
+    {
+        /* The variation starts from the position before its parent. */
+        Variation const& variation = m_variations[v];
+        if ( !replay(variation.parentVariation, variation.parentMove -
+            m_variations[variation.parentVariation].firstMove, board) )
+        {
+            return false;
+        }
+    }
+
+    for ( std::size_t i = 0; i < moveCount; ++i )
+    {
+        packed_move_t const packedMove =
+            m_moves[m_variations[v].firstMove + i];
+        if ( packedMove == NULL_MOVE )
+        {
+            return false;
+        }
+        board.makeMove(packedMove);
+    }
+
+    return true;
+}
+
+/* The first move of a variation is an alternative to its parent, thus it is
+ * made at the same ply. */
+unsigned GameImpl::getFirstPly(variation_t v) const
+{
+    if ( v == MAIN_LINE )
+    {
+        return m_firstPly;
+    }
+
+    Variation const& variation = m_variations[v];
+    return getFirstPly(variation.parentVariation) + variation.parentMove -
+        m_variations[variation.parentVariation].firstMove;
+}
+
+const std::size_t GameImpl::ROSTER_TAG_COUNT;
+
+const std::size_t GamePool::MAX_FREE_GAMES;
+
+GamePool::~GamePool()
+{
+    for ( std::size_t i = 0; i < m_freeGames.size(); ++i )
+    {
+        delete m_freeGames[i];
+    }
+}
+
+GameImpl* GamePool::acquire(unsigned sequenceNumber)
+{
+    GameImpl* game = NULL;
+    {
+        boost::mutex::scoped_lock lock(m_freeGamesLock);
+        m_maxLiveGameCount = std::max(m_maxLiveGameCount, ++m_liveGameCount);
+        if ( !m_freeGames.empty() )
+        {
+            game = m_freeGames.back();
+            m_freeGames.pop_back();
+        }
+    }
+
+    if ( game != NULL )
+    {
+        game->reset(sequenceNumber);
+    } else
+    {
+        game = new GameImpl(sequenceNumber);
+    }
+
+    game->m_pool = shared_from_this();
+    return game;
+}
+
+void GamePool::recycle(GameImpl* game)
+{
+    {
+        boost::mutex::scoped_lock lock(m_freeGamesLock);
+        --m_liveGameCount;
+        if ( m_freeGames.size() <
+            std::min(m_maxLiveGameCount, MAX_FREE_GAMES) )
+        {
+            m_freeGames.push_back(game);
+            return ;
+        }
+    }
+
+    delete game;
+}
+
+void MoveTextSource::build(GameImpl& game, PendingMoveText const& moveText)
+{
+    GameBuilder builder(m_isStrict, boost::bind(&MoveTextSource::report, this,
+        moveText.offset, _1, _2, _3, _4), moveText.projection.get());
+    builder.buildMoveText(moveText.region->getData(moveText.offset),
+        moveText.size, game);
+}
+
+void MoveTextSource::detach()
+{
+    boost::unique_lock<boost::shared_mutex> lock(m_reporterLock);
+    m_reporter.clear();
+}
+
+/* Games are built without the lock (errors are rare), it is taken for the
+ * report only. If the parser is destroyed, errors are fixed silently like
+ * without an error handler. */
+bool MoveTextSource::report(unsigned long long moveTextOffset,
+    bool isCritical, syntax_error_t code, wchar_t const* description,
+    std::size_t offset)
+{
+    boost::shared_lock<boost::shared_mutex> lock(m_reporterLock);
+    return m_reporter ?
+        m_reporter(moveTextOffset, isCritical, code, description, offset) :
+        true;
+}
+
+tag_id_t IGame::getTagId(char const* name)
+{
+    return ( name != NULL ) ?
+        TagTable::getInstance().intern(name, std::strlen(name)) : NULL_TAG_ID;
+}
+
+char const* IGame::getTagName(tag_id_t id)
+{
+    return TagTable::getInstance().getName(id);
+}
+
+syntax_error_t IGame::isMoveValid(IMove const* move)
+{
+    if ( move == NULL )
+    {
+        return seUndefinedErrorCode;
+    }
+
+    if ( static_cast<MoveImpl const*>(move)->isIllegal() )
+    {
+        return seIllegalMove;
+    }
+
+    return isSANValid(move->getSAN()) ? seValid : seIllegalMove;
+}
+
+} /* namespace pgn */
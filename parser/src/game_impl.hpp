@@ -0,0 +1,310 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_GAME_IMPL_HPP
+#define PGN_GAME_IMPL_HPP
+
+#include <pgn/game.hpp>
+#include "ref_object_impl.hpp"
+#include "move_impl.hpp"
+#include "arena.hpp"
+#include "board.hpp"
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+namespace pgn
+{
+
+class GamePool;
+class MoveTextSource;
+class Projection;
+
+/* Movetext section of a game which isn't parsed yet. */
+struct PendingMoveText
+{
+    boost::shared_ptr<MoveTextSource> source; /* it parses the movetext */
+    MappedRegionPtr region; /* it keeps the data mapped */
+    unsigned long long offset; /* offset of the movetext in the file */
+    std::size_t size;
+    boost::shared_ptr<Projection const> projection; /* see GameBuilder */
+};
+
+/* A game which is built by GameBuilder. Moves are stored packed (see
+ * packed_move_t): moves of all variations are kept in one array where each
+ * variation is a range. Thus a line is a plain sequence of 16-bit codes
+ * which can be hashed or compared (see getPackedMoves()). A move which
+ * can't be resolved on the board (it is illegal or the position is unknown)
+ * is NULL_MOVE, its SAN is kept as is. Parts which most moves don't have
+ * are kept in a side table (see MoveExtras). IMove objects are created for
+ * a variation when its moves are requested, SAN of its packed moves is
+ * rendered on the board at the same time. Variations of the game are a
+ * tree: each variation except the main line is a child of a move (it is an
+ * alternative to the move). Identifiers of variations are assigned in order
+ * of appearance in the movetext, thus MAIN_LINE is 0. Moves, tag pairs and
+ * strings of the game are allocated in its arena, thus they are released at
+ * once with the game. The movetext section is parsed on demand: methods
+ * which need moves, variations or the result call parseMoveText() first.
+ * Thus a game can't be used by several threads at the same time. */
+class GameImpl : public RefObject<IGame>
+{
+public:
+    explicit GameImpl(unsigned sequenceNumber);
+
+    /* A game from a pool goes back to the pool when it is released. */
+    unsigned release() const;
+
+    unsigned getSequenceNumber() const { return m_sequenceNumber; }
+    char const* getTagEvent() const { return m_rosterTags[tiEvent]; }
+    char const* getTagSite() const { return m_rosterTags[tiSite]; }
+    char const* getTagDate() const { return m_rosterTags[tiDate]; }
+    char const* getTagRound() const { return m_rosterTags[tiRound]; }
+    char const* getTagWhite() const { return m_rosterTags[tiWhite]; }
+    char const* getTagBlack() const { return m_rosterTags[tiBlack]; }
+    char const* getTagResult() const { return m_rosterTags[tiResult]; }
+    char const* getTagValue(char const* name) const;
+    char const* getTagValueById(tag_id_t id) const;
+    unsigned getTagPairCount() const { return m_tagPairs.size(); }
+    tag_pair_t getTagPair(unsigned n) const;
+    game_result_t getResult() const
+    {
+        parseMoveText();
+        return m_result;
+    }
+    char const* getMoveText() const;
+    IMove const* getMove(unsigned n, variation_t v) const;
+    unsigned getMoveCount(variation_t v) const;
+    unsigned getVariationCount() const
+    {
+        parseMoveText();
+        return m_variations.size();
+    }
+    unsigned getVariationCount(IMove const* move) const;
+    variation_t getVariation(IMove const* move, unsigned n) const;
+
+    /* Get packed moves of the variation, the method returns their number.
+     * The array is valid while the game exists. */
+    packed_move_t const* getPackedMoves(variation_t v, unsigned& count) const;
+
+    /* The first syntax error which makes the game invalid. */
+    syntax_error_t getSyntaxError() const
+    {
+        parseMoveText();
+        return m_syntaxError;
+    }
+
+    /* Parse the movetext section if it isn't parsed yet. */
+    void parseMoveText() const
+    {
+        if ( m_pendingMoveText.source )
+        {
+            parsePendingMoveText();
+        }
+    }
+
+    /* Defer parsing of the movetext section until it is needed. */
+    void setPendingMoveText(PendingMoveText const& moveText)
+    {
+        m_pendingMoveText = moveText;
+    }
+
+    /* Methods for GameBuilder. Strings should be allocated in the arena,
+     * except the movetext and comments which should outlive the game (they
+     * are copied on demand). */
+    Arena& getArena() { return m_arena; }
+    void addTagPair(tag_id_t id, char const* name, char const* value);
+    void setMoveText(char const* moveText, std::size_t length)
+    {
+        m_moveText = NULL;
+        m_rawMoveText = moveText;
+        m_rawMoveTextLength = length;
+    }
+    void setResult(game_result_t result) { m_result = result; }
+    void setSyntaxError(syntax_error_t code);
+
+    /* The first move of the main line is made at the ply (0 is the first
+     * white move). Numbers of moves are counted from it. */
+    void setFirstPly(unsigned ply) { m_firstPly = ply; }
+
+    /* Append a move to the variation (NULL_MOVE if the move isn't resolved).
+     * The method returns index of the move. Indexes are valid until
+     * arrangeMoves() is called. */
+    std::size_t addMove(variation_t v, packed_move_t move);
+
+    /* Add extras of the move. The method returns index of them, it is valid
+     * until arrangeMoves() is called. */
+    std::size_t addMoveExtras(std::size_t moveIndex);
+    MoveExtras& getMoveExtras(std::size_t index)
+    {
+        return m_moveExtras[index];
+    }
+    void addNAG(std::size_t extrasIndex, NAG_t nag);
+    /* The comment isn't copied, thus it should outlive the game. */
+    void addComment(std::size_t extrasIndex, char const* comment,
+        std::size_t length);
+
+    /* Create a child variation of the move, its extras keep the child. */
+    variation_t addVariation(std::size_t moveIndex, variation_t parent,
+        std::size_t extrasIndex);
+
+    /* Group moves by variation when all of them are added. */
+    void arrangeMoves();
+
+    /* Methods for MoveImpl. */
+    NAG_t getNAG(std::size_t index) const { return NAG_t(m_nags[index]); }
+    variation_t getChildVariation(std::size_t index) const
+    {
+        return m_childVariations[index];
+    }
+    char const* getComment(MoveExtras const& extras) const;
+
+private:
+    friend class GamePool;
+
+    /* Forget everything about the previous game (see GamePool). */
+    void reset(unsigned sequenceNumber);
+
+    void parsePendingMoveText() const;
+
+    /* Create IMove objects of the variation. */
+    void createMoves(variation_t v) const;
+
+    /* Replay first moves of the variation from the starting position. The
+     * method returns false if the position is unknown. */
+    bool replay(variation_t v, std::size_t moveCount, Board& board) const;
+
+    /* Ply of the first move of the variation. */
+    unsigned getFirstPly(variation_t v) const;
+
+    /* Moves of a variation are a range of m_moves. */
+    struct Variation
+    {
+        unsigned firstMove;
+        unsigned moveCount;
+        unsigned parentMove; /* the variation is an alternative to it */
+        variation_t parentVariation;
+        mutable MoveImpl const* moves; /* NULL if they aren't created */
+    };
+
+    /* A NAG of a move while the game is built. */
+    struct MoveNAG
+    {
+        unsigned extrasIndex;
+        unsigned char nag;
+    };
+
+    static const std::size_t ROSTER_TAG_COUNT = tiResult + 1;
+
+    Arena m_arena; /* it is the first member, thus it is destroyed last */
+    unsigned m_sequenceNumber;
+    ArenaVector<tag_pair_t> m_tagPairs;
+    ArenaVector<tag_id_t> m_tagIds; /* identifier of each tag pair */
+    char const* m_rosterTags[ROSTER_TAG_COUNT]; /* values of STR tags */
+    mutable unsigned m_nextTagPair; /* see getTagPair(NEXT_ITEM) */
+    mutable char const* m_moveText; /* NULL if it isn't copied yet */
+    char const* m_rawMoveText; /* it is in m_moveTextRegion */
+    std::size_t m_rawMoveTextLength;
+    game_result_t m_result;
+    syntax_error_t m_syntaxError;
+    unsigned m_firstPly; /* see setFirstPly() */
+    ArenaVector<packed_move_t> m_moves; /* moves of all variations */
+    ArenaVector<variation_t> m_moveVariations; /* variation of each move
+                                                  while the game is built
+                                                  (empty if all of them are
+                                                  in the main line) */
+    ArenaVector<MoveExtras> m_moveExtras; /* sorted by index of the move */
+    ArenaVector<MoveNAG> m_moveNAGs; /* NAGs while the game is built */
+    ArenaVector<unsigned char> m_nags; /* NAGs of all moves */
+    ArenaVector<Variation> m_variations;
+    ArenaVector<variation_t> m_childVariations; /* children of all moves */
+    mutable PendingMoveText m_pendingMoveText; /* source is NULL if parsed */
+    mutable MappedRegionPtr m_moveTextRegion; /* the parsed movetext */
+    mutable boost::shared_ptr<GamePool> m_pool; /* the game is from it */
+};
+
+/* Games parse their movetext sections with help of the source. It is
+ * shared between the parser and its games, thus a game can outlive the
+ * parser. Errors are reported by the parser while it exists, the parser
+ * detaches itself from the source on destruction. */
+class MoveTextSource
+{
+public:
+    /* The reporter gets offset of the movetext in the file and offset of
+     * the error in the movetext. */
+    typedef boost::function<bool (unsigned long long moveTextOffset,
+        bool isCritical, syntax_error_t code, wchar_t const* description,
+        std::size_t offset)> ErrorReporter;
+
+    MoveTextSource(bool isStrict, ErrorReporter const& reporter) :
+        m_isStrict(isStrict), m_reporter(reporter) {}
+
+    void build(GameImpl& game, PendingMoveText const& moveText);
+
+    /* Stop reporting of errors. The method waits until errors which are
+     * being reported are done. */
+    void detach();
+
+private:
+    bool report(unsigned long long moveTextOffset, bool isCritical,
+        syntax_error_t code, wchar_t const* description, std::size_t offset);
+
+    bool const m_isStrict;
+    boost::shared_mutex m_reporterLock;
+    ErrorReporter m_reporter;
+};
+
+/* Released games are kept by the pool and reused for next games (see
+ * poRecycleGames option). Thus memory stays flat when games are read one by
+ * one or by batches: game objects and their arenas are allocated once. The
+ * pool keeps as many free games as were alive at once (e.g. a batch of
+ * GameRange), thus it doesn't hold more memory than the caller did. The
+ * pool is shared between the parser and its games, thus it lives until both
+ * of them are released. */
+class GamePool : public boost::enable_shared_from_this<GamePool>
+{
+public:
+    /* Limit of free games which are kept. */
+    static const std::size_t MAX_FREE_GAMES = 256;
+
+    GamePool() : m_liveGameCount(0), m_maxLiveGameCount(0) {}
+    ~GamePool();
+
+    /* Get a free game or create a new one. */
+    GameImpl* acquire(unsigned sequenceNumber);
+
+    /* It is called when the game is released. */
+    void recycle(GameImpl* game);
+
+private:
+    boost::mutex m_freeGamesLock;
+    std::vector<GameImpl*> m_freeGames;
+    std::size_t m_liveGameCount; /* games which were acquired */
+    std::size_t m_maxLiveGameCount;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_GAME_IMPL_HPP */
@@ -0,0 +1,240 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game_index.hpp"
+
+#include <algorithm>
+
+namespace pgn
+{
+
+namespace
+{
+
+const unsigned WORD_BITS = 64;
+
+/* Number of bits which are required to store the value. */
+unsigned getBitWidth(boost::uint64_t value)
+{
+    unsigned width = 0;
+    while ( value != 0 )
+    {
+        ++width;
+        value >>= 1;
+    }
+
+    return width;
+}
+
+} /* unnamed namespace */
+
+const std::size_t GameIndex::BLOCK_SIZE;
+
+GameInFile GameIndex::operator[](std::size_t gameN) const
+{
+    GameInFile game;
+    std::size_t const sealedCount = m_blocks.size() * BLOCK_SIZE;
+    if ( gameN < sealedCount )
+    {
+        Block const& block = m_blocks[gameN / BLOCK_SIZE];
+        boost::uint64_t const bitOffset = block.bitOffset +
+            ( gameN % BLOCK_SIZE ) * ( block.offsetBits + block.moveTextBits );
+        game.offset[goTagPairSection] = block.base +
+            readBits(bitOffset, block.offsetBits);
+        game.offset[goMoveTextSection] = game.offset[goTagPairSection] +
+            readBits(bitOffset + block.offsetBits, block.moveTextBits);
+    } else
+    {
+        Entry const& entry = m_tail[gameN - sealedCount];
+        game.offset[goTagPairSection] = entry.offset[goTagPairSection];
+        game.offset[goMoveTextSection] = entry.offset[goMoveTextSection];
+    }
+
+    unsigned long long const end = ( gameN + 1 == size() ) ? m_lastGameEnd :
+        getGameOffset(gameN + 1);
+    game.size = static_cast<unsigned>(end - game.offset[goTagPairSection]);
+
+    game.quickhash = m_quickhashes[gameN];
+    game.isSelected = !m_selectedGames.empty() && std::binary_search(
+        m_selectedGames.begin(), m_selectedGames.end(), gameN);
+    return game;
+}
+
+void GameIndex::push_back(GameInFile const& game)
+{
+    Entry entry;
+    entry.offset[goTagPairSection] = game.offset[goTagPairSection];
+    entry.offset[goMoveTextSection] = game.offset[goMoveTextSection];
+    m_tail.push_back(entry);
+    m_lastGameEnd = game.offset[goTagPairSection] + game.size;
+    m_quickhashes.push_back(game.quickhash);
+    if ( game.isSelected )
+    {
+        m_selectedGames.push_back(static_cast<boost::uint32_t>(size() - 1));
+    }
+
+    if ( m_tail.size() == BLOCK_SIZE )
+    {
+        sealTail();
+    }
+}
+
+void GameIndex::pop_back()
+{
+    if ( m_tail.empty() )
+    {
+        unsealLastBlock();
+    }
+
+    if ( !m_selectedGames.empty() && m_selectedGames.back() + 1 == size() )
+    {
+        m_selectedGames.pop_back();
+    }
+    m_lastGameEnd = m_tail.back().offset[goTagPairSection];
+    m_tail.pop_back();
+    m_quickhashes.pop_back();
+}
+
+void GameIndex::clear()
+{
+    GameIndex().swap(*this);
+}
+
+void GameIndex::swap(GameIndex& other)
+{
+    m_blocks.swap(other.m_blocks);
+    m_bits.swap(other.m_bits);
+    std::swap(m_bitCount, other.m_bitCount);
+    m_tail.swap(other.m_tail);
+    std::swap(m_lastGameEnd, other.m_lastGameEnd);
+    m_quickhashes.swap(other.m_quickhashes);
+    m_selectedGames.swap(other.m_selectedGames);
+}
+
+unsigned long long GameIndex::getGameOffset(std::size_t gameN) const
+{
+    std::size_t const sealedCount = m_blocks.size() * BLOCK_SIZE;
+    if ( gameN >= sealedCount )
+    {
+        return m_tail[gameN - sealedCount].offset[goTagPairSection];
+    }
+
+    Block const& block = m_blocks[gameN / BLOCK_SIZE];
+    return block.base + readBits(block.bitOffset + ( gameN % BLOCK_SIZE ) *
+        ( block.offsetBits + block.moveTextBits ), block.offsetBits);
+}
+
+void GameIndex::sealTail()
+{
+    Block block;
+    block.base = m_tail.front().offset[goTagPairSection];
+    block.bitOffset = m_bitCount;
+
+    boost::uint64_t maxOffsetDelta = 0;
+    boost::uint64_t maxMoveTextDelta = 0;
+    for ( std::size_t i = 0; i < m_tail.size(); ++i )
+    {
+        Entry const& entry = m_tail[i];
+        maxOffsetDelta = std::max<boost::uint64_t>(maxOffsetDelta,
+            entry.offset[goTagPairSection] - block.base);
+        maxMoveTextDelta = std::max<boost::uint64_t>(maxMoveTextDelta,
+            entry.offset[goMoveTextSection] - entry.offset[goTagPairSection]);
+    }
+    block.offsetBits = static_cast<unsigned char>(getBitWidth(maxOffsetDelta));
+    block.moveTextBits = static_cast<unsigned char>(
+        getBitWidth(maxMoveTextDelta));
+
+    for ( std::size_t i = 0; i < m_tail.size(); ++i )
+    {
+        Entry const& entry = m_tail[i];
+        appendBits(entry.offset[goTagPairSection] - block.base,
+            block.offsetBits);
+        appendBits(entry.offset[goMoveTextSection] -
+            entry.offset[goTagPairSection], block.moveTextBits);
+    }
+
+    m_blocks.push_back(block);
+    m_tail.clear();
+}
+
+void GameIndex::unsealLastBlock()
+{
+    std::size_t const first = ( m_blocks.size() - 1 ) * BLOCK_SIZE;
+    std::vector<Entry> tail(BLOCK_SIZE);
+    for ( std::size_t i = 0; i < BLOCK_SIZE; ++i )
+    {
+        GameInFile const game = (*this)[first + i];
+        tail[i].offset[goTagPairSection] = game.offset[goTagPairSection];
+        tail[i].offset[goMoveTextSection] = game.offset[goMoveTextSection];
+    }
+
+    m_bitCount = m_blocks.back().bitOffset;
+    m_bits.resize(static_cast<std::size_t>(
+        ( m_bitCount + WORD_BITS - 1 ) / WORD_BITS));
+    unsigned const usedBits = static_cast<unsigned>(m_bitCount % WORD_BITS);
+    if ( usedBits != 0 )
+    {
+        m_bits.back() &= ( boost::uint64_t(1) << usedBits ) - 1;
+    }
+
+    m_blocks.pop_back();
+    m_tail.swap(tail);
+}
+
+boost::uint64_t GameIndex::readBits(boost::uint64_t bitOffset,
+    unsigned width) const
+{
+    if ( width == 0 )
+    {
+        return 0;
+    }
+
+    std::size_t const word = static_cast<std::size_t>(bitOffset / WORD_BITS);
+    unsigned const shift = static_cast<unsigned>(bitOffset % WORD_BITS);
+    boost::uint64_t value = m_bits[word] >> shift;
+    if ( shift + width > WORD_BITS )
+    {
+        value |= m_bits[word + 1] << ( WORD_BITS - shift );
+    }
+
+    return width == WORD_BITS ? value :
+        value & ( ( boost::uint64_t(1) << width ) - 1 );
+}
+
+void GameIndex::appendBits(boost::uint64_t value, unsigned width)
+{
+    if ( width == 0 )
+    {
+        return ;
+    }
+
+    unsigned const shift = static_cast<unsigned>(m_bitCount % WORD_BITS);
+    if ( shift == 0 )
+    {
+        m_bits.push_back(0);
+    }
+    m_bits.back() |= value << shift;
+    if ( shift + width > WORD_BITS )
+    {
+        m_bits.push_back(value >> ( WORD_BITS - shift ));
+    }
+    m_bitCount += width;
+}
+
+} /* namespace pgn */
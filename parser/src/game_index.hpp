@@ -0,0 +1,132 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_GAME_INDEX_HPP
+#define PGN_GAME_INDEX_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+namespace pgn
+{
+
+typedef enum
+{
+    goTagPairSection,
+    goMoveTextSection,
+    goGameOffsetCount
+} game_offset_t;
+
+/* Position of a game in the PGN file. We should include quickhash field
+ * because we want to detect cases than a requested game was changed on
+ * disk. The main purpose of the field is to prevent incorrect parsing
+ * of PGN file in case our cache isn't up to date. */
+struct GameInFile
+{
+    GameInFile() : quickhash(), size(), isSelected()
+    {
+        offset[goTagPairSection] = offset[goMoveTextSection] = 0;
+    }
+
+    unsigned quickhash; /* check that the game was not changed */
+    unsigned long long offset[goGameOffsetCount];
+    unsigned size; /* size of the game in bytes */
+    bool isSelected; /* the game satisfies the tag filter of the parser */
+};
+
+/* Positions of all games in the PGN file. The index should be as minimal as
+ * possible because it contains information for all games, thus GameInFile
+ * isn't stored as is:
+ *  - games are contiguous (a game ends where the next one starts), thus
+ *    only the end of the last game is stored;
+ *  - games are grouped by blocks of BLOCK_SIZE games. A block has base
+ *    offset, offsets of its games are stored as bit packed deltas from the
+ *    base. Offset of movetext is stored as delta from offset of the game.
+ *    Width of the deltas is chosen per block;
+ *  - quickhash is stored in a separate array.
+ * Usually it takes 7-9 bytes per game (including 4 bytes of quickhash). Any
+ * game can be accessed in O(1). The last (incomplete) block is stored as is
+ * until it is filled up. Selected games are a sorted list of their
+ * numbers, it is a filtered index of the file. The index file contains the
+ * same arrays (see IndexFile). */
+class GameIndex
+{
+public:
+    static const std::size_t BLOCK_SIZE = 64; /* games */
+
+    GameIndex() : m_bitCount(0), m_lastGameEnd(0) {}
+
+    std::size_t size() const
+    {
+        return m_blocks.size() * BLOCK_SIZE + m_tail.size();
+    }
+    bool empty() const { return m_blocks.empty() && m_tail.empty(); }
+
+    GameInFile operator[](std::size_t gameN) const;
+    GameInFile back() const { return (*this)[size() - 1]; }
+
+    /* Append a game. It has to start where the previous game ends. */
+    void push_back(GameInFile const& game);
+
+    /* Remove the last game. */
+    void pop_back();
+
+    /* Zero-based numbers of selected games. */
+    std::size_t getSelectedCount() const { return m_selectedGames.size(); }
+    std::size_t getSelected(std::size_t n) const { return m_selectedGames[n]; }
+
+    void clear();
+    void swap(GameIndex& other);
+
+private:
+    friend class IndexFile; /* it stores the encoded index as is */
+
+    struct Block
+    {
+        boost::uint64_t base; /* offset of the first game of the block */
+        boost::uint64_t bitOffset; /* deltas of the block in m_bits */
+        unsigned char offsetBits; /* width of delta of game offset */
+        unsigned char moveTextBits; /* width of delta of movetext offset */
+    };
+
+    struct Entry
+    {
+        unsigned long long offset[goGameOffsetCount];
+    };
+
+    unsigned long long getGameOffset(std::size_t gameN) const;
+    void sealTail();
+    void unsealLastBlock();
+    boost::uint64_t readBits(boost::uint64_t bitOffset, unsigned width) const;
+    void appendBits(boost::uint64_t value, unsigned width);
+
+    std::vector<Block> m_blocks;
+    std::vector<boost::uint64_t> m_bits; /* deltas of all blocks */
+    boost::uint64_t m_bitCount; /* number of used bits in m_bits */
+    std::vector<Entry> m_tail; /* games which are not in a block yet */
+    unsigned long long m_lastGameEnd;
+    std::vector<boost::uint32_t> m_quickhashes;
+    std::vector<boost::uint32_t> m_selectedGames;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_GAME_INDEX_HPP */
@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game_range.hpp>
+
+#include <algorithm>
+
+namespace pgn
+{
+
+const unsigned GameRange::DEFAULT_BATCH_SIZE;
+
+GameRange::GameRange(IParser* parser, unsigned options, unsigned batchSize)
+    : m_parser(parser), m_options(options),
+    m_batchSize(std::max(batchSize, 1U)),
+    m_batch(new IGame const*[m_batchSize]), m_gameCount(0), m_position(0),
+    m_next(1), m_isStarted(false)
+{
+    m_parser->addRef();
+}
+
+GameRange::~GameRange()
+{
+    releaseBatch();
+    delete[] m_batch;
+    m_parser->release();
+}
+
+GameRange::iterator GameRange::begin()
+{
+    if ( !m_isStarted )
+    {
+        m_isStarted = true;
+        readBatch();
+    }
+
+    return iterator(this);
+}
+
+/* Games of the previous batch are released before the next one is read,
+ * thus recycled games (see poRecycleGames) are reused by the batch. */
+void GameRange::readBatch()
+{
+    releaseBatch();
+    m_position = 0;
+    m_gameCount = readGames(m_next, m_batch, false);
+    m_next += m_gameCount;
+    if ( m_gameCount != 0 && ( m_options & roPrefetch ) )
+    {
+        readGames(m_next, NULL, true);
+    }
+}
+
+/* Read (or prefetch) a batch of games which starts from next. Selected
+ * games are read by runs of consecutive games. The method returns number
+ * of games in the batch. */
+unsigned GameRange::readGames(unsigned next, IGame const** games,
+    bool isPrefetch)
+{
+    if ( !( m_options & roSelectedOnly ) )
+    {
+        if ( isPrefetch )
+        {
+            m_parser->prefetchGames(next, m_batchSize);
+            return m_batchSize;
+        }
+
+        return m_parser->readGames(next, m_batchSize, games);
+    }
+
+    unsigned count = 0;
+    unsigned gameN = m_parser->getSelectedGame(next);
+    while ( count < m_batchSize && gameN != 0 )
+    {
+        unsigned runLength = 1;
+        unsigned nextGameN = m_parser->getSelectedGame(next + count + 1);
+        while ( count + runLength < m_batchSize &&
+            nextGameN == gameN + runLength )
+        {
+            ++runLength;
+            nextGameN = m_parser->getSelectedGame(next + count + runLength);
+        }
+
+        if ( isPrefetch )
+        {
+            m_parser->prefetchGames(gameN, runLength);
+        } else
+        {
+            unsigned const readCount = m_parser->readGames(gameN, runLength,
+                games + count);
+            if ( readCount != runLength )
+            {
+                /* The file was truncated. */
+                return count + readCount;
+            }
+        }
+
+        count += runLength;
+        gameN = nextGameN;
+    }
+
+    return count;
+}
+
+void GameRange::releaseBatch()
+{
+    for ( unsigned i = 0; i < m_gameCount; ++i )
+    {
+        m_batch[i]->release();
+    }
+    m_gameCount = 0;
+}
+
+} /* namespace pgn */
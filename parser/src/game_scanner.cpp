@@ -0,0 +1,415 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game_scanner.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+
+#include <boost/thread/thread.hpp>
+
+namespace pgn
+{
+
+void GameScanner::reset(unsigned long long offset)
+{
+    m_state = ssLineStart;
+    m_isFirstColumn = true;
+    m_isTagPairSection = false;
+    m_isMoveTextFound = false;
+    m_hasGame = false;
+    m_offset = offset;
+    m_lineOffset = offset;
+    m_game = GameInFile();
+    m_hash.reset();
+    m_matches.assign(( m_filter != NULL ) ? m_filter->getPredicateCount() : 0,
+        false);
+    m_tagLine.clear();
+}
+
+void GameScanner::scan(char const* data, std::size_t size, GameList& games)
+{
+    doScan(data, size, games, false);
+}
+
+/* The method scans till the end of data. If isStopOnGame is true it stops
+ * right after the first tag pair of a new game. It returns number of
+ * scanned bytes. */
+std::size_t GameScanner::doScan(char const* data, std::size_t size,
+    GameList& games, bool isStopOnGame)
+{
+    char const* it = data;
+    char const* const end = data + size;
+    unsigned long long const base = m_offset;
+    bool isGameFound = false;
+    char const* hashed = data; /* the rest of data isn't hashed yet */
+    char const* tagLine = data; /* the tag pair line (see ssTagPair) */
+
+    while ( it != end && !isGameFound )
+    {
+        switch ( m_state )
+        {
+        case ssLineStart:
+        {
+            char const ch = *it;
+            if ( ch == ' ' || ch == '\t' || ch == '\r' || ch == '\v' ||
+                ch == '\f' )
+            {
+                m_isFirstColumn = false;
+                ++it;
+            } else if ( ch == '\n' )
+            {
+                onMoveText(true);
+                ++it;
+                m_isFirstColumn = true;
+                m_lineOffset = base + ( it - data );
+            } else if ( ch == '[' )
+            {
+                if ( !m_isTagPairSection )
+                {
+                    /* The tag pair will start a new game. */
+                    hashGameData(hashed, it);
+                    hashed = it;
+                }
+                isGameFound = onTagPair(base + ( it - data ), games) &&
+                    isStopOnGame;
+                tagLine = it;
+                m_state = ( m_filter != NULL ) ? ssTagPair : ssSkipLine;
+                ++it;
+            } else if ( ch == '%' && m_isFirstColumn )
+            {
+                /* There is a special escape mechanism for PGN data. This
+                 * mechanism is triggered by a percent sign character ("%")
+                 * appearing in the first column of a line; the data on the
+                 * rest of the line is ignored. */
+                m_state = ssSkipLine;
+                ++it;
+            } else
+            {
+                onMoveText(false);
+                m_state = ssMoveText;
+            }
+            break;
+        }
+
+        case ssMoveText:
+        {
+            /* Brace comments do not nest; a left brace character appearing
+             * in a brace comment loses its special meaning and is ignored.
+             * A semicolon appearing inside of a brace comment loses its
+             * special meaning and is ignored. Braces appearing inside of a
+             * semicolon comments lose their special meaning and are
+             * ignored. */
+            it = simd::findFirstOf(it, end, '\n', '{', ';');
+            if ( it != end )
+            {
+                if ( *it == '\n' )
+                {
+                    m_state = ssLineStart;
+                    m_isFirstColumn = true;
+                    m_lineOffset = base + ( it + 1 - data );
+                } else if ( *it == '{' )
+                {
+                    m_state = ssBraceComment;
+                } else
+                {
+                    m_state = ssSkipLine;
+                }
+                ++it;
+            }
+            break;
+        }
+
+        case ssBraceComment:
+        {
+            it = simd::find(it, end, '}');
+            if ( it != end )
+            {
+                m_state = ssMoveText;
+                ++it;
+            }
+            break;
+        }
+
+        case ssTagPair:
+        {
+            it = simd::find(it, end, '\n');
+            if ( it != end )
+            {
+                /* The line can be split by pieces, then it is collected. */
+                if ( m_tagLine.empty() )
+                {
+                    m_filter->checkTagLine(tagLine, it, m_matches);
+                } else
+                {
+                    m_tagLine.append(tagLine, it);
+                    m_filter->checkTagLine(m_tagLine.data(),
+                        m_tagLine.data() + m_tagLine.size(), m_matches);
+                    m_tagLine.clear();
+                }
+                ++it;
+                m_state = ssLineStart;
+                m_isFirstColumn = true;
+                m_lineOffset = base + ( it - data );
+            }
+            break;
+        }
+
+        case ssSkipLine:
+        {
+            it = simd::find(it, end, '\n');
+            if ( it != end )
+            {
+                ++it;
+                m_state = ssLineStart;
+                m_isFirstColumn = true;
+                m_lineOffset = base + ( it - data );
+            }
+            break;
+        }
+        }
+    }
+
+    hashGameData(hashed, it);
+    if ( m_state == ssTagPair )
+    {
+        m_tagLine.append(tagLine, it);
+    }
+    m_offset = base + ( it - data );
+    return it - data;
+}
+
+/* Results of a chunk which is scanned in parallel. */
+struct GameScanner::Chunk
+{
+    char const* begin; /* the chunk itself */
+    char const* end;
+    char const* sync; /* the first game in the chunk or NULL */
+    GameScanner scanner; /* state of the scanner at the end of the chunk */
+    GameList games; /* games which were completed inside the chunk */
+};
+
+class GameScanner::ChunkWorker
+{
+public:
+    ChunkWorker(Chunk& chunk, char const* data, unsigned long long base)
+        : m_chunk(chunk), m_data(data), m_base(base) {}
+
+    void operator()()
+    {
+        m_chunk.sync = findGameStart();
+        if ( m_chunk.sync != NULL )
+        {
+            m_chunk.scanner.reset(m_base + ( m_chunk.sync - m_data ));
+            m_chunk.scanner.scan(m_chunk.sync, m_chunk.end - m_chunk.sync,
+                m_chunk.games);
+        }
+    }
+
+private:
+    /* A tag pair in the first column after an empty line. It is the way
+     * as games are separated in export format. Any other heuristic will
+     * produce the same result, because it is verified later. */
+    char const* findGameStart() const
+    {
+        char const* it = m_chunk.begin;
+        while ( ( it = simd::find(it, m_chunk.end, '[') ) != m_chunk.end )
+        {
+            char const* prev = it;
+            if ( prev > m_data && *--prev == '\n' )
+            {
+                if ( prev > m_data && *( prev - 1 ) == '\r' )
+                {
+                    --prev;
+                }
+                if ( prev > m_data && *--prev == '\n' )
+                {
+                    return it;
+                }
+            }
+            ++it;
+        }
+
+        return NULL;
+    }
+
+    Chunk& m_chunk;
+    char const* m_data;
+    unsigned long long m_base;
+};
+
+void GameScanner::scanInParallel(char const* data, std::size_t size,
+    unsigned threadCount, GameList& games)
+{
+    /* Small chunks don't give any benefit. */
+    static const std::size_t MIN_CHUNK_SIZE = 1024 * 1024;
+    if ( threadCount > size / MIN_CHUNK_SIZE )
+    {
+        threadCount = static_cast<unsigned>(size / MIN_CHUNK_SIZE);
+    }
+
+    if ( threadCount <= 1 )
+    {
+        scan(data, size, games);
+        return ;
+    }
+
+    /* The first chunk is scanned by the scanner itself because its state is
+     * known. Other chunks are scanned by workers. */
+    std::vector<Chunk> chunks(threadCount);
+    for ( unsigned i = 0; i < threadCount; ++i )
+    {
+        chunks[i].scanner.setFilter(m_filter);
+        chunks[i].begin = data + size / threadCount * i;
+        chunks[i].end = ( i + 1 == threadCount ) ? data + size :
+            data + size / threadCount * ( i + 1 );
+        chunks[i].sync = NULL;
+    }
+
+    boost::thread_group workers;
+    for ( unsigned i = 1; i < threadCount; ++i )
+    {
+        workers.create_thread(ChunkWorker(chunks[i], data, m_offset));
+    }
+    scan(chunks[0].begin, chunks[0].end - chunks[0].begin, games);
+    workers.join_all();
+
+    for ( unsigned i = 1; i < threadCount; ++i )
+    {
+        Chunk& chunk = chunks[i];
+        if ( chunk.sync == NULL )
+        {
+            /* The worker didn't find a game, thus the chunk is scanned
+             * sequentially. */
+            scan(chunk.begin, chunk.end - chunk.begin, games);
+            continue;
+        }
+
+        unsigned long long const syncOffset = m_offset +
+            ( chunk.sync - chunk.begin );
+        char const* it = chunk.begin;
+        while ( it != chunk.end )
+        {
+            it += doScan(it, chunk.end - it, games, true);
+            if ( m_offset == syncOffset + 1 &&
+                m_game.offset[goTagPairSection] == syncOffset )
+            {
+                /* Both scanners are in the same state just after the first
+                 * tag pair of the game. */
+                for ( std::size_t j = 0; j < chunk.games.size(); ++j )
+                {
+                    games.push_back(chunk.games[j]);
+                }
+                *this = chunk.scanner;
+                break;
+            }
+
+            if ( it > chunk.sync )
+            {
+                /* The worker was wrong. Usually it means that its game start
+                 * is inside a comment. */
+                scan(it, chunk.end - it, games);
+                break;
+            }
+        }
+    }
+}
+
+void GameScanner::finish(GameList& games)
+{
+    if ( m_state == ssTagPair )
+    {
+        /* The last line of the file isn't terminated. */
+        m_filter->checkTagLine(m_tagLine.data(),
+            m_tagLine.data() + m_tagLine.size(), m_matches);
+    }
+
+    if ( m_hasGame )
+    {
+        if ( !m_isMoveTextFound )
+        {
+            m_game.offset[goMoveTextSection] = m_offset;
+        }
+        completeGame(m_offset, games);
+    }
+
+    reset(m_offset);
+}
+
+/* A tag pair after movetext (or in the beginning of the file) starts a new
+ * game and completes the previous one. */
+bool GameScanner::onTagPair(unsigned long long offset, GameList& games)
+{
+    bool isNewGame = false;
+
+    if ( !m_isTagPairSection )
+    {
+        if ( m_hasGame )
+        {
+            completeGame(offset, games);
+        }
+
+        m_game = GameInFile();
+        m_hash.reset();
+        std::fill(m_matches.begin(), m_matches.end(), false);
+        m_game.offset[goTagPairSection] = offset;
+        m_hasGame = true;
+        m_isTagPairSection = true;
+        isNewGame = true;
+    }
+
+    m_isMoveTextFound = false;
+    return isNewGame;
+}
+
+/* The game ends at given offset in the file. */
+void GameScanner::completeGame(unsigned long long end, GameList& games)
+{
+    m_game.size = static_cast<unsigned>(end - m_game.offset[goTagPairSection]);
+    m_game.quickhash = m_hash.finish();
+    m_game.isSelected = m_filter != NULL && m_filter->isSelected(m_matches);
+    games.push_back(m_game);
+}
+
+/* Bytes between games (e.g. before the first game) aren't hashed. */
+void GameScanner::hashGameData(char const* begin, char const* end)
+{
+    if ( m_hasGame )
+    {
+        m_hash.update(begin, end - begin);
+    }
+}
+
+/* Movetext section of the game starts right after the last tag pair. Empty
+ * lines don't finish the tag pair section, but any other text does. */
+void GameScanner::onMoveText(bool isEmptyLine)
+{
+    if ( m_isTagPairSection && !m_isMoveTextFound )
+    {
+        m_game.offset[goMoveTextSection] = m_lineOffset;
+        m_isMoveTextFound = true;
+    }
+
+    if ( !isEmptyLine )
+    {
+        m_isTagPairSection = false;
+    }
+}
+
+} /* namespace pgn */
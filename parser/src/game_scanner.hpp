@@ -0,0 +1,118 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_GAME_SCANNER_HPP
+#define PGN_GAME_SCANNER_HPP
+
+#include "game_index.hpp"
+#include "quick_hash.hpp"
+#include "tag_filter.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace pgn
+{
+
+/* The class is used for light weight parsing of PGN file. It finds
+ * boundaries of games without any backtracking: a game starts with the first
+ * tag pair (a line which starts with '[') after movetext of the previous
+ * game. Brace comments, rest of line comments and escaped lines (%) are
+ * skipped because they can contain anything. Inside the scanner is a state
+ * machine, thus a file can be scanned by pieces of arbitrary size. The state
+ * is kept between calls of scan(). Long runs of uninteresting bytes are
+ * skipped using vectorized search (see simd.hpp). Quickhash of each game is
+ * computed on the fly. If a tag filter is set then tag pair lines are
+ * checked by it on the fly too, and selected games are marked in the
+ * index. */
+class GameScanner
+{
+public:
+    typedef GameIndex GameList;
+
+    GameScanner() : m_filter(NULL) { reset(0); }
+
+    /* Start scanning from the beginning of a line at given offset in file. */
+    void reset(unsigned long long offset);
+
+    /* The filter should outlive the scanner. It isn't changed by reset(). */
+    void setFilter(TagFilter const* filter)
+    {
+        m_filter = filter;
+        reset(m_offset);
+    }
+
+    /* Scan next piece of data. The piece has to follow the previous one in
+     * the file. Each game which is completed inside the piece is appended to
+     * games. The last game in the file is completed by finish() only. */
+    void scan(char const* data, std::size_t size, GameList& games);
+
+    /* Scan next piece of data using several threads. The piece is split into
+     * threadCount chunks. Each thread finds the first game in its chunk
+     * which starts after an empty line and scans from it. Then results are
+     * stitched sequentially: a chunk is accepted only if the scanner of the
+     * previous chunk gets into the same game start. Otherwise (e.g. the game
+     * start was inside a brace comment) the chunk is rescanned. The result is
+     * the same as scan() produces. */
+    void scanInParallel(char const* data, std::size_t size,
+        unsigned threadCount, GameList& games);
+
+    /* Complete the last game. It should be called at the end of file. */
+    void finish(GameList& games);
+
+    /* Get offset in the file of the next byte to scan. */
+    unsigned long long getOffset() const { return m_offset; }
+
+private:
+    typedef enum
+    {
+        ssLineStart,    /* beginning of a line (leading spaces are skipped) */
+        ssMoveText,     /* movetext of a game or garbage between games */
+        ssBraceComment, /* inside {...} comment */
+        ssTagPair,      /* tag pair line which is checked by the filter */
+        ssSkipLine      /* tag pair, rest of line comment or escaped line */
+    } scanner_state_t;
+
+    struct Chunk;
+    class ChunkWorker;
+
+    std::size_t doScan(char const* data, std::size_t size, GameList& games,
+        bool isStopOnGame);
+    bool onTagPair(unsigned long long offset, GameList& games);
+    void completeGame(unsigned long long end, GameList& games);
+    void hashGameData(char const* begin, char const* end);
+    void onMoveText(bool isEmptyLine);
+
+    scanner_state_t m_state;
+    bool m_isFirstColumn; /* nothing was skipped in the line yet */
+    bool m_isTagPairSection; /* the last non-empty line was a tag pair */
+    bool m_isMoveTextFound; /* offset of movetext is known for the game */
+    bool m_hasGame; /* at least one game was found */
+    unsigned long long m_offset; /* offset of next byte in the file */
+    unsigned long long m_lineOffset; /* offset of the current line */
+    GameInFile m_game; /* the game which is being scanned now */
+    QuickHash m_hash; /* quickhash of scanned bytes of m_game */
+    TagFilter const* m_filter; /* NULL if games aren't selected */
+    TagFilter::Matches m_matches; /* predicates satisfied by m_game */
+    std::string m_tagLine; /* the tag pair line which is split by pieces */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_GAME_SCANNER_HPP */
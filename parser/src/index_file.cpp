@@ -0,0 +1,323 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "index_file.hpp"
+#include "quick_hash.hpp"
+
+#include <climits>
+#include <cstring>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+namespace pgn
+{
+
+namespace
+{
+
+const char INDEX_FILE_EXTENSION[] = ".idx";
+const char INDEX_FILE_MAGIC[8] = { 'P', 'G', 'N', 'I', 'N', 'D', 'E', 'X' };
+const boost::uint32_t INDEX_FILE_VERSION = 3; /* encoded GameIndex */
+const boost::uint32_t INDEX_FILE_BYTE_ORDER = 0x01020304;
+const std::size_t SAMPLE_SIZE = 16; /* number of games for checking */
+const unsigned WORD_BITS = 64;
+
+/* All fields are naturally aligned, thus there is no padding. The file is
+ * written in native byte order. The header is followed by arrays of
+ * GameIndex: blocks, words of deltas, games of the last (incomplete) block
+ * and quickhashes. Thus the index is loaded without decoding of games. */
+struct IndexFileHeader
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t byteOrder;
+    boost::uint32_t recordSize; /* size of IndexFileBlock */
+    boost::uint32_t reserved;
+    boost::uint64_t pgnSize;
+    boost::int64_t pgnModificationTime;
+    boost::uint64_t gameCount;
+    boost::uint64_t bitCount; /* number of used bits of deltas */
+    boost::uint64_t lastGameEnd;
+};
+
+struct IndexFileBlock
+{
+    boost::uint64_t base;
+    boost::uint64_t bitOffset;
+    boost::uint8_t offsetBits;
+    boost::uint8_t moveTextBits;
+    boost::uint8_t reserved[6];
+};
+
+struct IndexFileEntry
+{
+    boost::uint64_t offset[goGameOffsetCount];
+};
+
+template <typename T> bool writeArray(std::FILE* file, T const* data,
+    std::size_t count)
+{
+    return count == 0 || std::fwrite(data, sizeof(T), count, file) == count;
+}
+
+/* Number of n-th game in the sample of games. */
+std::size_t getSampleGame(std::size_t n, std::size_t gameCount)
+{
+    if ( gameCount <= SAMPLE_SIZE )
+    {
+        return n;
+    }
+
+    return n * ( gameCount - 1 ) / ( SAMPLE_SIZE - 1 );
+}
+
+std::size_t getSampleSize(std::size_t gameCount)
+{
+    return gameCount < SAMPLE_SIZE ? gameCount : SAMPLE_SIZE;
+}
+
+} /* unnamed namespace */
+
+IndexFile::IndexFile(FilePath const& pgnfile)
+    : m_path(pgnfile.withSuffix(INDEX_FILE_EXTENSION))
+{
+    m_isPgnFileInfoValid = getFileInfo(pgnfile, m_pgnFileInfo);
+}
+
+void IndexFile::setPgnFileInfo(FileInfo const& info)
+{
+    m_pgnFileInfo = info;
+    m_isPgnFileInfoValid = true;
+}
+
+bool IndexFile::load(MappedFile const& pgnfile,
+    GameScanner::GameList& games) const
+{
+    if ( !m_isPgnFileInfoValid || m_pgnFileInfo.size != pgnfile.getFileSize() )
+    {
+        return false;
+    }
+
+    /* The file is mapped, thus only the header and the sample of games are
+     * read from disk before arrays of the index are copied. */
+    boost::iostreams::mapped_file_source file;
+    try
+    {
+        openMappedFile(file, m_path);
+    } catch ( std::exception const& )
+    {
+        return false;
+    }
+
+    IndexFileHeader header;
+    if ( file.size() < sizeof(header) )
+    {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    std::size_t const dataSize = file.size() - sizeof(header);
+    if ( std::memcmp(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic)) ||
+        header.version != INDEX_FILE_VERSION ||
+        header.byteOrder != INDEX_FILE_BYTE_ORDER ||
+        header.recordSize != sizeof(IndexFileBlock) ||
+        header.pgnSize != m_pgnFileInfo.size ||
+        header.pgnModificationTime != m_pgnFileInfo.modificationTime ||
+        header.gameCount > dataSize / sizeof(boost::uint32_t) ||
+        header.bitCount / CHAR_BIT > dataSize ||
+        header.lastGameEnd > header.pgnSize )
+    {
+        return false;
+    }
+
+    std::size_t const gameCount = static_cast<std::size_t>(header.gameCount);
+    std::size_t const blockCount = gameCount / GameIndex::BLOCK_SIZE;
+    std::size_t const tailCount = gameCount % GameIndex::BLOCK_SIZE;
+    std::size_t const wordCount = static_cast<std::size_t>(
+        ( header.bitCount + WORD_BITS - 1 ) / WORD_BITS);
+    if ( dataSize != blockCount * sizeof(IndexFileBlock) +
+        wordCount * sizeof(boost::uint64_t) +
+        tailCount * sizeof(IndexFileEntry) +
+        gameCount * sizeof(boost::uint32_t) )
+    {
+        return false;
+    }
+
+    char const* data = file.data() + sizeof(header);
+    IndexFileBlock const* const blocks =
+        reinterpret_cast<IndexFileBlock const*>(data);
+    data += blockCount * sizeof(IndexFileBlock);
+    boost::uint64_t const* const words =
+        reinterpret_cast<boost::uint64_t const*>(data);
+    data += wordCount * sizeof(boost::uint64_t);
+    IndexFileEntry const* const tail =
+        reinterpret_cast<IndexFileEntry const*>(data);
+    data += tailCount * sizeof(IndexFileEntry);
+    boost::uint32_t const* const quickhashes =
+        reinterpret_cast<boost::uint32_t const*>(data);
+
+    /* Deltas of a block should be inside of the used bits, otherwise a
+     * corrupted index is read out of bounds. Deltas themselves aren't
+     * checked: a wrong offset is outside of the PGN file or it fails the
+     * check of quickhash when the game is read. */
+    GameIndex loaded;
+    loaded.m_blocks.resize(blockCount);
+    boost::uint64_t bitOffset = 0;
+    for ( std::size_t i = 0; i < blockCount; ++i )
+    {
+        IndexFileBlock const& block = blocks[i];
+        if ( block.bitOffset != bitOffset || block.offsetBits > WORD_BITS ||
+            block.moveTextBits > WORD_BITS ||
+            ( i != 0 && block.base < blocks[i - 1].base ) )
+        {
+            return false;
+        }
+        bitOffset += GameIndex::BLOCK_SIZE *
+            ( block.offsetBits + block.moveTextBits );
+
+        loaded.m_blocks[i].base = block.base;
+        loaded.m_blocks[i].bitOffset = block.bitOffset;
+        loaded.m_blocks[i].offsetBits = block.offsetBits;
+        loaded.m_blocks[i].moveTextBits = block.moveTextBits;
+    }
+    if ( bitOffset != header.bitCount )
+    {
+        return false;
+    }
+
+    loaded.m_tail.resize(tailCount);
+    for ( std::size_t i = 0; i < tailCount; ++i )
+    {
+        IndexFileEntry const& entry = tail[i];
+        if ( entry.offset[goMoveTextSection] <
+                entry.offset[goTagPairSection] ||
+            entry.offset[goMoveTextSection] > header.lastGameEnd ||
+            ( i != 0 && entry.offset[goTagPairSection] <
+                tail[i - 1].offset[goMoveTextSection] ) )
+        {
+            return false;
+        }
+
+        loaded.m_tail[i].offset[goTagPairSection] =
+            entry.offset[goTagPairSection];
+        loaded.m_tail[i].offset[goMoveTextSection] =
+            entry.offset[goMoveTextSection];
+    }
+
+    loaded.m_bits.assign(words, words + wordCount);
+    loaded.m_bitCount = header.bitCount;
+    loaded.m_lastGameEnd = header.lastGameEnd;
+    loaded.m_quickhashes.assign(quickhashes, quickhashes + gameCount);
+
+    for ( std::size_t i = 0; i < getSampleSize(gameCount); ++i )
+    {
+        GameInFile const game = loaded[getSampleGame(i, gameCount)];
+        if ( game.quickhash == NULL_QUICKHASH ||
+            computeQuickHash(pgnfile, game) != game.quickhash )
+        {
+            return false;
+        }
+    }
+
+    games.swap(loaded);
+    return true;
+}
+
+bool IndexFile::save(MappedFile const& pgnfile,
+    GameScanner::GameList const& games) const
+{
+    if ( !m_isPgnFileInfoValid || m_pgnFileInfo.size != pgnfile.getFileSize() )
+    {
+        return false;
+    }
+
+    IndexFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic));
+    header.version = INDEX_FILE_VERSION;
+    header.byteOrder = INDEX_FILE_BYTE_ORDER;
+    header.recordSize = sizeof(IndexFileBlock);
+    header.pgnSize = m_pgnFileInfo.size;
+    header.pgnModificationTime = m_pgnFileInfo.modificationTime;
+    header.gameCount = games.size();
+    header.bitCount = games.m_bitCount;
+    header.lastGameEnd = games.m_lastGameEnd;
+
+    /* Blocks and the tail are small (a record per BLOCK_SIZE games). */
+    std::vector<IndexFileBlock> blocks(games.m_blocks.size());
+    for ( std::size_t i = 0; i < blocks.size(); ++i )
+    {
+        std::memset(&blocks[i], 0, sizeof(blocks[i]));
+        blocks[i].base = games.m_blocks[i].base;
+        blocks[i].bitOffset = games.m_blocks[i].bitOffset;
+        blocks[i].offsetBits = games.m_blocks[i].offsetBits;
+        blocks[i].moveTextBits = games.m_blocks[i].moveTextBits;
+    }
+
+    std::vector<IndexFileEntry> tail(games.m_tail.size());
+    for ( std::size_t i = 0; i < tail.size(); ++i )
+    {
+        tail[i].offset[goTagPairSection] =
+            games.m_tail[i].offset[goTagPairSection];
+        tail[i].offset[goMoveTextSection] =
+            games.m_tail[i].offset[goMoveTextSection];
+    }
+
+    /* Another process can read the index at the same time. Thus it is
+     * written into a temporary file which replaces the index at once. */
+    FilePath const tmpPath(m_path.withSuffix("~"));
+
+    std::FILE* file = openFile(tmpPath, "wb");
+    if ( file == NULL )
+    {
+        return false;
+    }
+
+    bool isOk = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+        writeArray(file, blocks.empty() ? NULL : &blocks[0], blocks.size()) &&
+        writeArray(file, games.m_bits.empty() ? NULL : &games.m_bits[0],
+            games.m_bits.size()) &&
+        writeArray(file, tail.empty() ? NULL : &tail[0], tail.size()) &&
+        writeArray(file, games.m_quickhashes.empty() ? NULL :
+            &games.m_quickhashes[0], games.m_quickhashes.size());
+
+    isOk = ( std::fclose(file) == 0 ) && isOk;
+    if ( !isOk || !renameFile(tmpPath, m_path) )
+    {
+        removeFile(tmpPath);
+        return false;
+    }
+
+    return true;
+}
+
+unsigned computeQuickHash(MappedFile const& pgnfile, GameInFile const& game)
+{
+    unsigned long long const offset = game.offset[goTagPairSection];
+    MappedRegionPtr const region = pgnfile.map(offset, game.size);
+    if ( !region )
+    {
+        return NULL_QUICKHASH;
+    }
+
+    return computeQuickHash(region->getData(offset), game.size);
+}
+
+} /* namespace pgn */
@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_INDEX_FILE_HPP
+#define PGN_INDEX_FILE_HPP
+
+#include "game_scanner.hpp"
+#include "file_info.hpp"
+#include "mapped_file.hpp"
+
+namespace pgn
+{
+
+/* Sidecar file with results of light weight parsing of a PGN file. It is
+ * stored next to the PGN file (with additional ".idx" extension) and allows
+ * to skip scanning of the PGN file when it is opened next time. The index is
+ * trusted only if size and modification time of the PGN file are the same
+ * as they were during scanning and a sample of games has the same
+ * quickhash. Any problem with the sidecar file isn't an error: the PGN file
+ * is just scanned again. */
+class IndexFile
+{
+public:
+    /* Remember attributes of the PGN file. It should be done before the PGN
+     * file is scanned. */
+    explicit IndexFile(FilePath const& pgnfile);
+
+    /* Update attributes of the PGN file, e.g. after the file was changed and
+     * its index was updated. */
+    void setPgnFileInfo(FileInfo const& info);
+
+    /* Read the index of the PGN file. pgnfile is used for checking a sample
+     * of games. */
+    bool load(MappedFile const& pgnfile, GameScanner::GameList& games) const;
+
+    /* Write the index of the PGN file. The index has to be complete (till
+     * the end of the PGN file). */
+    bool save(MappedFile const& pgnfile,
+        GameScanner::GameList const& games) const;
+
+private:
+    FilePath m_path; /* name of the sidecar file */
+    bool m_isPgnFileInfoValid;
+    FileInfo m_pgnFileInfo; /* attributes of the PGN file */
+};
+
+/* Compute quickhash of the game in the PGN file. The method returns
+ * NULL_QUICKHASH if the game can't be read. */
+unsigned computeQuickHash(MappedFile const& pgnfile, GameInFile const& game);
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_INDEX_FILE_HPP */
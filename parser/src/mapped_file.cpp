@@ -0,0 +1,273 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapped_file.hpp"
+
+#include <ios>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace pgn
+{
+
+namespace
+{
+
+/* The limit should allow to keep a few windows mapped, e.g. the window with
+ * the scanned data and windows with games which are read by user. */
+const unsigned long long MIN_WINDOW_COUNT = 4;
+
+} /* unnamed namespace */
+
+const std::size_t MappedFile::DEFAULT_WINDOW_SIZE;
+const unsigned long long MappedFile::DEFAULT_MAPPED_SIZE_LIMIT;
+
+MappedRegion::MappedRegion(FilePath const& path, unsigned long long offset,
+    std::size_t length)
+    : m_offset(offset)
+{
+    m_shift = static_cast<std::size_t>(offset %
+        boost::iostreams::mapped_file_source::alignment());
+    openMappedFile(m_file, path, length + m_shift,
+        static_cast<boost::intmax_t>(offset - m_shift));
+}
+
+/* There is no such hint on Windows (before Windows 8), the data is read on
+ * page faults like without the call. */
+void MappedRegion::prefetch(unsigned long long offset,
+    std::size_t length) const
+{
+#ifndef _WIN32
+    if ( length == 0 || !contains(offset, length) )
+    {
+        return ;
+    }
+
+    /* The address should be aligned on the page boundary. */
+    std::size_t const begin = m_shift +
+        static_cast<std::size_t>(offset - m_offset);
+    std::size_t const alignedBegin = begin - begin %
+        boost::iostreams::mapped_file_source::alignment();
+    posix_madvise(const_cast<char*>(m_file.data()) + alignedBegin,
+        begin + length - alignedBegin, POSIX_MADV_WILLNEED);
+#else /* #ifndef _WIN32 */
+    (void)offset;
+    (void)length;
+#endif /* #ifndef _WIN32 */
+}
+
+MappedFile::MappedFile()
+    : m_mappedSize(0)
+{
+    setMappedSizeLimit(DEFAULT_MAPPED_SIZE_LIMIT);
+}
+
+void MappedFile::open(FilePath const& path)
+{
+    m_path = path;
+    reopen();
+}
+
+void MappedFile::reopen()
+{
+    FileInfo fileInfo;
+    bool const isOk = pgn::getFileInfo(m_path, fileInfo);
+
+    boost::mutex::scoped_lock lock(m_windowsLock);
+    for ( WindowList::const_iterator it = m_windows.begin();
+        it != m_windows.end(); ++it )
+    {
+        if ( it->use_count() > 1 )
+        {
+            m_droppedWindows.push_back(*it);
+        }
+    }
+    m_windows.clear();
+    m_mappedSize = 0;
+
+    m_fileInfo = isOk ? fileInfo : FileInfo();
+    if ( !isOk )
+    {
+        throw std::ios_base::failure("failed opening file");
+    }
+}
+
+void MappedFile::setMappedSizeLimit(unsigned long long limit)
+{
+    std::size_t const alignment =
+        boost::iostreams::mapped_file_source::alignment();
+    unsigned long long windowSize = limit / MIN_WINDOW_COUNT;
+    if ( windowSize > DEFAULT_WINDOW_SIZE )
+    {
+        windowSize = DEFAULT_WINDOW_SIZE;
+    }
+    windowSize -= windowSize % alignment;
+    if ( windowSize == 0 )
+    {
+        windowSize = alignment;
+    }
+
+    boost::mutex::scoped_lock lock(m_windowsLock);
+    m_mappedSizeLimit = limit;
+    m_windowSize = static_cast<std::size_t>(windowSize);
+    evictWindows(m_mappedSizeLimit, 0);
+}
+
+MappedRegionPtr MappedFile::map(unsigned long long offset,
+    std::size_t length) const
+{
+    boost::mutex::scoped_lock lock(m_windowsLock);
+    if ( length == 0 || offset > m_fileInfo.size ||
+        length > m_fileInfo.size - offset )
+    {
+        return MappedRegionPtr();
+    }
+
+    for ( WindowList::iterator it = m_windows.begin(); it != m_windows.end();
+        ++it )
+    {
+        if ( (*it)->contains(offset, length) )
+        {
+            m_windows.splice(m_windows.begin(), m_windows, it);
+            return m_windows.front();
+        }
+    }
+
+    /* The window is extended if the range crosses its boundary. */
+    unsigned long long const begin = offset - offset % m_windowSize;
+    unsigned long long end = begin + m_windowSize;
+    if ( end < offset + length )
+    {
+        end = offset + length;
+    }
+    if ( end > m_fileInfo.size )
+    {
+        end = m_fileInfo.size;
+    }
+
+    MappedRegionPtr region;
+    while ( !region )
+    {
+        try
+        {
+            region.reset(new MappedRegion(m_path, begin,
+                static_cast<std::size_t>(end - begin)));
+        } catch ( std::exception const& )
+        {
+            /* Old windows can hold the address space which is required. */
+            if ( !evictWindows(0, 0) )
+            {
+                return MappedRegionPtr();
+            }
+        }
+    }
+
+    m_windows.push_front(region);
+    m_mappedSize += region->getSize();
+    evictWindows(m_mappedSizeLimit, 1);
+
+    return region;
+}
+
+std::size_t MappedFile::getLengthInWindow(unsigned long long offset) const
+{
+    boost::mutex::scoped_lock lock(m_windowsLock);
+    if ( offset >= m_fileInfo.size )
+    {
+        return 0;
+    }
+
+    unsigned long long length = m_windowSize - offset % m_windowSize;
+    if ( length > m_fileInfo.size - offset )
+    {
+        length = m_fileInfo.size - offset;
+    }
+
+    return static_cast<std::size_t>(length);
+}
+
+unsigned long long MappedFile::getFileSize() const
+{
+    boost::mutex::scoped_lock lock(m_windowsLock);
+    return m_fileInfo.size;
+}
+
+FileInfo MappedFile::getFileInfo() const
+{
+    boost::mutex::scoped_lock lock(m_windowsLock);
+    return m_fileInfo;
+}
+
+/* Unused windows are unmapped from the least recently used one until the
+ * mapped size (including windows which can't be unmapped) is within the
+ * limit. A few most recently used windows are kept even if they are larger
+ * than the limit (e.g. a just mapped window with a huge game). The method
+ * returns true if a window was unmapped. It should be called under
+ * lock. */
+bool MappedFile::evictWindows(unsigned long long limit,
+    std::size_t keepCount) const
+{
+    std::size_t candidateCount = ( m_windows.size() > keepCount ) ?
+        m_windows.size() - keepCount : 0;
+    unsigned long long const droppedSize = getDroppedSize();
+    bool isEvicted = false;
+    WindowList::iterator it = m_windows.end();
+    for ( ; candidateCount != 0 && m_mappedSize + droppedSize > limit;
+        --candidateCount )
+    {
+        --it;
+        if ( it->use_count() > 1 )
+        {
+            /* The window is held by somebody, thus it stays mapped. */
+            continue;
+        }
+
+        m_mappedSize -= (*it)->getSize();
+        it = m_windows.erase(it);
+        isEvicted = true;
+    }
+
+    return isEvicted;
+}
+
+/* Dropped windows are forgotten when they are released. The method should
+ * be called under lock. */
+unsigned long long MappedFile::getDroppedSize() const
+{
+    unsigned long long size = 0;
+    DroppedList::iterator it = m_droppedWindows.begin();
+    while ( it != m_droppedWindows.end() )
+    {
+        MappedRegionPtr const window = it->lock();
+        if ( window )
+        {
+            size += window->getSize();
+            ++it;
+        } else
+        {
+            it = m_droppedWindows.erase(it);
+        }
+    }
+
+    return size;
+}
+
+} /* namespace pgn */
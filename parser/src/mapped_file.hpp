@@ -0,0 +1,147 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_MAPPED_FILE_HPP
+#define PGN_MAPPED_FILE_HPP
+
+#include "file_info.hpp"
+
+#include <list>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+namespace pgn
+{
+
+/* A region of a file which is mapped into memory. The region stays mapped
+ * while somebody holds a pointer to it, even if MappedFile has already
+ * dropped the region from its cache. */
+class MappedRegion
+{
+public:
+    MappedRegion(FilePath const& path, unsigned long long offset,
+        std::size_t length);
+
+    unsigned long long getOffset() const { return m_offset; }
+    std::size_t getSize() const { return m_file.size() - m_shift; }
+
+    /* Pointer to the byte of the region with given offset in the file. */
+    char const* getData(unsigned long long offset) const
+    {
+        return m_file.data() + m_shift +
+            static_cast<std::size_t>(offset - m_offset);
+    }
+
+    bool contains(unsigned long long offset, std::size_t length) const
+    {
+        return offset >= m_offset && offset - m_offset <= getSize() &&
+            length <= getSize() - ( offset - m_offset );
+    }
+
+    /* Advise the OS to read the range ahead. It is only a hint, thus
+     * errors are ignored. */
+    void prefetch(unsigned long long offset, std::size_t length) const;
+
+private:
+    MappedRegion(MappedRegion const& ); /* without implementation */
+    MappedRegion& operator=(MappedRegion const& ); /* without implementation */
+
+    boost::iostreams::mapped_file_source m_file;
+    unsigned long long m_offset; /* offset of the region in the file */
+    std::size_t m_shift; /* m_offset isn't aligned on the page boundary */
+};
+
+typedef boost::shared_ptr<MappedRegion const> MappedRegionPtr;
+
+/* Access to a file which can be larger than the address space of the
+ * process. The file is mapped by windows (aligned segments of the file) on
+ * demand. Recently used windows are kept mapped until the total size of
+ * mapped windows exceeds the limit. Windows which are held by somebody
+ * (e.g. by games) can't be unmapped, thus they are counted in the limit
+ * until they are released and other windows are unmapped instead. A
+ * requested range which crosses the boundary of windows (e.g. a game) is
+ * mapped as one region which starts at the boundary of its first window.
+ * All methods are thread safe. */
+class MappedFile
+{
+public:
+    static const std::size_t DEFAULT_WINDOW_SIZE =
+        64 * 1024 * 1024; /* 64 Mb */
+    static const unsigned long long DEFAULT_MAPPED_SIZE_LIMIT =
+        sizeof(void*) > 4 ? 1024 * 1024 * 1024 : 256 * 1024 * 1024;
+
+    MappedFile();
+
+    /* Remember attributes of the file. Nothing is mapped by the method. It
+     * throws std::ios_base::failure if the file can't be accessed. */
+    void open(FilePath const& path);
+
+    /* Forget all mapped windows and get attributes of the file again. The
+     * file could be changed since it was opened (e.g. new games were
+     * appended to it). */
+    void reopen();
+
+    /* Set the limit of total size of mapped windows. The size of a window is
+     * derived from the limit. */
+    void setMappedSizeLimit(unsigned long long limit);
+
+    /* Get a mapped region which contains the range of the file. The method
+     * returns NULL if the range is outside of the file or it is empty or it
+     * can't be mapped. */
+    MappedRegionPtr map(unsigned long long offset, std::size_t length) const;
+
+    /* Length of the range which starts at the offset and ends at the end of
+     * its window (or at the end of the file). Such ranges don't require
+     * remapping of windows. */
+    std::size_t getLengthInWindow(unsigned long long offset) const;
+
+    unsigned long long getFileSize() const;
+    FilePath const& getPath() const { return m_path; }
+
+    /* Attributes of the file at the moment when it was opened. */
+    FileInfo getFileInfo() const;
+
+private:
+    MappedFile(MappedFile const& ); /* without implementation */
+    MappedFile& operator=(MappedFile const& ); /* without implementation */
+
+    bool evictWindows(unsigned long long limit, std::size_t keepCount) const;
+    unsigned long long getDroppedSize() const;
+
+    FilePath m_path;
+
+    typedef std::list<MappedRegionPtr> WindowList;
+    typedef std::list<boost::weak_ptr<MappedRegion const> > DroppedList;
+    mutable boost::mutex m_windowsLock; /* it protects all members below */
+    FileInfo m_fileInfo;
+    mutable WindowList m_windows; /* the most recently used is the first */
+    mutable unsigned long long m_mappedSize; /* total size of m_windows */
+    mutable DroppedList m_droppedWindows; /* windows which were dropped by
+                                             reopen() while somebody held
+                                             them */
+    unsigned long long m_mappedSizeLimit;
+    std::size_t m_windowSize;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_MAPPED_FILE_HPP */
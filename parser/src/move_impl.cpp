@@ -0,0 +1,393 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "move_impl.hpp"
+#include "game_impl.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace pgn
+{
+
+namespace
+{
+
+/* Descriptions of NAGs from the PGN standard. */
+char const* const DETAILED_NAGS[nagLastNumericAnnotationGlyph] =
+{
+    "null annotation",
+    "good move (traditional \"!\")",
+    "poor move (traditional \"?\")",
+    "very good move (traditional \"!!\")",
+    "very poor move (traditional \"??\")",
+    "speculative move (traditional \"!?\")",
+    "questionable move (traditional \"?!\")",
+    "forced move (all others lose quickly)",
+    "singular move (no reasonable alternatives)",
+    "worst move",
+    "drawish position",
+    "equal chances, quiet position",
+    "equal chances, active position",
+    "unclear position",
+    "White has a slight advantage",
+    "Black has a slight advantage",
+    "White has a moderate advantage",
+    "Black has a moderate advantage",
+    "White has a decisive advantage",
+    "Black has a decisive advantage",
+    "White has a crushing advantage (Black should resign)",
+    "Black has a crushing advantage (White should resign)",
+    "White is in zugzwang",
+    "Black is in zugzwang",
+    "White has a slight space advantage",
+    "Black has a slight space advantage",
+    "White has a moderate space advantage",
+    "Black has a moderate space advantage",
+    "White has a decisive space advantage",
+    "Black has a decisive space advantage",
+    "White has a slight time (development) advantage",
+    "Black has a slight time (development) advantage",
+    "White has a moderate time (development) advantage",
+    "Black has a moderate time (development) advantage",
+    "White has a decisive time (development) advantage",
+    "Black has a decisive time (development) advantage",
+    "White has the initiative",
+    "Black has the initiative",
+    "White has a lasting initiative",
+    "Black has a lasting initiative",
+    "White has the attack",
+    "Black has the attack",
+    "White has insufficient compensation for material deficit",
+    "Black has insufficient compensation for material deficit",
+    "White has sufficient compensation for material deficit",
+    "Black has sufficient compensation for material deficit",
+    "White has more than adequate compensation for material deficit",
+    "Black has more than adequate compensation for material deficit",
+    "White has a slight center control advantage",
+    "Black has a slight center control advantage",
+    "White has a moderate center control advantage",
+    "Black has a moderate center control advantage",
+    "White has a decisive center control advantage",
+    "Black has a decisive center control advantage",
+    "White has a slight kingside control advantage",
+    "Black has a slight kingside control advantage",
+    "White has a moderate kingside control advantage",
+    "Black has a moderate kingside control advantage",
+    "White has a decisive kingside control advantage",
+    "Black has a decisive kingside control advantage",
+    "White has a slight queenside control advantage",
+    "Black has a slight queenside control advantage",
+    "White has a moderate queenside control advantage",
+    "Black has a moderate queenside control advantage",
+    "White has a decisive queenside control advantage",
+    "Black has a decisive queenside control advantage",
+    "White has a vulnerable first rank",
+    "Black has a vulnerable first rank",
+    "White has a well protected first rank",
+    "Black has a well protected first rank",
+    "White has a poorly protected king",
+    "Black has a poorly protected king",
+    "White has a well protected king",
+    "Black has a well protected king",
+    "White has a poorly placed king",
+    "Black has a poorly placed king",
+    "White has a well placed king",
+    "Black has a well placed king",
+    "White has a very weak pawn structure",
+    "Black has a very weak pawn structure",
+    "White has a moderately weak pawn structure",
+    "Black has a moderately weak pawn structure",
+    "White has a moderately strong pawn structure",
+    "Black has a moderately strong pawn structure",
+    "White has a very strong pawn structure",
+    "Black has a very strong pawn structure",
+    "White has poor knight placement",
+    "Black has poor knight placement",
+    "White has good knight placement",
+    "Black has good knight placement",
+    "White has poor bishop placement",
+    "Black has poor bishop placement",
+    "White has good bishop placement",
+    "Black has good bishop placement",
+    "White has poor rook placement",
+    "Black has poor rook placement",
+    "White has good rook placement",
+    "Black has good rook placement",
+    "White has poor queen placement",
+    "Black has poor queen placement",
+    "White has good queen placement",
+    "Black has good queen placement",
+    "White has poor piece coordination",
+    "Black has poor piece coordination",
+    "White has good piece coordination",
+    "Black has good piece coordination",
+    "White has played the opening very poorly",
+    "Black has played the opening very poorly",
+    "White has played the opening poorly",
+    "Black has played the opening poorly",
+    "White has played the opening well",
+    "Black has played the opening well",
+    "White has played the opening very well",
+    "Black has played the opening very well",
+    "White has played the middlegame very poorly",
+    "Black has played the middlegame very poorly",
+    "White has played the middlegame poorly",
+    "Black has played the middlegame poorly",
+    "White has played the middlegame well",
+    "Black has played the middlegame well",
+    "White has played the middlegame very well",
+    "Black has played the middlegame very well",
+    "White has played the ending very poorly",
+    "Black has played the ending very poorly",
+    "White has played the ending poorly",
+    "Black has played the ending poorly",
+    "White has played the ending well",
+    "Black has played the ending well",
+    "White has played the ending very well",
+    "Black has played the ending very well",
+    "White has slight counterplay",
+    "Black has slight counterplay",
+    "White has moderate counterplay",
+    "Black has moderate counterplay",
+    "White has decisive counterplay",
+    "Black has decisive counterplay",
+    "White has moderate time control pressure",
+    "Black has moderate time control pressure",
+    "White has severe time control pressure",
+    "Black has severe time control pressure",
+};
+
+/* Brief form is absent for most of NAGs. */
+char const* const BRIEF_NAGS[nagLastNumericAnnotationGlyph] =
+{
+    NULL, "!", "?", "!!", "??", "!?", "?!", NULL, NULL, NULL, "=", NULL, NULL,
+    "\xe2\x88\x9e", "\xe2\xa9\xb2", "\xe2\xa9\xb1", "\xc2\xb1", "\xe2\x88\x93",
+    "+-", "-+", NULL, NULL, "\xe2\xa8\x80", "\xe2\xa8\x80", NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, "\xe2\x9f\xb3", "\xe2\x9f\xb3", NULL, NULL,
+    "\xe2\x86\x91", "\xe2\x86\x91", NULL, NULL, "\xe2\x86\x92", "\xe2\x86\x92",
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, "\xe2\x87\x86", "\xe2\x87\x86", NULL,
+    NULL, NULL, NULL, "\xe2\x8a\x95", "\xe2\x8a\x95",
+};
+
+/* Numeric form ($N) of all NAGs. It is initialized before main(), thus
+ * there is no race between threads. */
+class NumericNAGTable
+{
+public:
+    NumericNAGTable()
+    {
+        for ( unsigned nag = 0; nag < nagLastNumericAnnotationGlyph; ++nag )
+        {
+            std::sprintf(m_table[nag], "$%u", nag);
+        }
+    }
+
+    char const* operator[](unsigned nag) const { return m_table[nag]; }
+
+private:
+    char m_table[nagLastNumericAnnotationGlyph][8];
+};
+
+const NumericNAGTable NUMERIC_NAGS;
+
+bool isFile(char c) { return c >= 'a' && c <= 'h'; }
+bool isRank(char c) { return c >= '1' && c <= '8'; }
+bool isPiece(char c)
+{
+    return c == 'K' || c == 'Q' || c == 'R' || c == 'B' || c == 'N';
+}
+
+bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+        c == '\f';
+}
+
+} /* unnamed namespace */
+
+char const* IMove::toString(NAG_t nag, NAG_format_t fmt)
+{
+    if ( nag < nagNull || nag >= nagLastNumericAnnotationGlyph )
+    {
+        return "";
+    }
+
+    if ( fmt == nfBrief && BRIEF_NAGS[nag] != NULL )
+    {
+        return BRIEF_NAGS[nag];
+    }
+
+    return fmt == nfNumeric ? NUMERIC_NAGS[nag] : DETAILED_NAGS[nag];
+}
+
+NAG_t MoveImpl::getNAG(unsigned n) const
+{
+    if ( n == NEXT_ITEM )
+    {
+        n = ++m_nextNAG;
+    }
+
+    if ( m_extras == NULL || n == 0 || n > m_extras->nagCount )
+    {
+        /* The end of the list. Iteration can be started again. */
+        m_nextNAG = 0;
+        return nagNull;
+    }
+
+    return m_game->getNAG(m_extras->firstNAG + n - 1);
+}
+
+unsigned MoveImpl::getNAGs(NAG_t* nags, unsigned size) const
+{
+    unsigned const count = m_extras != NULL ? m_extras->nagCount : 0;
+    for ( unsigned i = 0; i < size && i < count; ++i )
+    {
+        nags[i] = m_game->getNAG(m_extras->firstNAG + i);
+    }
+
+    return count;
+}
+
+char const* MoveImpl::getComment() const
+{
+    return m_extras != NULL ? m_game->getComment(*m_extras) : NULL;
+}
+
+variation_t MoveImpl::getChildVariation(unsigned n) const
+{
+    if ( n == NEXT_ITEM )
+    {
+        n = ++m_nextChildVariation;
+    }
+
+    if ( n == 0 || n > getChildVariationCount() )
+    {
+        m_nextChildVariation = 0;
+        return NULL_VARIATION;
+    }
+
+    return m_game->getChildVariation(m_extras->firstChildVariation + n - 1);
+}
+
+/* E.g. line breaks of a long comment are replaced. */
+char const* normalizeComment(char const* data, std::size_t length,
+    Arena& arena)
+{
+    char* const comment = arena.allocate<char>(length + 1);
+    char* c = comment;
+    bool isSpacePending = false;
+    for ( std::size_t i = 0; i < length; ++i )
+    {
+        if ( isWhitespace(data[i]) )
+        {
+            isSpacePending = ( c != comment );
+            continue;
+        }
+
+        if ( isSpacePending )
+        {
+            *c++ = ' ';
+            isSpacePending = false;
+        }
+        *c++ = data[i];
+    }
+    *c = '\0';
+
+    return comment;
+}
+
+bool isSANValid(char const* san)
+{
+    std::size_t length = ( san != NULL ) ? std::strlen(san) : 0;
+    if ( length != 0 && ( san[length - 1] == '+' || san[length - 1] == '#' ) )
+    {
+        --length;
+    }
+
+    if ( san == NULL || length < 2 )
+    {
+        return false;
+    }
+
+    if ( san[0] == 'O' )
+    {
+        return ( length == 3 && std::strncmp(san, "O-O", 3) == 0 ) ||
+            ( length == 5 && std::strncmp(san, "O-O-O", 5) == 0 );
+    }
+
+    if ( isPiece(san[0]) )
+    {
+        /* Piece, disambiguation (file, rank or both), capture and target
+         * square. */
+        if ( length < 3 || length > 6 || !isFile(san[length - 2]) ||
+            !isRank(san[length - 1]) )
+        {
+            return false;
+        }
+
+        char const* c = san + 1;
+        char const* const target = san + length - 2;
+        if ( c != target && isFile(*c) )
+        {
+            ++c;
+        }
+        if ( c != target && isRank(*c) )
+        {
+            ++c;
+        }
+        if ( c != target && *c == 'x' )
+        {
+            ++c;
+        }
+
+        return c == target;
+    }
+
+    /* Pawn move: e4, exd5, e8=Q or e8Q. */
+    bool isPromotion = false;
+    if ( isPiece(san[length - 1]) && san[length - 1] != 'K' )
+    {
+        isPromotion = true;
+        --length;
+        if ( length != 0 && san[length - 1] == '=' )
+        {
+            --length;
+        }
+    }
+
+    if ( !( length == 2 || ( length == 4 && san[1] == 'x' ) ) ||
+        !isFile(san[0]) || !isFile(san[length - 2]) ||
+        !isRank(san[length - 1]) )
+    {
+        return false;
+    }
+
+    char const rank = san[length - 1];
+    return isPromotion == ( rank == '1' || rank == '8' );
+}
+
+} /* namespace pgn */
@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_MOVE_IMPL_HPP
+#define PGN_MOVE_IMPL_HPP
+
+#include <pgn/move.hpp>
+#include "arena.hpp"
+
+#include <cstddef>
+
+namespace pgn
+{
+
+class GameImpl;
+
+/* Parts of a move which most moves don't have: a comment, NAGs, child
+ * variations (alternatives to the move) and SAN of a move which isn't
+ * resolved on the board. GameImpl keeps them in a side table which is
+ * sorted by index of the move, NAGs and identifiers of child variations are
+ * ranges of tables of the game. A comment refers to the movetext (it is
+ * mapped while the game exists) and it is normalized on demand. */
+struct MoveExtras
+{
+    MoveExtras() : move(0), san(NULL), rawComment(NULL), rawCommentLength(0),
+        comment(NULL), firstNAG(0), nagCount(0), firstChildVariation(0),
+        childVariationCount(0), isIllegal(false) {}
+
+    unsigned move; /* index of the move in the game */
+    char const* san; /* SAN of a move which isn't resolved (or NULL) */
+    char const* rawComment; /* comments of the move as they are */
+    std::size_t rawCommentLength;
+    mutable char const* comment; /* NULL if it isn't normalized yet */
+    unsigned firstNAG;
+    unsigned nagCount;
+    unsigned firstChildVariation;
+    unsigned childVariationCount;
+    bool isIllegal; /* the position was known, but there is no such legal
+                       move */
+};
+
+/* A move of a game. Moves are stored by the game packed (see GameImpl),
+ * IMove objects are views which are created in the arena of the game for
+ * each variation when its moves are requested. SAN of moves of the
+ * variation is rendered at the same time. */
+class MoveImpl : public IMove
+{
+public:
+    MoveImpl(GameImpl const& game, MoveExtras const* extras, char const* san,
+        unsigned moveNumber, variation_t variation) : m_game(&game),
+        m_extras(extras), m_san(san), m_moveNumber(moveNumber),
+        m_variation(variation), m_nextNAG(0), m_nextChildVariation(0) {}
+
+    char const* getSAN() const { return m_san; }
+    NAG_t getNAG(unsigned n) const;
+    unsigned getNAGs(NAG_t* nags, unsigned size) const;
+    char const* getComment() const;
+    unsigned getMoveNumber() const { return m_moveNumber; }
+    variation_t getVariation() const { return m_variation; }
+
+    unsigned getChildVariationCount() const
+    {
+        return m_extras != NULL ? m_extras->childVariationCount : 0;
+    }
+    variation_t getChildVariation(unsigned n) const;
+
+    bool isIllegal() const { return m_extras != NULL && m_extras->isIllegal; }
+
+private:
+    GameImpl const* m_game;
+    MoveExtras const* m_extras; /* NULL if the move doesn't have them */
+    char const* m_san;
+    unsigned m_moveNumber;
+    variation_t m_variation;
+    mutable unsigned m_nextNAG; /* see getNAG(NEXT_ITEM) */
+    mutable unsigned m_nextChildVariation; /* see getChildVariation() */
+};
+
+/* Replace each run of whitespace of a comment by a space, leading and
+ * trailing whitespace is removed. The result is allocated in the arena. */
+char const* normalizeComment(char const* data, std::size_t length,
+    Arena& arena);
+
+/* Check syntax of a move in SAN (e.g. "Nbxd7+", "e8=Q#", "O-O"). Legality
+ * of the move isn't checked. */
+bool isSANValid(char const* san);
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_MOVE_IMPL_HPP */
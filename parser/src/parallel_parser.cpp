@@ -0,0 +1,247 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "parallel_parser.hpp"
+#include "game_impl.hpp"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+namespace pgn
+{
+
+const unsigned ParallelParser::BATCH_SIZE;
+const unsigned ParallelParser::GAMES_PER_WORKER;
+
+ParallelParser::ParallelParser(Parser* parser, delivery_order_t order,
+    unsigned threadCount)
+    : m_parser(parser), m_order(order), m_nextGame(1), m_deliveredCount(0),
+    m_isCancelled(false)
+{
+    if ( threadCount == 0 )
+    {
+        threadCount = std::max(boost::thread::hardware_concurrency(), 1U);
+    }
+
+    /* Boundaries of all games should be known. */
+    m_gameCount = m_parser->getGameCount();
+    m_bufferSize = threadCount * GAMES_PER_WORKER;
+    if ( m_order == doFileOrder )
+    {
+        m_reorderBuffer.resize(m_bufferSize);
+    }
+
+    try
+    {
+        for ( unsigned i = 0; i < threadCount; ++i )
+        {
+            m_workers.create_thread(boost::bind(&ParallelParser::work, this));
+        }
+    } catch ( ... )
+    {
+        /* Started workers refer to the instance. */
+        cancel();
+        throw;
+    }
+}
+
+ParallelParser::~ParallelParser()
+{
+    cancel();
+}
+
+IGame const* ParallelParser::readGame()
+{
+    boost::mutex::scoped_lock lock(m_lock);
+    while ( !m_isCancelled && m_deliveredCount < m_gameCount )
+    {
+        IGame const* game = NULL;
+        bool isReady = false;
+        if ( m_order == doFileOrder )
+        {
+            Slot& slot = m_reorderBuffer[m_deliveredCount % m_bufferSize];
+            isReady = slot.isReady;
+            game = slot.game;
+            if ( isReady )
+            {
+                slot = Slot();
+                ++m_deliveredCount;
+            }
+        } else if ( !m_readyGames.empty() )
+        {
+            isReady = true;
+            game = m_readyGames.front();
+            m_readyGames.pop_front();
+            ++m_deliveredCount;
+        }
+
+        if ( !isReady )
+        {
+            m_gameReady.wait(lock);
+            continue;
+        }
+
+        /* Workers take whole batches, thus they are woken up when there is
+         * space for a batch. */
+        if ( ( m_bufferSize - ( m_nextGame - 1 - m_deliveredCount ) ) %
+            BATCH_SIZE == 0 )
+        {
+            m_bufferReleased.notify_one();
+        }
+
+        if ( game != NULL )
+        {
+            return game;
+        }
+    }
+
+    return NULL;
+}
+
+void ParallelParser::cancel()
+{
+    {
+        boost::mutex::scoped_lock lock(m_lock);
+        m_isCancelled = true;
+    }
+    m_bufferReleased.notify_all();
+    m_gameReady.notify_all();
+    m_workers.join_all();
+
+    releaseGames();
+}
+
+void ParallelParser::work()
+{
+    std::vector<GameInFile> gamesInFile;
+    std::vector<MappedRegionPtr> regions;
+    std::vector<IGame const*> games;
+    for ( ;; )
+    {
+        unsigned firstGame = 0;
+        unsigned count = 0;
+        {
+            boost::mutex::scoped_lock lock(m_lock);
+            for ( ;; )
+            {
+                if ( m_isCancelled || m_nextGame > m_gameCount )
+                {
+                    return ;
+                }
+
+                /* Games which are taken and not read yet. */
+                unsigned const pendingCount = m_nextGame - 1 -
+                    m_deliveredCount;
+                count = std::min(BATCH_SIZE, m_gameCount - m_nextGame + 1);
+                if ( m_bufferSize - pendingCount >= count )
+                {
+                    break;
+                }
+
+                m_bufferReleased.wait(lock);
+            }
+
+            firstGame = m_nextGame;
+            m_nextGame += count;
+        }
+
+        m_parser->getGamesInFile(firstGame, count, false, gamesInFile,
+            regions);
+        games.assign(count, static_cast<IGame const*>(NULL));
+        for ( std::size_t i = 0; i < gamesInFile.size(); ++i )
+        {
+            games[i] = m_parser->buildGame(firstGame + i, gamesInFile[i],
+                regions[i]);
+            static_cast<GameImpl const*>(games[i])->parseMoveText();
+        }
+
+        deliver(firstGame, games);
+    }
+}
+
+/* Games of a batch are delivered at once, thus the caller is woken up once
+ * per batch. */
+void ParallelParser::deliver(unsigned firstGame,
+    std::vector<IGame const*> const& games)
+{
+    {
+        boost::mutex::scoped_lock lock(m_lock);
+        for ( std::size_t i = 0; i < games.size(); ++i )
+        {
+            if ( m_order == doFileOrder )
+            {
+                Slot& slot = m_reorderBuffer[( firstGame + i - 1 ) %
+                    m_bufferSize];
+                slot.isReady = true;
+                slot.game = games[i];
+            } else if ( games[i] != NULL )
+            {
+                m_readyGames.push_back(games[i]);
+            } else
+            {
+                /* There is nothing to read. */
+                ++m_deliveredCount;
+                m_bufferReleased.notify_all();
+            }
+        }
+    }
+
+    m_gameReady.notify_one();
+}
+
+/* The method is called when workers are stopped. */
+void ParallelParser::releaseGames()
+{
+    for ( std::size_t i = 0; i < m_reorderBuffer.size(); ++i )
+    {
+        if ( m_reorderBuffer[i].game != NULL )
+        {
+            m_reorderBuffer[i].game->release();
+        }
+        m_reorderBuffer[i] = Slot();
+    }
+
+    for ( std::size_t i = 0; i < m_readyGames.size(); ++i )
+    {
+        m_readyGames[i]->release();
+    }
+    m_readyGames.clear();
+}
+
+IParallelParser* IParallelParser::create(IParser* parser,
+    delivery_order_t order, unsigned threadCount)
+{
+    if ( parser == NULL )
+    {
+        return NULL;
+    }
+
+    /* Parser is the only implementation of IParser. */
+    try
+    {
+        return new ParallelParser(static_cast<Parser*>(parser), order,
+            threadCount);
+    } catch ( std::exception const& )
+    {
+        return NULL;
+    }
+}
+
+} /* namespace pgn */
@@ -0,0 +1,101 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_PARALLEL_PARSER_HPP
+#define PGN_PARALLEL_PARSER_HPP
+
+#include <pgn/parallel_parser.hpp>
+#include "ref_object_impl.hpp"
+#include "parser_impl.hpp"
+
+#include <deque>
+#include <vector>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace pgn
+{
+
+/* Workers take batches of consecutive games from the index of the parser
+ * (see Parser::getGamesInFile()), build them and parse their movetext
+ * sections. Each game has its own builder and arena, thus workers share
+ * nothing except the queue of parsed games. Games which are taken by
+ * workers and not read by the caller are limited by m_bufferSize, thus
+ * workers wait if the caller is slow. In file order a parsed game is put
+ * into the slot of the reorder buffer (game number modulo its size), the
+ * caller waits for the slot of the next game. */
+class ParallelParser : public RefObject<IParallelParser>
+{
+public:
+    /* Number of consecutive games which are taken by a worker at once. */
+    static const unsigned BATCH_SIZE = 16;
+
+    /* Parsed games which aren't read yet per worker. */
+    static const unsigned GAMES_PER_WORKER = 64;
+
+    ParallelParser(Parser* parser, delivery_order_t order,
+        unsigned threadCount);
+    ~ParallelParser();
+
+    IGame const* readGame();
+    void cancel();
+
+private:
+    ParallelParser(ParallelParser const& ); /* without implementation */
+    ParallelParser& operator=(ParallelParser const& ); /* without
+                                                          implementation */
+
+    /* A game which can't be read (e.g. the file was truncated) is delivered
+     * as NULL, the caller skips it. */
+    struct Slot
+    {
+        Slot() : isReady(false), game(NULL) {}
+
+        bool isReady;
+        IGame const* game;
+    };
+
+    void work();
+    void deliver(unsigned firstGame, std::vector<IGame const*> const& games);
+    void releaseGames();
+
+    boost::intrusive_ptr<Parser> m_parser;
+    delivery_order_t const m_order;
+    unsigned m_gameCount; /* games which were found by the parser */
+    unsigned m_bufferSize;
+
+    /* All members below are protected by the lock. */
+    boost::mutex m_lock;
+    boost::condition_variable m_gameReady; /* the caller waits for it */
+    boost::condition_variable m_bufferReleased; /* workers wait for it */
+    unsigned m_nextGame; /* the next game which isn't taken by workers */
+    unsigned m_deliveredCount; /* games which were read by the caller */
+    std::vector<Slot> m_reorderBuffer; /* see doFileOrder */
+    std::deque<IGame const*> m_readyGames; /* see doReadyOrder */
+    bool m_isCancelled;
+
+    boost::thread_group m_workers;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_PARALLEL_PARSER_HPP */
@@ -17,136 +17,748 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <pgn/game.hpp>
-#warning "TODO: replace game.hpp on game_impl.hpp"
 #include "parser_impl.hpp"
+#include "game_builder.hpp"
+#include "quick_hash.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <cstdlib>
 
+#include <boost/bind.hpp>
+
 namespace pgn
 {
 
 const variation_t MAIN_LINE = 0;
 const variation_t NULL_VARIATION = 0;
 const tag_pair_t  NULL_TAG_PAIR = { NULL, NULL };
+const tag_id_t NULL_TAG_ID = static_cast<tag_id_t>(-1);
 const unsigned NEXT_ITEM = 0;
 
-void LightWeightSkipper::initialize()
-{
-    using qi::iso8859_1::char_;
-
-    /* There is a special escape mechanism for PGN data. This mechanism is
-     * triggered by a percent sign character ("%") appearing in the first
-     * column of a line; the data on the rest of the line is ignored. */
-    m_ignoredLine = (qi::eol >> char_('%') >> *(char_ - qi::eol));
-    m_ignoredLine.name("ignored line");
-
-    /* There are two kinds of comments. The first comment type starts with
-     * a semicolon character and continues to the end of the line. The
-     * second kind starts with a left brace character and continues to the next
-     * right brace character. Comments cannot appear inside any token. Comments
-     * do not nest. */
-    m_comment = (
-        (char_(';') >> *(char_ - qi::eol)) |
-        (char_('{') >> *(char_ - char_('}')) >> char_('}'))
-    );
-    m_comment.name("comment");
-
-    entryPoint = m_ignoredLine | m_comment | qi::iso8859_1::space;
-    entryPoint.name("light-weight skipper");
-}
-
-void LightWeightGrammar::initialize()
-{
-    using qi::iso8859_1::char_;
-
-    /* Tag names is that they are composed exclusively of letters, digits, and
-     * the underscore character. */
-    m_tagName = +(qi::iso8859_1::alnum | char_('_'));
-    m_tagName.name("tag name");
-
-    /* Tag value is a string token. The string token is a sequence of zero or
-     * more printing characters delimited by a pair of quote characters. An
-     * empty string is represented by two adjacent quotes. A quote inside a
-     * string is represented by the backslash immediately followed by a quote.
-     * A backslash inside a string is represented by two adjacent backslashes.
-     * Non-printing characters like newline and tab are not permitted inside
-     * of strings. A string token is terminated by its closing quote. */
-    m_tagValue = (
-        char_('"') >>
-        *qi::no_skip[
-            char_('\\') >> char_('\\') |
-            char_('\\') >> char_('"')  | /* why does char_("\\\"") not work? */
-            qi::iso8859_1::graph - char_('"') |
-            char_(' ')
-        ] >> 
-        char_('"')
-    );
-    m_tagValue.name("tag value");
-
-    /* A tag pair is composed of four consecutive tokens: a left bracket token,
-     * a symbol token, a string token, and a right bracket token. */
-    m_tagPair = (
-        char_('[') >> m_tagName >> m_tagValue >> char_(']')
-    );
-    m_tagPair.name("tag pair");
-
-    /* The tag pair section is composed of a series of zero or more tag
-     * pairs. */
-    m_tagPairSection = +m_tagPair;
-    m_tagPairSection.name("tag pair section");
-
-    /* A PGN database file is a sequential collection of zero or more PGN
-     * games. An empty file is a valid. A PGN game is composed of two sections.
-     * The first is the tag pair section and the second is the movetext
-     * section. */
-    entryPoint = m_tagPairSection >> *(char_ >> !m_tagPair);
-    entryPoint.name("light-weight grammar");
-    qi::debug(entryPoint);
-}
-
-template <typename T> void Parser::initialize(T const* pgnfile, bool isStrict)
+const std::size_t Parser::SCAN_BLOCK_SIZE;
+
+namespace
+{
+
+/* Games are usually contiguous in a region, thus they are read ahead by one
+ * request per region. */
+void prefetchGamesInFile(std::vector<GameInFile> const& gamesInFile,
+    std::vector<MappedRegionPtr> const& regions)
+{
+    for ( std::size_t i = 0; i < regions.size(); )
+    {
+        std::size_t next = i + 1;
+        while ( next < regions.size() && regions[next] == regions[i] )
+        {
+            ++next;
+        }
+
+        unsigned long long const begin =
+            gamesInFile[i].offset[goTagPairSection];
+        GameInFile const& last = gamesInFile[next - 1];
+        regions[i]->prefetch(begin, static_cast<std::size_t>(
+            last.offset[goTagPairSection] + last.size - begin));
+        i = next;
+    }
+}
+
+} /* unnamed namespace */
+
+template <typename T> void Parser::initialize(T const* pgnfile, bool isStrict,
+    unsigned options, tag_predicate_t const* filter)
 {
     m_isStrict = isStrict;
-    m_mappedFile.open(std::basic_string<T>(pgnfile), 0, 10000);
-    doLightWeightParsing(1000);
+    m_options = options;
+    m_gameCount = 0;
+    m_nextGame = 1;
+    m_isLightweightParsingDone = false;
+    m_isIndexingThreadActive = false;
+    m_isIndexingCancelled = false;
+    resetLineCounter();
+    FilePath const path = std::basic_string<T>(pgnfile);
+    if ( m_options & poIndexFile )
+    {
+        m_indexFile.reset(new IndexFile(path));
+    }
+
+    if ( m_options & poRecycleGames )
+    {
+        m_gamePool.reset(new GamePool());
+    }
+
+    m_moveTextSource.reset(new MoveTextSource(isStrict,
+        boost::bind(&Parser::reportError, this, _1, _2, _3, _4, _5)));
+
+    if ( filter != NULL && filter->name != NULL )
+    {
+        m_filter.reset(new TagFilter(filter));
+        m_scanner.setFilter(m_filter.get());
+    }
+
+    m_mappedFile.open(path);
+
+    /* The index file doesn't know which games are selected. */
+    if ( m_indexFile && !m_filter &&
+        m_indexFile->load(m_mappedFile, m_gameInFileCache) )
+    {
+        m_gameCount = m_gameInFileCache.size();
+        m_isLightweightParsingDone = true;
+    }
+
+    if ( ( m_options & poAsyncIndexing ) && !m_isLightweightParsingDone )
+    {
+        startIndexingThread();
+    } else
+    {
+        doLightWeightParsing(1000);
+    }
+
+    if ( m_options & poWatchFile )
+    {
+        /* The option is ignored if the file can't be watched. */
+        m_fileWatcher.start(path, boost::bind(&Parser::onFileChanged, this));
+    }
+}
+
+Parser::~Parser()
+{
+    /* Games which are still alive can't report errors any more. */
+    m_moveTextSource->detach();
+    m_fileWatcher.stop();
+    cancelIndexing();
 }
 
 /* The method will parse till gameN game and more (by performance reason). */
 void Parser::doLightWeightParsing(unsigned gameN)
 {
-    if ( getGameInFileCacheSize() > gameN )
     {
-        return ;
+        /* Flags are changed by the indexing thread, thus they are read
+         * under lock. If the thread is active, then the game will be found
+         * by it soon. */
+        boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+        while ( m_isIndexingThreadActive && !m_isLightweightParsingDone &&
+            ( gameN == 0 || m_gameInFileCache.size() <= gameN ) )
+        {
+            m_indexingProgress.wait(lock);
+        }
+
+        if ( m_isLightweightParsingDone ||
+            ( gameN != 0 && m_gameInFileCache.size() > gameN ) )
+        {
+            return ;
+        }
     }
 
     boost::unique_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
-    bool isLightWeightParsingDone = false;
+    bool const isParallel = gameN == 0 && ( m_options & poParallelIndexing );
+    unsigned const threadCount = isParallel ?
+        boost::thread::hardware_concurrency() : 1;
+    std::size_t const blockSize = isParallel ? MappedFile::DEFAULT_WINDOW_SIZE :
+        SCAN_BLOCK_SIZE;
+    while ( !m_isLightweightParsingDone &&
+        ( gameN == 0 || m_gameInFileCache.size() <= gameN ) )
+    {
+        if ( !scanNextBlock(blockSize, threadCount) )
+        {
+            break;
+        }
+    }
+}
+
+/* Scanning is continued from the position where it was stopped last time.
+ * Thus reading of games one by one costs O(size of file). The file is
+ * scanned block by block inside windows, the scanner keeps its state between
+ * them. The method should be called under exclusive lock. It returns false if
+ * there is nothing to scan. */
+bool Parser::scanNextBlock(std::size_t blockSize, unsigned threadCount)
+{
+    if ( m_isLightweightParsingDone )
+    {
+        return false;
+    }
+
+    unsigned long long const offset = m_scanner.getOffset();
+    if ( offset == m_mappedFile.getFileSize() )
+    {
+        m_scanner.finish(m_gameInFileCache);
+        m_gameCount = m_gameInFileCache.size();
+        m_isLightweightParsingDone = true;
+
+        if ( m_indexFile )
+        {
+            m_indexFile->save(m_mappedFile, m_gameInFileCache);
+        }
+
+        return true;
+    }
 
-    /* TODO: Get position after last parsing game */
-    char const* beginIt = m_mappedFile.getData();
-    char const* endIt = beginIt + m_mappedFile.getMappedSize();
+    std::size_t const length = std::min(blockSize,
+        m_mappedFile.getLengthInWindow(offset));
 
-    bool isOk = qi::phrase_parse(beginIt, endIt, LightWeightGrammar(),
-        LightWeightSkipper());
+    MappedRegionPtr const region = m_mappedFile.map(offset, length);
+    if ( !region )
+    {
+        /* The file can't be mapped now (e.g. it was truncated or address
+         * space is exhausted). Scanning will be continued on the next
+         * call. */
+        return false;
+    }
+
+    if ( threadCount > 1 )
+    {
+        m_scanner.scanInParallel(region->getData(offset), length,
+            threadCount, m_gameInFileCache);
+    } else
+    {
+        m_scanner.scan(region->getData(offset), length, m_gameInFileCache);
+    }
+
+    return true;
+}
 
-    m_isLightweightParsingDone = isLightWeightParsingDone;
+/* The thread holds the lock for a block only, thus games which are already
+ * found can be read at the same time. Blocks are small (even in parallel
+ * mode) to keep the latency of readers low. */
+void Parser::doBackgroundIndexing()
+{
+    unsigned const threadCount = ( m_options & poParallelIndexing ) ?
+        boost::thread::hardware_concurrency() : 1;
+    std::size_t const blockSize = SCAN_BLOCK_SIZE * std::max(threadCount, 1U);
+    bool isActive = true;
+    while ( isActive )
+    {
+        boost::unique_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+        isActive = !m_isIndexingCancelled &&
+            scanNextBlock(blockSize, threadCount);
+        if ( !isActive )
+        {
+            m_isIndexingThreadActive = false;
+        }
+        lock.unlock();
+        m_indexingProgress.notify_all();
+    }
+}
+
+/* The method should be called under exclusive lock or before the parser is
+ * shared between threads. */
+void Parser::startIndexingThread()
+{
+    if ( m_isIndexingThreadActive || m_isIndexingCancelled )
+    {
+        return ;
+    }
+
+    /* The previous thread has completed its work but it can be still
+     * running. */
+    if ( m_indexingThread.joinable() )
+    {
+        m_indexingThread.join();
+    }
+
+    m_isIndexingThreadActive = true;
+    try
+    {
+        m_indexingThread = boost::thread(&Parser::doBackgroundIndexing, this);
+    } catch ( std::exception const& )
+    {
+        /* Games will be found on demand. */
+        m_isIndexingThreadActive = false;
+    }
+}
+
+void Parser::cancelIndexing()
+{
+    {
+        boost::unique_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+        m_isIndexingCancelled = true;
+    }
+
+    if ( m_indexingThread.joinable() )
+    {
+        m_indexingThread.join();
+    }
+}
+
+void Parser::getIndexingProgress(unsigned long long& scannedSize,
+    unsigned long long& fileSize, unsigned& gameCount) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    fileSize = m_mappedFile.getFileSize();
+    scannedSize = m_isLightweightParsingDone ? fileSize :
+        m_scanner.getOffset();
+    gameCount = m_gameInFileCache.size();
+}
+
+unsigned Parser::getSelectedGameCount() const
+{
+    unsigned const gameCount = getGameCount();
+    if ( !m_filter )
+    {
+        return gameCount;
+    }
+
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    return m_gameInFileCache.getSelectedCount();
+}
+
+unsigned Parser::getSelectedGame(unsigned n) const
+{
+    if ( n == 0 || n > getSelectedGameCount() )
+    {
+        return 0;
+    }
+
+    if ( !m_filter )
+    {
+        return n;
+    }
+
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    return ( n <= m_gameInFileCache.getSelectedCount() ) ?
+        m_gameInFileCache.getSelected(n - 1) + 1 : 0;
 }
 
 IGame const* Parser::readGame(unsigned gameN)
 {
-    return 0;
+    GameInFile gameInFile;
+    MappedRegionPtr const region = findGame(gameN, gameInFile);
+    return region ? buildGame(gameN, gameInFile, region) : NULL;
 }
 
-IParser* IParser::create(char const* pgnfile, bool isStrict)
+bool Parser::visitGame(IGameVisitor& visitor, unsigned gameN)
 {
-    return new Parser(pgnfile, isStrict);
+    GameInFile gameInFile;
+    MappedRegionPtr const region = findGame(gameN, gameInFile);
+    if ( !region )
+    {
+        return false;
+    }
+
+    unsigned long long const offset = gameInFile.offset[goTagPairSection];
+    GameParser parser(m_isStrict, boost::bind(&Parser::reportError, this,
+        offset, _1, _2, _3, _4));
+    parser.parse(region->getData(offset), gameInFile.size, visitor);
+    return true;
 }
 
-IParser* IParser::create(wchar_t const* pgnfile, bool isStrict)
+/* The game is found like readGame() does (gameN can be NEXT_ITEM) and it
+ * is mapped. If there is no such game, the method returns NULL. */
+MappedRegionPtr Parser::findGame(unsigned& gameN, GameInFile& gameInFile)
 {
-    return new Parser(pgnfile, isStrict);
+    if ( gameN == NEXT_ITEM )
+    {
+        gameN = m_nextGame;
+    }
+    m_nextGame = gameN + 1;
+
+    doLightWeightParsing(gameN);
+
+    if ( ( m_options & poVerifyHash ) && !isGameUnchanged(gameN) )
+    {
+        /* The index is out of date, e.g. the file was rewritten but its size
+         * and modification time are the same (it is possible for files on
+         * network storage). */
+        discardIndex();
+        doLightWeightParsing(gameN);
+    }
+
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    if ( gameN == 0 || gameN > m_gameInFileCache.size() )
+    {
+        return MappedRegionPtr();
+    }
+
+    gameInFile = m_gameInFileCache[gameN - 1];
+    return m_mappedFile.map(gameInFile.offset[goTagPairSection],
+        gameInFile.size);
+}
+
+unsigned Parser::readGames(unsigned firstGame, unsigned count,
+    IGame const** games)
+{
+    if ( firstGame == NEXT_ITEM )
+    {
+        firstGame = m_nextGame;
+    }
+    if ( count > static_cast<unsigned>(-1) - firstGame )
+    {
+        count = static_cast<unsigned>(-1) - firstGame;
+    }
+    m_nextGame = firstGame + count;
+
+    if ( firstGame == 0 || count == 0 )
+    {
+        return 0;
+    }
+
+    unsigned const lastGame = firstGame + count - 1;
+    doLightWeightParsing(lastGame);
+
+    std::vector<GameInFile> gamesInFile;
+    std::vector<MappedRegionPtr> regions;
+    if ( !getGamesInFile(firstGame, count, ( m_options & poVerifyHash ) != 0,
+        gamesInFile, regions) )
+    {
+        /* The index is out of date (see readGame()). */
+        discardIndex();
+        doLightWeightParsing(lastGame);
+        getGamesInFile(firstGame, count, false, gamesInFile, regions);
+    }
+
+    prefetchGamesInFile(gamesInFile, regions);
+    for ( std::size_t i = 0; i < gamesInFile.size(); ++i )
+    {
+        games[i] = buildGame(firstGame + i, gamesInFile[i], regions[i]);
+    }
+
+    return gamesInFile.size();
+}
+
+void Parser::prefetchGames(unsigned firstGame, unsigned count)
+{
+    if ( firstGame == 0 || count == 0 )
+    {
+        return ;
+    }
+
+    std::vector<GameInFile> gamesInFile;
+    std::vector<MappedRegionPtr> regions;
+    getGamesInFile(firstGame, count, false, gamesInFile, regions);
+    prefetchGamesInFile(gamesInFile, regions);
+}
+
+/* Games of the range are copied from the index and mapped under one lock.
+ * The method returns false if a game was changed (see poVerifyHash). */
+bool Parser::getGamesInFile(unsigned firstGame, unsigned count,
+    bool verifyHash, std::vector<GameInFile>& gamesInFile,
+    std::vector<MappedRegionPtr>& regions) const
+{
+    gamesInFile.clear();
+    regions.clear();
+
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    std::size_t const end = std::min<std::size_t>(
+        static_cast<std::size_t>(firstGame) - 1 + count,
+        m_gameInFileCache.size());
+    MappedRegionPtr region;
+    for ( std::size_t i = firstGame - 1; i < end; ++i )
+    {
+        if ( verifyHash && !isGameInFileUnchanged(i) )
+        {
+            return false;
+        }
+
+        /* Neighbouring games are usually in the same window. */
+        GameInFile const& gameInFile = m_gameInFileCache[i];
+        unsigned long long const offset = gameInFile.offset[goTagPairSection];
+        if ( !region || !region->contains(offset, gameInFile.size) )
+        {
+            region = m_mappedFile.map(offset, gameInFile.size);
+            if ( !region )
+            {
+                break;
+            }
+        }
+
+        gamesInFile.push_back(gameInFile);
+        regions.push_back(region);
+    }
+
+    return true;
+}
+
+IGame const* Parser::buildGame(unsigned gameN, GameInFile const& gameInFile,
+    MappedRegionPtr const& region)
+{
+    /* The region keeps the game mapped even if the file is refreshed by
+     * another thread. */
+    unsigned long long const offset = gameInFile.offset[goTagPairSection];
+    boost::intrusive_ptr<GameImpl> game(m_gamePool ?
+        m_gamePool->acquire(gameN) : new GameImpl(gameN));
+
+    /* Both sections are built with the projection which is set now, even
+     * if it is changed by another thread before the movetext is parsed. */
+    boost::shared_ptr<Projection const> projection;
+    {
+        boost::mutex::scoped_lock lock(m_projectionLock);
+        projection = m_projection;
+    }
+    GameBuilder builder(m_isStrict, boost::bind(&Parser::reportError, this,
+        offset, _1, _2, _3, _4), projection.get());
+    std::size_t moveTextOffset = 0;
+    if ( builder.buildTagPairs(region->getData(offset), gameInFile.size,
+        *game, moveTextOffset) )
+    {
+        /* The movetext is parsed when it is needed by the caller. */
+        PendingMoveText const moveText = { m_moveTextSource, region,
+            offset + moveTextOffset, gameInFile.size - moveTextOffset,
+            projection };
+        game->setPendingMoveText(moveText);
+    }
+
+    /* The caller is owner of the game. */
+    game->addRef();
+    return game.get();
+}
+
+bool Parser::reportError(unsigned long long gameOffset, bool isCritical,
+    syntax_error_t code, wchar_t const* description, std::size_t offset)
+{
+    unsigned long long line = 0;
+    unsigned column = 0;
+    getLineAndColumn(gameOffset + offset, line, column);
+    return m_errorHandler(isCritical, code, description, line, column);
+}
+
+/* Usually errors are reported in order of games, thus lines of the file are
+ * counted once. */
+void Parser::getLineAndColumn(unsigned long long offset,
+    unsigned long long& line, unsigned& column)
+{
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    boost::mutex::scoped_lock counterLock(m_lineCounterLock);
+    if ( offset < m_lineCounterOffset )
+    {
+        resetLineCounter();
+    }
+
+    while ( m_lineCounterOffset < offset )
+    {
+        std::size_t const length = static_cast<std::size_t>(std::min<
+            unsigned long long>(offset - m_lineCounterOffset,
+                m_mappedFile.getLengthInWindow(m_lineCounterOffset)));
+        MappedRegionPtr const region = m_mappedFile.map(m_lineCounterOffset,
+            length);
+        if ( !region )
+        {
+            break;
+        }
+
+        char const* const data = region->getData(m_lineCounterOffset);
+        char const* const end = data + length;
+        for ( char const* c = data;
+            ( c = static_cast<char const*>(std::memchr(c, '\n', end - c)) )
+                != NULL; ++c )
+        {
+            ++m_lineCounterLine;
+            m_lineCounterLineStart = m_lineCounterOffset + ( c - data ) + 1;
+        }
+        m_lineCounterOffset += length;
+    }
+
+    line = m_lineCounterLine;
+    column = static_cast<unsigned>(offset - m_lineCounterLineStart + 1);
+}
+
+/* The method should be called under m_lineCounterLock or exclusive lock. */
+void Parser::resetLineCounter()
+{
+    m_lineCounterOffset = 0;
+    m_lineCounterLine = 1;
+    m_lineCounterLineStart = 0;
+}
+
+bool Parser::isGameUnchanged(unsigned gameN) const
+{
+    boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    return gameN == 0 || gameN > m_gameInFileCache.size() ||
+        isGameInFileUnchanged(gameN - 1);
+}
+
+/* The game is checked using its quickhash. The method should be called under
+ * lock. */
+bool Parser::isGameInFileUnchanged(std::size_t index) const
+{
+    GameInFile const game = m_gameInFileCache[index];
+    return game.quickhash != NULL_QUICKHASH &&
+        computeQuickHash(m_mappedFile, game) == game.quickhash;
+}
+
+void Parser::discardIndex()
+{
+    boost::unique_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+    try
+    {
+        m_mappedFile.reopen();
+    } catch ( std::exception const& )
+    {
+        /* The file can't be accessed, thus it looks like an empty file. */
+    }
+
+    m_gameInFileCache.clear();
+    m_scanner.reset(0);
+    restartLightWeightParsing();
+}
+
+/* Results of lightweight parsing are incomplete after the file was changed.
+ * The method should be called under exclusive lock. */
+void Parser::restartLightWeightParsing()
+{
+    m_isLightweightParsingDone = false;
+    {
+        boost::mutex::scoped_lock lock(m_lineCounterLock);
+        resetLineCounter();
+    }
+    if ( m_indexFile )
+    {
+        m_indexFile->setPgnFileInfo(m_mappedFile.getFileInfo());
+    }
+
+    if ( m_options & poAsyncIndexing )
+    {
+        startIndexingThread();
+    }
+}
+
+bool Parser::refresh()
+{
+    unsigned firstChangedGame = 0;
+    file_change_t const change = checkFileChange(firstChangedGame);
+    return change == fcUnchanged || change == fcAppended;
+}
+
+/* The method is called by the thread of m_fileWatcher. The index is updated
+ * in the thread, thus the handler gets numbers of new games. */
+void Parser::onFileChanged()
+{
+    unsigned firstChangedGame = 0;
+    file_change_t const change = checkFileChange(firstChangedGame);
+    if ( change == fcUnchanged || change == fcUnavailable )
+    {
+        /* E.g. the file was removed before it is replaced by another one.
+         * The watcher will notify about the new file. */
+        return ;
+    }
+
+    doLightWeightParsing();
+    unsigned const gameCount = getGameInFileCacheSize();
+
+    boost::intrusive_ptr<IFileChangeCallback> handler;
+    {
+        boost::mutex::scoped_lock lock(m_fileChangeHandlerLock);
+        handler = m_fileChangeHandler;
+    }
+
+    /* The parser can be released by the handler, thus it is the last
+     * access to its members. */
+    if ( handler && ( change == fcRewritten || gameCount > firstChangedGame ) )
+    {
+        (*handler)(change == fcRewritten, firstChangedGame + 1,
+            gameCount - std::min(firstChangedGame, gameCount));
+    }
+}
+
+/* The index is updated according to the change of the file. Games starting
+ * from firstChangedGame (zero-based) have to be found again. */
+Parser::file_change_t Parser::checkFileChange(unsigned& firstChangedGame)
+{
+    boost::unique_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+
+    FileInfo const oldFileInfo = m_mappedFile.getFileInfo();
+    FileInfo fileInfo;
+    if ( !getFileInfo(m_mappedFile.getPath(), fileInfo) )
+    {
+        return fcUnavailable;
+    }
+
+    if ( fileInfo.size == oldFileInfo.size &&
+        fileInfo.modificationTime == oldFileInfo.modificationTime )
+    {
+        firstChangedGame = m_gameInFileCache.size();
+        return fcUnchanged;
+    }
+
+    /* Only new games can be appended to the file. Thus the last indexed
+     * game should be the same. */
+    bool isAppended = false;
+    try
+    {
+        m_mappedFile.reopen();
+        isAppended = m_mappedFile.getFileInfo().size >= oldFileInfo.size &&
+            ( m_gameInFileCache.empty() ||
+                isGameInFileUnchanged(m_gameInFileCache.size() - 1) );
+    } catch ( std::exception const& )
+    {
+        /* The file can't be accessed, thus it looks like an empty file. */
+    }
+
+    if ( !isAppended )
+    {
+        /* The file was rewritten. Nothing from the index can be used. */
+        m_gameInFileCache.clear();
+        m_scanner.reset(0);
+    } else if ( m_isLightweightParsingDone )
+    {
+        /* The last game was completed by the end of file. New moves could
+         * be appended to it, thus it is scanned again. */
+        unsigned long long offset = 0;
+        if ( !m_gameInFileCache.empty() )
+        {
+            offset = m_gameInFileCache.back().offset[goTagPairSection];
+            m_gameInFileCache.pop_back();
+        }
+        m_scanner.reset(offset);
+    }
+
+    firstChangedGame = m_gameInFileCache.size();
+    restartLightWeightParsing();
+    return isAppended ? fcAppended : fcRewritten;
+}
+
+syntax_error_t IParser::isGameValid(IGame const* game, bool deep)
+{
+    if ( game == NULL )
+    {
+        return seUndefinedErrorCode;
+    }
+
+    syntax_error_t const error =
+        static_cast<GameImpl const*>(game)->getSyntaxError();
+    if ( error != seValid || !deep )
+    {
+        return error;
+    }
+
+    for ( variation_t v = MAIN_LINE; v < game->getVariationCount(); ++v )
+    {
+        for ( unsigned n = 1; n <= game->getMoveCount(v); ++n )
+        {
+            syntax_error_t const moveError =
+                IGame::isMoveValid(game->getMove(n, v));
+            if ( moveError != seValid )
+            {
+                return moveError;
+            }
+        }
+    }
+
+    return seValid;
+}
+
+IParser* IParser::create(char const* pgnfile, bool isStrict,
+    unsigned options, tag_predicate_t const* filter)
+{
+    try
+    {
+        return new Parser(pgnfile, isStrict, options, filter);
+    } catch ( std::exception const& )
+    {
+        return NULL;
+    }
+}
+
+IParser* IParser::create(wchar_t const* pgnfile, bool isStrict,
+    unsigned options, tag_predicate_t const* filter)
+{
+    try
+    {
+        return new Parser(pgnfile, isStrict, options, filter);
+    } catch ( std::exception const& )
+    {
+        return NULL;
+    }
 }
 
 } /* namespace pgn */
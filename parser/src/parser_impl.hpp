@@ -22,17 +22,25 @@
 
 #include <pgn/parser.hpp>
 #include "ref_object_impl.hpp"
+#include "game_scanner.hpp"
+#include "index_file.hpp"
+#include "mapped_file.hpp"
+#include "file_watcher.hpp"
+#include "game_impl.hpp"
+#include "projection.hpp"
+#include "tag_filter.hpp"
 
 #include <set>
 #include <functional>
 #include <vector>
 
-#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/locks.hpp>
-#include <boost/spirit/include/qi.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 namespace pgn
 {
@@ -61,10 +69,9 @@ public:
                 return (*m_callback)(isCritical, code, description, line,
                     column);
             }
-        } else
-        {
-            return true;
         }
+
+        return true;
     }
 
 private:
@@ -112,124 +119,106 @@ private:
     boost::intrusive_ptr<IErrorHandlerCallback> m_callback;
 };
 
-namespace qi = boost::spirit::qi;
-
-/* The grammar is used for light weight parsing of PGN file. Here we should
- * skip comments, escape (%), spaces. */
-class LightWeightSkipper : public qi::grammar<char const*>
+class Parser : public RefObject<IParser>
 {
 public:
-    typedef qi::rule<char const*> RuleType;
-
-    RuleType entryPoint; /* entry point into the grammar */
-    LightWeightSkipper() : LightWeightSkipper::base_type(entryPoint)
+    Parser(char const* pgnfile, bool isStrict, unsigned options,
+        tag_predicate_t const* filter)
     {
-        initialize();
+        initialize(pgnfile, isStrict, options, filter);
     }
 
-protected:
-    void initialize();
-
-private:
-    RuleType m_comment;
-    RuleType m_ignoredLine;
-};
-
-/* The grammar is used for light weight parsing of PGN file. */
-class LightWeightGrammar : public qi::grammar<char const*, LightWeightSkipper>
-{
-public:
-    typedef qi::rule<char const*, LightWeightSkipper> RuleType;
-
-    RuleType entryPoint; /* entry point into the grammar */
-    LightWeightGrammar() : LightWeightGrammar::base_type(entryPoint)
+    Parser(wchar_t const* pgnfile, bool isStrict, unsigned options,
+        tag_predicate_t const* filter)
     {
-        initialize();
+        initialize(pgnfile, isStrict, options, filter);
     }
 
-protected:
-    void initialize();
-
-private:
-    RuleType m_tagName;
-    RuleType m_tagValue;
-    RuleType m_tagPair;
-    RuleType m_tagPairSection;
-};
-
-class MappedFile
-{
-public:
-    typedef boost::iostreams::mapped_file_source::size_type size_type;
-    static const size_type DEFAULT_MAPPED_SIZE = 2 * 1024 * 1024; /* 2 Mb */
-
-    MappedFile() : m_offset() {}
+    ~Parser();
 
-    void open(std::string const& path, boost::intmax_t offset = 0,
-        size_type length = DEFAULT_MAPPED_SIZE)
+    void setErrorHandler(IErrorHandlerCallback* callback)
     {
-        m_shift  = offset % m_mappedFileImpl.alignment();
-        m_offset = offset - m_shift;
-        m_mappedFileImpl.open(path, length + m_shift, m_offset);
+        m_errorHandler.setErrorHandler(callback);
     }
 
-    void open(std::wstring const& path, boost::intmax_t offset = 0,
-        size_type length = DEFAULT_MAPPED_SIZE)
+    unsigned getGameCount() const
     {
-        m_shift  = offset % m_mappedFileImpl.alignment();
-        m_offset = offset - m_shift;
+        /* The indexing thread can change the count, thus it is read under
+         * lock. doLightWeightParsing has lock inside. */
+        const_cast<Parser*>(this)->doLightWeightParsing();
+        boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
+        return m_gameCount;
     }
 
-    void close() { m_mappedFileImpl.close(); }
-    bool isOpen() const { return m_mappedFileImpl.is_open(); }
-    char const* getData() const { return m_mappedFileImpl.data() + m_shift; }
-    size_type getMappedSize() const { return m_mappedFileImpl.size(); }
+    IGame const* readGame(unsigned gameN);
 
-    boost::intmax_t getOffsetInFile() const { return m_offset; }
-private:
-    unsigned m_shift;
-    boost::intmax_t m_offset;
-    boost::iostreams::mapped_file_source m_mappedFileImpl;
-};
+    unsigned readGames(unsigned firstGame, unsigned count,
+        IGame const** games);
 
-class Parser : public RefObject<IParser>
-{
-public:
-    Parser(char const* pgnfile, bool isStrict)
-    {
-        initialize(pgnfile, isStrict);
-    }
+    void prefetchGames(unsigned firstGame, unsigned count);
+
+    bool visitGame(IGameVisitor& visitor, unsigned gameN);
 
-    Parser(wchar_t const* pgnfile, bool isStrict)
+    bool refresh();
+
+    void setMappedSizeLimit(unsigned long long size)
     {
-        initialize(pgnfile, isStrict);
+        m_mappedFile.setMappedSizeLimit(size);
     }
 
-    void setErrorHandler(IErrorHandlerCallback* callback)
+    void getIndexingProgress(unsigned long long& scannedSize,
+        unsigned long long& fileSize, unsigned& gameCount) const;
+
+    void cancelIndexing();
+
+    void setFileChangeHandler(IFileChangeCallback* callback)
     {
-        m_errorHandler.setErrorHandler(callback);
+        boost::mutex::scoped_lock lock(m_fileChangeHandlerLock);
+        m_fileChangeHandler = callback;
     }
 
-    unsigned getGameCount() const
+    /* The previous projection is released out of the lock, games which
+     * are being built keep it alive. */
+    void setProjection(char const* const* tagNames, unsigned parts)
     {
-        /* It isn't critical if another thread will set the variable to true.
-         * doLightWeightParsing has lock inside. */
-        if ( !m_isLightweightParsingDone )
-        {
-            const_cast<Parser*>(this)->doLightWeightParsing();
-        }
-
-        return m_gameCount;
+        boost::shared_ptr<Projection const> projection(
+            ( tagNames != NULL || parts != gpAll ) ?
+            new Projection(tagNames, parts) : NULL);
+        boost::mutex::scoped_lock lock(m_projectionLock);
+        m_projection.swap(projection);
     }
 
-    IGame const* readGame(unsigned gameN);
+    unsigned getSelectedGameCount() const;
+    unsigned getSelectedGame(unsigned n) const;
 
 protected:
+    friend class ParallelParser; /* it reads the index of the parser */
+
     Parser(Parser const& ); /* without implementation */
     Parser& operator=(Parser const& ); /* without implementation */
 
     void doLightWeightParsing(unsigned gameN = 0 /* 0 - parse till the eof */);
-    template <typename T> void initialize(T const* pgnfile, bool isStrict);
+    bool scanNextBlock(std::size_t blockSize, unsigned threadCount);
+    void doBackgroundIndexing();
+    void startIndexingThread();
+    template <typename T> void initialize(T const* pgnfile, bool isStrict,
+        unsigned options, tag_predicate_t const* filter);
+    MappedRegionPtr findGame(unsigned& gameN, GameInFile& gameInFile);
+    bool getGamesInFile(unsigned firstGame, unsigned count, bool verifyHash,
+        std::vector<GameInFile>& gamesInFile,
+        std::vector<MappedRegionPtr>& regions) const;
+    IGame const* buildGame(unsigned gameN, GameInFile const& gameInFile,
+        MappedRegionPtr const& region);
+    bool isGameUnchanged(unsigned gameN) const;
+    bool isGameInFileUnchanged(std::size_t index) const;
+    void discardIndex();
+    void restartLightWeightParsing();
+    void onFileChanged();
+    bool reportError(unsigned long long gameOffset, bool isCritical,
+        syntax_error_t code, wchar_t const* description, std::size_t offset);
+    void getLineAndColumn(unsigned long long offset, unsigned long long& line,
+        unsigned& column);
+    void resetLineCounter();
     unsigned getGameInFileCacheSize() const
     {
         boost::shared_lock<boost::shared_mutex> lock(m_gameInFileCacheLock);
@@ -237,34 +226,60 @@ protected:
     }
 
 private:
+    typedef enum
+    {
+        fcUnchanged,
+        fcAppended,
+        fcRewritten,
+        fcUnavailable
+    } file_change_t;
+
+    file_change_t checkFileChange(unsigned& firstChangedGame);
+
     bool m_isStrict; /* is the parser strict (report about each error) */
+    unsigned m_options; /* combination of parser_option_t values */
     unsigned m_gameCount; /* number of games in the PGN file */
+    unsigned m_nextGame; /* game which is read by readGame(NEXT_ITEM) */
 
-    typedef enum
-    {
-        goTagPairSection,
-        goMoveTextSection,
-        goGameOffsetCount
-    } game_offset_t;
-
-    /* It should be as minimal as possible because it will contain information
-     * for all games in the PGN file. We should include quickhash field
-     * because we want to detect cases than a requested game was changed on
-     * disk. The main purpose of the field is to prevent incorrect parsing
-     * of PGN file in case our cache isn't up to date. */
-    struct GameInFile
-    {
-        unsigned quickhash; /* check that the game was not changed */
-        unsigned long long offset[goGameOffsetCount];
-        unsigned size; /* size of the game in bytes */
-    };
+    /* Lightweight parsing is stopped after the block where requested game
+     * was found. */
+    static const std::size_t SCAN_BLOCK_SIZE = 1024 * 1024;
 
     mutable boost::shared_mutex m_gameInFileCacheLock;
     MappedFile m_mappedFile; /* it is used for light weight parsing */
+    GameScanner m_scanner; /* state of light weight parsing */
+    boost::scoped_ptr<TagFilter const> m_filter; /* NULL if there is no
+                                                    filter (see create()) */
     bool m_isLightweightParsingDone; /* the PGN file was parsed till eof */
 
-    std::vector<GameInFile> m_gameInFileCache;
+    GameScanner::GameList m_gameInFileCache;
+    boost::scoped_ptr<IndexFile> m_indexFile; /* see poIndexFile option */
     ErrorHandler m_errorHandler;
+    boost::shared_ptr<GamePool> m_gamePool; /* see poRecycleGames option */
+    boost::shared_ptr<MoveTextSource> m_moveTextSource; /* see readGame() */
+    boost::mutex m_projectionLock; /* games are built by other threads
+                                      (IParallelParser) */
+    boost::shared_ptr<Projection const> m_projection; /* NULL if games are
+                                                         parsed completely */
+
+    /* See poAsyncIndexing option. Flags are protected by
+     * m_gameInFileCacheLock. */
+    boost::thread m_indexingThread;
+    boost::condition_variable_any m_indexingProgress; /* a block is scanned */
+    bool m_isIndexingThreadActive;
+    bool m_isIndexingCancelled;
+
+    /* See poWatchFile option. */
+    FileWatcher m_fileWatcher;
+    boost::mutex m_fileChangeHandlerLock;
+    boost::intrusive_ptr<IFileChangeCallback> m_fileChangeHandler;
+
+    /* Lines are counted for error reports only. Counting is continued from
+     * the last reported position. */
+    boost::mutex m_lineCounterLock;
+    unsigned long long m_lineCounterOffset; /* counted bytes of the file */
+    unsigned long long m_lineCounterLine; /* number of the current line */
+    unsigned long long m_lineCounterLineStart; /* offset of the line */
 };
 
 } /* namespace pgn */
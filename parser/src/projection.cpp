@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projection.hpp"
+
+#include <cstring>
+
+namespace pgn
+{
+
+/* The result of a game depends on Result tag, moves are resolved from the
+ * position of FEN tag, thus such tags are kept anyway. */
+Projection::Projection(char const* const* tagNames, unsigned parts)
+    : m_isEveryTagKept(tagNames == NULL), m_parts(parts)
+{
+    /* Moves of variations are children of moves of the main line. */
+    if ( !hasPart(gpMoves) )
+    {
+        m_parts &= ~( gpVariations | gpComments | gpNAGs );
+    }
+
+    for ( ; tagNames != NULL && *tagNames != NULL; ++tagNames )
+    {
+        m_tagNames.push_back(*tagNames);
+    }
+    m_tagNames.push_back("Result");
+    if ( hasPart(gpMoves) )
+    {
+        m_tagNames.push_back("FEN");
+        m_tagNames.push_back("SetUp");
+    }
+}
+
+bool Projection::isTagKept(char const* name, std::size_t length) const
+{
+    if ( m_isEveryTagKept )
+    {
+        return true;
+    }
+
+    for ( std::size_t i = 0; i < m_tagNames.size(); ++i )
+    {
+        if ( m_tagNames[i].size() == length &&
+            std::memcmp(m_tagNames[i].data(), name, length) == 0 )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} /* namespace pgn */
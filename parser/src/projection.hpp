@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_PROJECTION_HPP
+#define PGN_PROJECTION_HPP
+
+#include <pgn/parser.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pgn
+{
+
+/* Parts of games which are kept by GameBuilder (see
+ * IParser::setProjection()). It isn't changed after construction, thus it
+ * is shared by games without locking. */
+class Projection
+{
+public:
+    /* tagNames is a NULL-terminated array or NULL (all tags are kept). */
+    Projection(char const* const* tagNames, unsigned parts);
+
+    bool isTagKept(char const* name, std::size_t length) const;
+    bool hasPart(game_part_t part) const { return ( m_parts & part ) != 0; }
+
+private:
+    bool m_isEveryTagKept;
+    std::vector<std::string> m_tagNames; /* usually there are a few names */
+    unsigned m_parts; /* combination of game_part_t values */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_PROJECTION_HPP */
@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quick_hash.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace pgn
+{
+
+namespace
+{
+
+inline boost::uint32_t rotl(boost::uint32_t value, unsigned shift)
+{
+    return ( value << shift ) | ( value >> ( 32 - shift ) );
+}
+
+} /* unnamed namespace */
+
+void QuickHash::reset()
+{
+    for ( std::size_t i = 0; i < simd::HASH_LANE_COUNT; ++i )
+    {
+        m_acc[i] = PRIME5 * static_cast<boost::uint32_t>(i + 1);
+    }
+    m_bufferSize = 0;
+    m_size = 0;
+}
+
+void QuickHash::update(char const* data, std::size_t size)
+{
+    if ( size == 0 )
+    {
+        return ;
+    }
+    m_size += size;
+
+    if ( m_bufferSize != 0 )
+    {
+        std::size_t const count = std::min(size,
+            simd::HASH_STRIPE_SIZE - m_bufferSize);
+        std::memcpy(m_buffer + m_bufferSize, data, count);
+        m_bufferSize += count;
+        data += count;
+        size -= count;
+        if ( m_bufferSize != simd::HASH_STRIPE_SIZE )
+        {
+            return ;
+        }
+
+        simd::hashStripes(m_acc, m_buffer, 1);
+        m_bufferSize = 0;
+    }
+
+    std::size_t const stripeCount = size / simd::HASH_STRIPE_SIZE;
+    simd::hashStripes(m_acc, data, stripeCount);
+    data += stripeCount * simd::HASH_STRIPE_SIZE;
+    size -= stripeCount * simd::HASH_STRIPE_SIZE;
+
+    std::memcpy(m_buffer, data, size);
+    m_bufferSize = size;
+}
+
+unsigned QuickHash::finish() const
+{
+    boost::uint32_t hash = static_cast<boost::uint32_t>(m_size);
+    for ( std::size_t i = 0; i < simd::HASH_LANE_COUNT; ++i )
+    {
+        hash += rotl(m_acc[i], static_cast<unsigned>(1 + i * 4));
+    }
+
+    unsigned char const* it = reinterpret_cast<unsigned char const*>(m_buffer);
+    unsigned char const* const end = it + m_bufferSize;
+    for ( ; end - it >= 4; it += 4 )
+    {
+        boost::uint32_t const value = it[0] | ( it[1] << 8 ) |
+            ( it[2] << 16 ) | ( static_cast<boost::uint32_t>(it[3]) << 24 );
+        hash = rotl(hash + value * PRIME3, 17) * PRIME4;
+    }
+    for ( ; it != end; ++it )
+    {
+        hash = rotl(hash + *it * PRIME5, 11) * PRIME1;
+    }
+
+    hash ^= hash >> 15;
+    hash *= PRIME2;
+    hash ^= hash >> 13;
+    hash *= PRIME3;
+    hash ^= hash >> 16;
+
+    return hash != NULL_QUICKHASH ? hash : hash + 1;
+}
+
+unsigned computeQuickHash(char const* data, std::size_t size)
+{
+    QuickHash hash;
+    hash.update(data, size);
+    return hash.finish();
+}
+
+} /* namespace pgn */
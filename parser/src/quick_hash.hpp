@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_QUICK_HASH_HPP
+#define PGN_QUICK_HASH_HPP
+
+#include "simd.hpp"
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+
+namespace pgn
+{
+
+/* The value of GameInFile::quickhash which means that the hash of the game
+ * was not computed yet. computeQuickHash() never returns it. */
+const unsigned NULL_QUICKHASH = 0;
+
+/* Constants of xxHash32. They are shared by the streaming part of the hash
+ * and by lanes of simd::hashStripes(), thus they are defined once: hashes
+ * which are saved in index files depend on them. */
+const boost::uint32_t PRIME1 = 2654435761U;
+const boost::uint32_t PRIME2 = 2246822519U;
+const boost::uint32_t PRIME3 = 3266489917U;
+const boost::uint32_t PRIME4 = 668265263U;
+const boost::uint32_t PRIME5 = 374761393U;
+
+/* Non-cryptographic hash of a game. It is used to detect that a game was
+ * changed on disk. It is a variant of xxHash32 with 8 lanes (see
+ * simd::hashStripes) which is computed by pieces: the scanner hashes each
+ * game while it looks for game boundaries. The result doesn't depend on how
+ * data is split into pieces. */
+class QuickHash
+{
+public:
+    QuickHash() { reset(); }
+
+    void reset();
+    void update(char const* data, std::size_t size);
+
+    /* Get the hash of all data which was passed to update(). */
+    unsigned finish() const;
+
+private:
+    boost::uint32_t m_acc[simd::HASH_LANE_COUNT];
+    char m_buffer[simd::HASH_STRIPE_SIZE]; /* incomplete stripe */
+    std::size_t m_bufferSize;
+    unsigned long long m_size; /* total size of data */
+};
+
+/* Compute the hash of the data at once. */
+unsigned computeQuickHash(char const* data, std::size_t size);
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_QUICK_HASH_HPP */
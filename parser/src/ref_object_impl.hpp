@@ -34,7 +34,7 @@ class RefObject : public T
 public:
     RefObject() : m_counter(0) {}
 
-    unsigned addRef()
+    unsigned addRef() const
     {
 #ifndef PGN_LIB_SINGLE_THREAD
         boost::mutex::scoped_lock lock(m_mutex);
@@ -42,7 +42,7 @@ public:
         return ++m_counter;
     }
 
-    unsigned release()
+    unsigned release() const
     {
         if ( _release() == 0 )
         {
@@ -54,7 +54,7 @@ public:
     }
 
 protected:
-    unsigned _release()
+    unsigned _release() const
     {
 #ifndef PGN_LIB_SINGLE_THREAD
         boost::mutex::scoped_lock lock(m_mutex);
@@ -63,9 +63,9 @@ protected:
     }
 
 private:
-    unsigned m_counter;
+    mutable unsigned m_counter;
 #ifndef PGN_LIB_SINGLE_THREAD
-    boost::mutex m_mutex;
+    mutable boost::mutex m_mutex;
 #endif
 };
 
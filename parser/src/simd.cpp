@@ -0,0 +1,252 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "simd.hpp"
+#include "quick_hash.hpp"
+
+#include <cstring>
+
+#if !defined(PGN_LIB_NO_SIMD) && defined(__GNUC__) && \
+    ( defined(__x86_64__) || defined(__i386__) )
+#define PGN_LIB_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace pgn
+{
+
+namespace simd
+{
+
+namespace
+{
+
+typedef char const* (*FindFirstOfFunc)(char const*, char const*, char, char,
+    char);
+typedef void (*HashStripesFunc)(boost::uint32_t*, char const*, std::size_t);
+
+struct Implementation
+{
+    char const* name;
+    FindFirstOfFunc findFirstOf;
+    HashStripesFunc hashStripes;
+};
+
+char const* findFirstOfScalar(char const* it, char const* end, char a,
+    char b, char c)
+{
+    for ( ; it != end; ++it )
+    {
+        char const ch = *it;
+        if ( ch == a || ch == b || ch == c )
+        {
+            break;
+        }
+    }
+
+    return it;
+}
+
+/* Lanes are read in little endian byte order, thus the result doesn't
+ * depend on the platform. */
+void hashStripesScalar(boost::uint32_t* acc, char const* data,
+    std::size_t stripeCount)
+{
+    unsigned char const* it = reinterpret_cast<unsigned char const*>(data);
+    for ( std::size_t i = 0; i < stripeCount; ++i )
+    {
+        for ( std::size_t lane = 0; lane < HASH_LANE_COUNT; ++lane, it += 4 )
+        {
+            boost::uint32_t const value = it[0] | ( it[1] << 8 ) |
+                ( it[2] << 16 ) | ( static_cast<boost::uint32_t>(it[3]) << 24 );
+            boost::uint32_t const sum = acc[lane] + value * PRIME2;
+            acc[lane] = ( ( sum << 13 ) | ( sum >> 19 ) ) * PRIME1;
+        }
+    }
+}
+
+#ifdef PGN_LIB_X86_SIMD
+__attribute__((target("sse2")))
+char const* findFirstOfSse2(char const* it, char const* end, char a, char b,
+    char c)
+{
+    __m128i const va = _mm_set1_epi8(a);
+    __m128i const vb = _mm_set1_epi8(b);
+    __m128i const vc = _mm_set1_epi8(c);
+
+    while ( end - it >= 16 )
+    {
+        __m128i const chunk =
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(it));
+        __m128i const eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)),
+            _mm_cmpeq_epi8(chunk, vc));
+        unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if ( mask != 0 )
+        {
+            return it + __builtin_ctz(mask);
+        }
+        it += 16;
+    }
+
+    return findFirstOfScalar(it, end, a, b, c);
+}
+
+__attribute__((target("avx2")))
+char const* findFirstOfAvx2(char const* it, char const* end, char a, char b,
+    char c)
+{
+    __m256i const va = _mm256_set1_epi8(a);
+    __m256i const vb = _mm256_set1_epi8(b);
+    __m256i const vc = _mm256_set1_epi8(c);
+
+    while ( end - it >= 32 )
+    {
+        __m256i const chunk =
+            _mm256_loadu_si256(reinterpret_cast<__m256i const*>(it));
+        __m256i const eq = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, va),
+                _mm256_cmpeq_epi8(chunk, vb)),
+            _mm256_cmpeq_epi8(chunk, vc));
+        unsigned const mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if ( mask != 0 )
+        {
+            return it + __builtin_ctz(mask);
+        }
+        it += 32;
+    }
+
+    return findFirstOfSse2(it, end, a, b, c);
+}
+
+/* SSE2 doesn't have multiplication of 32-bit integers with 32-bit result.
+ * Odd and even lanes are multiplied separately. */
+__attribute__((target("sse2")))
+inline __m128i mulLoSse2(__m128i a, __m128i b)
+{
+    __m128i const even = _mm_mul_epu32(a, b);
+    __m128i const odd = _mm_mul_epu32(_mm_srli_si128(a, 4),
+        _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+__attribute__((target("sse2")))
+void hashStripesSse2(boost::uint32_t* acc, char const* data,
+    std::size_t stripeCount)
+{
+    __m128i const prime1 = _mm_set1_epi32(static_cast<int>(PRIME1));
+    __m128i const prime2 = _mm_set1_epi32(static_cast<int>(PRIME2));
+    __m128i acc0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(acc));
+    __m128i acc1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(acc + 4));
+
+    for ( std::size_t i = 0; i < stripeCount; ++i, data += HASH_STRIPE_SIZE )
+    {
+        __m128i sum0 = _mm_add_epi32(acc0, mulLoSse2(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(data)), prime2));
+        __m128i sum1 = _mm_add_epi32(acc1, mulLoSse2(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16)),
+            prime2));
+        sum0 = _mm_or_si128(_mm_slli_epi32(sum0, 13), _mm_srli_epi32(sum0, 19));
+        sum1 = _mm_or_si128(_mm_slli_epi32(sum1, 13), _mm_srli_epi32(sum1, 19));
+        acc0 = mulLoSse2(sum0, prime1);
+        acc1 = mulLoSse2(sum1, prime1);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc), acc0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 4), acc1);
+}
+
+__attribute__((target("avx2")))
+void hashStripesAvx2(boost::uint32_t* acc, char const* data,
+    std::size_t stripeCount)
+{
+    __m256i const prime1 = _mm256_set1_epi32(static_cast<int>(PRIME1));
+    __m256i const prime2 = _mm256_set1_epi32(static_cast<int>(PRIME2));
+    __m256i value = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(acc));
+
+    for ( std::size_t i = 0; i < stripeCount; ++i, data += HASH_STRIPE_SIZE )
+    {
+        __m256i sum = _mm256_add_epi32(value, _mm256_mullo_epi32(
+            _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data)),
+            prime2));
+        sum = _mm256_or_si256(_mm256_slli_epi32(sum, 13),
+            _mm256_srli_epi32(sum, 19));
+        value = _mm256_mullo_epi32(sum, prime1);
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), value);
+}
+#endif /* #ifdef PGN_LIB_X86_SIMD */
+
+Implementation selectImplementation()
+{
+#ifdef PGN_LIB_X86_SIMD
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") )
+    {
+        Implementation const impl = { "avx2", findFirstOfAvx2,
+            hashStripesAvx2 };
+        return impl;
+    }
+
+    if ( __builtin_cpu_supports("sse2") )
+    {
+        Implementation const impl = { "sse2", findFirstOfSse2,
+            hashStripesSse2 };
+        return impl;
+    }
+#endif /* #ifdef PGN_LIB_X86_SIMD */
+
+    Implementation const impl = { "scalar", findFirstOfScalar,
+        hashStripesScalar };
+    return impl;
+}
+
+Implementation const g_implementation = selectImplementation();
+
+} /* unnamed namespace */
+
+char const* findFirstOf(char const* begin, char const* end, char a, char b,
+    char c)
+{
+    return g_implementation.findFirstOf(begin, end, a, b, c);
+}
+
+char const* find(char const* begin, char const* end, char c)
+{
+    /* memchr is already vectorized by any decent C runtime. */
+    void const* found = std::memchr(begin, c, end - begin);
+    return found != NULL ? static_cast<char const*>(found) : end;
+}
+
+void hashStripes(boost::uint32_t* acc, char const* data,
+    std::size_t stripeCount)
+{
+    g_implementation.hashStripes(acc, data, stripeCount);
+}
+
+char const* getImplementationName()
+{
+    return g_implementation.name;
+}
+
+} /* namespace simd */
+
+} /* namespace pgn */
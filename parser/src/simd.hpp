@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_SIMD_HPP
+#define PGN_SIMD_HPP
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
+
+namespace pgn
+{
+
+/* Low level primitives for scanning of raw PGN data. The best implementation
+ * (AVX2, SSE2 or plain C++) is selected once at runtime depending on the CPU.
+ * Define PGN_LIB_NO_SIMD to build only the portable implementation. */
+namespace simd
+{
+
+/* Find the first character in [begin, end) which is equal to one of a, b
+ * or c. The method returns end if there is no such character. */
+char const* findFirstOf(char const* begin, char const* end, char a, char b,
+    char c);
+
+/* Find the first character in [begin, end) which is equal to c. The method
+ * returns end if there is no such character. */
+char const* find(char const* begin, char const* end, char c);
+
+const std::size_t HASH_LANE_COUNT = 8;
+const std::size_t HASH_STRIPE_SIZE = HASH_LANE_COUNT * 4; /* bytes */
+
+/* Update accumulators of quickhash (see quick_hash.hpp) by stripeCount
+ * stripes of data. Each 32-bit lane of a stripe is mixed into its own
+ * accumulator (as in xxHash32), thus all implementations give the same
+ * result. */
+void hashStripes(boost::uint32_t* acc, char const* data,
+    std::size_t stripeCount);
+
+/* Get name of the implementation which was selected at runtime ("avx2",
+ * "sse2" or "scalar"). */
+char const* getImplementationName();
+
+} /* namespace simd */
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_SIMD_HPP */
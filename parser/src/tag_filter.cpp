@@ -0,0 +1,291 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tag_filter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace pgn
+{
+
+namespace
+{
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* Compare an escaped tag value with a string. If isPrefix is true then the
+ * string can be a prefix of the value. */
+bool isValueEqual(char const* value, std::size_t length, std::string const& s,
+    bool isPrefix)
+{
+    std::size_t j = 0;
+    for ( std::size_t i = 0; i < length; ++i, ++j )
+    {
+        if ( value[i] == '\\' && i + 1 < length )
+        {
+            ++i;
+        }
+        if ( j == s.size() )
+        {
+            return isPrefix;
+        }
+        if ( value[i] != s[j] )
+        {
+            return false;
+        }
+    }
+
+    return j == s.size();
+}
+
+/* Parse an integer value (e.g. "2650"), anything else isn't a number. */
+bool parseNumber(char const* value, std::size_t length, long long& number)
+{
+    std::size_t i = ( length != 0 && ( *value == '-' || *value == '+' ) ) ?
+        1 : 0;
+    if ( i == length || length - i > 18 )
+    {
+        return false;
+    }
+
+    number = 0;
+    for ( ; i < length; ++i )
+    {
+        if ( value[i] < '0' || value[i] > '9' )
+        {
+            return false;
+        }
+        number = number * 10 + ( value[i] - '0' );
+    }
+
+    if ( *value == '-' )
+    {
+        number = -number;
+    }
+    return true;
+}
+
+/* Parse a field of a date. Unknown field ("??" or absent) is replaced by
+ * defaultValue. */
+bool parseDateField(char const*& c, char const* end, long long defaultValue,
+    long long& field)
+{
+    char const* const begin = c;
+    while ( c != end && *c != '.' )
+    {
+        ++c;
+    }
+
+    char const* const fieldEnd = c;
+    if ( c != end )
+    {
+        ++c;
+    }
+
+    if ( std::count(begin, fieldEnd, '?') == fieldEnd - begin )
+    {
+        field = defaultValue;
+        return true;
+    }
+
+    return parseNumber(begin, fieldEnd - begin, field);
+}
+
+/* Convert a date (YYYY.MM.DD) into YYYYMMDD number. Unknown month or day is
+ * replaced by the first or the last one, thus both bounds of the date can
+ * be found. The year should be known. */
+bool parseDate(char const* value, std::size_t length, bool isUpperBound,
+    long long& date)
+{
+    char const* c = value;
+    char const* const end = value + length;
+    long long year = 0;
+    long long month = 0;
+    long long day = 0;
+    if ( !parseDateField(c, end, -1, year) || year < 0 ||
+        !parseDateField(c, end, isUpperBound ? 12 : 1, month) ||
+        !parseDateField(c, end, isUpperBound ? 31 : 1, day) )
+    {
+        return false;
+    }
+
+    date = ( year * 100 + month ) * 100 + day;
+    return true;
+}
+
+} /* unnamed namespace */
+
+TagFilter::TagFilter(tag_predicate_t const* predicates)
+{
+    for ( ; predicates != NULL && predicates->name != NULL; ++predicates )
+    {
+        Predicate predicate;
+        predicate.name = predicates->name;
+        predicate.kind = predicates->kind;
+        predicate.value = ( predicates->value != NULL ) ?
+            predicates->value : "";
+        predicate.minNumber = std::numeric_limits<long long>::min();
+        predicate.maxNumber = std::numeric_limits<long long>::max();
+        predicate.isAlternative = predicates->isAlternative;
+
+        /* Bounds which can't be parsed are ignored. */
+        char const* const minValue = predicates->value;
+        char const* const maxValue = predicates->maxValue;
+        if ( predicate.kind == tpNumberRange )
+        {
+            long long number = 0;
+            if ( minValue != NULL &&
+                parseNumber(minValue, std::strlen(minValue), number) )
+            {
+                predicate.minNumber = number;
+            }
+            if ( maxValue != NULL &&
+                parseNumber(maxValue, std::strlen(maxValue), number) )
+            {
+                predicate.maxNumber = number;
+            }
+        } else if ( predicate.kind == tpDateRange )
+        {
+            long long date = 0;
+            if ( minValue != NULL &&
+                parseDate(minValue, std::strlen(minValue), false, date) )
+            {
+                predicate.minNumber = date;
+            }
+            if ( maxValue != NULL &&
+                parseDate(maxValue, std::strlen(maxValue), true, date) )
+            {
+                predicate.maxNumber = date;
+            }
+        }
+
+        m_predicates.push_back(predicate);
+    }
+}
+
+void TagFilter::checkTagLine(char const* begin, char const* end,
+    Matches& matches) const
+{
+    /* Usually there is one tag pair in a line, but import format allows
+     * several of them. */
+    char const* c = begin;
+    while ( ( c = std::find(c, end, '[') ) != end )
+    {
+        ++c;
+        while ( c != end && isSpace(*c) )
+        {
+            ++c;
+        }
+        char const* const name = c;
+        while ( c != end && !isSpace(*c) && *c != '"' && *c != ']' )
+        {
+            ++c;
+        }
+        char const* const nameEnd = c;
+        while ( c != end && isSpace(*c) )
+        {
+            ++c;
+        }
+        if ( c == end || *c != '"' )
+        {
+            continue;
+        }
+
+        char const* const value = ++c;
+        while ( c != end && *c != '"' )
+        {
+            /* Escaped character (\" or \\) is skipped. */
+            c += ( *c == '\\' && c + 1 != end ) ? 2 : 1;
+        }
+        if ( c == end )
+        {
+            break;
+        }
+
+        checkTagPair(name, nameEnd - name, value, c - value, matches);
+        ++c;
+    }
+}
+
+void TagFilter::checkTagPair(char const* name, std::size_t nameLength,
+    char const* value, std::size_t valueLength, Matches& matches) const
+{
+    for ( std::size_t i = 0; i < m_predicates.size(); ++i )
+    {
+        Predicate const& predicate = m_predicates[i];
+        if ( matches[i] || predicate.name.size() != nameLength ||
+            predicate.name.compare(0, nameLength, name, nameLength) != 0 )
+        {
+            continue;
+        }
+
+        long long number = 0;
+        long long lastDate = 0;
+        switch ( predicate.kind )
+        {
+        case tpEqual:
+            matches[i] = isValueEqual(value, valueLength, predicate.value,
+                false);
+            break;
+        case tpPrefix:
+            matches[i] = isValueEqual(value, valueLength, predicate.value,
+                true);
+            break;
+        case tpNumberRange:
+            matches[i] = parseNumber(value, valueLength, number) &&
+                number >= predicate.minNumber &&
+                number <= predicate.maxNumber;
+            break;
+        case tpDateRange:
+            /* The date can be partially unknown, thus it is a range too. */
+            matches[i] = parseDate(value, valueLength, false, number) &&
+                parseDate(value, valueLength, true, lastDate) &&
+                lastDate >= predicate.minNumber &&
+                number <= predicate.maxNumber;
+            break;
+        }
+    }
+}
+
+/* Alternatives are joined by OR into groups, groups are joined by AND. */
+bool TagFilter::isSelected(Matches const& matches) const
+{
+    bool isGroupMatched = true;
+    for ( std::size_t i = 0; i < m_predicates.size(); ++i )
+    {
+        if ( i == 0 || !m_predicates[i].isAlternative )
+        {
+            if ( !isGroupMatched )
+            {
+                return false;
+            }
+            isGroupMatched = false;
+        }
+        isGroupMatched = isGroupMatched || matches[i];
+    }
+
+    return isGroupMatched;
+}
+
+} /* namespace pgn */
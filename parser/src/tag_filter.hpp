@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_TAG_FILTER_HPP
+#define PGN_TAG_FILTER_HPP
+
+#include <pgn/parser.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pgn
+{
+
+/* Predicates on tags which select games during lightweight parsing (see
+ * IParser::create()). Tag pairs are checked as they are written in the file,
+ * thus values are unescaped on the fly and nothing is copied. A game is
+ * checked in two steps: each tag pair sets flags of predicates which it
+ * satisfies, then the flags are combined when the game is complete. */
+class TagFilter
+{
+public:
+    /* Flags of satisfied predicates of a game. */
+    typedef std::vector<bool> Matches;
+
+    /* predicates is terminated by a predicate with NULL name. */
+    explicit TagFilter(tag_predicate_t const* predicates);
+
+    std::size_t getPredicateCount() const { return m_predicates.size(); }
+
+    /* Check tag pairs of a line of the tag pair section, the line starts
+     * with '[' and it doesn't include the end of line. */
+    void checkTagLine(char const* begin, char const* end,
+        Matches& matches) const;
+
+    bool isSelected(Matches const& matches) const;
+
+private:
+    struct Predicate
+    {
+        std::string name;
+        tag_predicate_kind_t kind;
+        std::string value;
+        long long minNumber; /* bounds of tpNumberRange and tpDateRange */
+        long long maxNumber;
+        bool isAlternative;
+    };
+
+    void checkTagPair(char const* name, std::size_t nameLength,
+        char const* value, std::size_t valueLength, Matches& matches) const;
+
+    std::vector<Predicate> m_predicates;
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_TAG_FILTER_HPP */
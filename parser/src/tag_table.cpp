@@ -0,0 +1,217 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tag_table.hpp"
+
+#include <cstring>
+
+namespace pgn
+{
+
+namespace
+{
+
+/* STR tags go first, thus their indexes are values of roster_tag_t. Others
+ * are from the PGN standard and popular extensions. */
+char const* const WELL_KNOWN_NAMES[] =
+{
+    "Event", "Site", "Date", "Round", "White", "Black", "Result",
+    "WhiteTitle", "BlackTitle", "WhiteElo", "BlackElo", "WhiteUSCF",
+    "BlackUSCF", "WhiteNA", "BlackNA", "WhiteType", "BlackType",
+    "WhiteFideId", "BlackFideId", "WhiteTeam", "BlackTeam", "EventDate",
+    "EventSponsor", "EventType", "EventRounds", "EventCountry", "Section",
+    "Stage", "Board", "Opening", "Variation", "SubVariation", "ECO", "NIC",
+    "Time", "UTCTime", "UTCDate", "TimeControl", "SetUp", "FEN",
+    "Termination", "Annotator", "Mode", "PlyCount", "Source", "SourceDate"
+};
+
+std::size_t const WELL_KNOWN_NAME_COUNT =
+    sizeof(WELL_KNOWN_NAMES) / sizeof(WELL_KNOWN_NAMES[0]);
+
+/* FNV-1a */
+std::size_t hashName(char const* name, std::size_t length)
+{
+    std::size_t hash = 2166136261u;
+    for ( std::size_t i = 0; i < length; ++i )
+    {
+        hash = ( hash ^ static_cast<unsigned char>(name[i]) ) * 16777619u;
+    }
+
+    return hash;
+}
+
+/* It is initialized before main(), thus there is no race between threads. */
+TagTable TAG_TABLE;
+
+} /* unnamed namespace */
+
+const std::size_t NameSet::NOT_FOUND;
+
+std::size_t NameSet::find(char const* name, std::size_t length,
+    std::size_t hash) const
+{
+    unsigned const index = m_slots[findSlot(name, length, hash)];
+    return ( index != 0 ) ? index - 1 : NOT_FOUND;
+}
+
+std::size_t NameSet::insert(char const* name, std::size_t length,
+    std::size_t hash)
+{
+    /* The load factor is kept below 1/2. */
+    if ( ( m_names.size() + 1 ) * 2 > m_slots.size() )
+    {
+        grow();
+    }
+
+    std::size_t const slot = findSlot(name, length, hash);
+    m_names.push_back(std::string(name, length));
+    m_hashes.push_back(hash);
+    m_slots[slot] = m_names.size();
+    return m_names.size() - 1;
+}
+
+std::size_t NameSet::findSlot(char const* name, std::size_t length,
+    std::size_t hash) const
+{
+    std::size_t const mask = m_slots.size() - 1;
+    for ( std::size_t slot = hash & mask; ; slot = ( slot + 1 ) & mask )
+    {
+        unsigned const index = m_slots[slot];
+        if ( index == 0 )
+        {
+            return slot;
+        }
+
+        std::string const& candidate = m_names[index - 1];
+        if ( m_hashes[index - 1] == hash && candidate.size() == length &&
+            std::memcmp(candidate.data(), name, length) == 0 )
+        {
+            return slot;
+        }
+    }
+}
+
+void NameSet::grow()
+{
+    std::vector<unsigned> slots(m_slots.size() * 2, 0);
+    std::size_t const mask = slots.size() - 1;
+    for ( std::size_t i = 0; i < m_names.size(); ++i )
+    {
+        std::size_t slot = m_hashes[i] & mask;
+        while ( slots[slot] != 0 )
+        {
+            slot = ( slot + 1 ) & mask;
+        }
+        slots[slot] = i + 1;
+    }
+
+    m_slots.swap(slots);
+}
+
+const std::size_t TagTable::MAX_OTHER_NAMES;
+
+TagTable::TagTable()
+{
+    for ( std::size_t i = 0; i < WELL_KNOWN_NAME_COUNT; ++i )
+    {
+        char const* const name = WELL_KNOWN_NAMES[i];
+        std::size_t const length = std::strlen(name);
+        m_wellKnownNames.insert(name, length, hashName(name, length));
+    }
+}
+
+TagTable& TagTable::getInstance()
+{
+    return TAG_TABLE;
+}
+
+tag_id_t TagTable::intern(char const* name, std::size_t length,
+    char const** internedName)
+{
+    std::size_t const hash = hashName(name, length);
+    std::size_t index = m_wellKnownNames.find(name, length, hash);
+    if ( index != NameSet::NOT_FOUND )
+    {
+        if ( internedName != NULL )
+        {
+            *internedName = m_wellKnownNames.getName(index);
+        }
+        return index;
+    }
+
+    boost::mutex::scoped_lock lock(m_otherNamesLock);
+    index = m_otherNames.find(name, length, hash);
+    if ( index == NameSet::NOT_FOUND )
+    {
+        if ( m_otherNames.size() >= MAX_OTHER_NAMES )
+        {
+            return NULL_TAG_ID;
+        }
+        index = m_otherNames.insert(name, length, hash);
+    }
+
+    if ( internedName != NULL )
+    {
+        *internedName = m_otherNames.getName(index);
+    }
+    return WELL_KNOWN_NAME_COUNT + index;
+}
+
+tag_id_t TagTable::find(char const* name, std::size_t length,
+    char const** internedName) const
+{
+    std::size_t const hash = hashName(name, length);
+    std::size_t index = m_wellKnownNames.find(name, length, hash);
+    if ( index != NameSet::NOT_FOUND )
+    {
+        if ( internedName != NULL )
+        {
+            *internedName = m_wellKnownNames.getName(index);
+        }
+        return index;
+    }
+
+    boost::mutex::scoped_lock lock(m_otherNamesLock);
+    index = m_otherNames.find(name, length, hash);
+    if ( index == NameSet::NOT_FOUND )
+    {
+        return NULL_TAG_ID;
+    }
+
+    if ( internedName != NULL )
+    {
+        *internedName = m_otherNames.getName(index);
+    }
+    return WELL_KNOWN_NAME_COUNT + index;
+}
+
+char const* TagTable::getName(tag_id_t id) const
+{
+    if ( id < WELL_KNOWN_NAME_COUNT )
+    {
+        return m_wellKnownNames.getName(id);
+    }
+
+    boost::mutex::scoped_lock lock(m_otherNamesLock);
+    std::size_t const index = id - WELL_KNOWN_NAME_COUNT;
+    return ( index < m_otherNames.size() ) ?
+        m_otherNames.getName(index) : NULL;
+}
+
+} /* namespace pgn */
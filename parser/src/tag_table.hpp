@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_TAG_TABLE_HPP
+#define PGN_TAG_TABLE_HPP
+
+#include <pgn/game.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+namespace pgn
+{
+
+/* Open addressing hash table of names (linear probing). Pointers to names
+ * stay valid when the table grows. It isn't thread-safe. */
+class NameSet
+{
+public:
+    static const std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+    NameSet() : m_slots(64, 0) {}
+
+    /* The method returns index of the name or NOT_FOUND. */
+    std::size_t find(char const* name, std::size_t length,
+        std::size_t hash) const;
+
+    /* Add a name which isn't in the table. The method returns its index. */
+    std::size_t insert(char const* name, std::size_t length,
+        std::size_t hash);
+
+    char const* getName(std::size_t index) const
+    {
+        return m_names[index].c_str();
+    }
+    std::size_t size() const { return m_names.size(); }
+
+private:
+    /* The method returns the slot of the name or an empty slot. */
+    std::size_t findSlot(char const* name, std::size_t length,
+        std::size_t hash) const;
+    void grow();
+
+    std::vector<unsigned> m_slots; /* index of a name + 1, 0 is empty */
+    std::vector<std::size_t> m_hashes; /* hash of each name */
+    std::deque<std::string> m_names;
+};
+
+/* Names of tags which are shared by all parsers and games. STR tags have
+ * identifiers from roster_tag_t, other well-known tags are also added at
+ * startup and they are found without locking. Other names are added when
+ * a caller asks for their identifiers (IGame::getTagId(...)), names of
+ * parsed files are only looked up. Names are never removed, thus there is
+ * a limit on their number. */
+class TagTable
+{
+public:
+    static const std::size_t MAX_OTHER_NAMES = 4096;
+
+    TagTable();
+
+    /* The table of the process. */
+    static TagTable& getInstance();
+
+    /* Get an identifier of the name. The name is added if it isn't in the
+     * table, its copy is returned (if the pointer isn't NULL). If the table
+     * is full NULL_TAG_ID is returned. */
+    tag_id_t intern(char const* name, std::size_t length,
+        char const** internedName = NULL);
+
+    /* The same, but the name isn't added. */
+    tag_id_t find(char const* name, std::size_t length,
+        char const** internedName = NULL) const;
+
+    char const* getName(tag_id_t id) const;
+
+private:
+    TagTable(TagTable const& ); /* without implementation */
+    TagTable& operator=(TagTable const& ); /* without implementation */
+
+    NameSet m_wellKnownNames; /* it isn't changed after construction */
+    mutable boost::mutex m_otherNamesLock;
+    NameSet m_otherNames; /* identifiers follow well-known names */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_TAG_TABLE_HPP */
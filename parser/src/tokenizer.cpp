@@ -0,0 +1,346 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tokenizer.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+namespace pgn
+{
+
+namespace
+{
+
+typedef enum
+{
+    ccSpace         = 0x01,
+    ccDigit         = 0x02,
+    ccSymbolStart   = 0x04, /* letter or digit */
+    ccSymbol        = 0x08, /* letter, digit or one of _+#=:-/ */
+    ccAnnotation    = 0x10  /* ! or ? */
+} char_class_t;
+
+class CharClassTable
+{
+public:
+    CharClassTable()
+    {
+        std::memset(m_table, 0, sizeof(m_table));
+        char const spaces[] = " \t\r\n\v\f";
+        for ( char const* c = spaces; *c != '\0'; ++c )
+        {
+            set(*c, ccSpace);
+        }
+        for ( int c = '0'; c <= '9'; ++c )
+        {
+            set(c, ccDigit | ccSymbolStart | ccSymbol);
+        }
+        for ( int c = 'a'; c <= 'z'; ++c )
+        {
+            set(c, ccSymbolStart | ccSymbol);
+            set(c - 'a' + 'A', ccSymbolStart | ccSymbol);
+        }
+        char const symbols[] = "_+#=:-/";
+        for ( char const* c = symbols; *c != '\0'; ++c )
+        {
+            set(*c, ccSymbol);
+        }
+        set('!', ccAnnotation);
+        set('?', ccAnnotation);
+    }
+
+    bool is(char c, unsigned charClass) const
+    {
+        return ( m_table[static_cast<unsigned char>(c)] & charClass ) != 0;
+    }
+
+private:
+    void set(int c, unsigned charClass)
+    {
+        m_table[static_cast<unsigned char>(c)] |=
+            static_cast<unsigned char>(charClass);
+    }
+
+    unsigned char m_table[256];
+};
+
+/* It is initialized before main(), thus there is no race between threads. */
+const CharClassTable CHAR_CLASSES;
+
+} /* unnamed namespace */
+
+void Tokenizer::next(Token& token)
+{
+    char const* const end = m_data + m_size;
+    char const* c = m_data + m_offset;
+    for ( ;; )
+    {
+        while ( c != end && CHAR_CLASSES.is(*c, ccSpace) )
+        {
+            ++c;
+        }
+
+        if ( c == end )
+        {
+            token.type = ttEnd;
+            token.offset = m_size;
+            token.length = 0;
+            m_offset = m_size;
+            return ;
+        }
+
+        if ( *c == '%' && ( c == m_data || c[-1] == '\n' ) )
+        {
+            /* Escaped line is ignored. */
+            c = static_cast<char const*>(std::memchr(c, '\n', end - c));
+            c = ( c == NULL ) ? end : c;
+        } else if ( *c == '.' )
+        {
+            /* Periods without move number are allowed in import format. */
+            ++c;
+        } else
+        {
+            break;
+        }
+    }
+
+    token.offset = c - m_data;
+    if ( CHAR_CLASSES.is(*c, ccSymbolStart) )
+    {
+        /* SAN and move numbers are the most frequent tokens. */
+        c = readSymbol(c, token);
+    } else switch ( *c )
+    {
+    case '[':
+        token.type = ttLeftBracket;
+        ++c;
+        break;
+    case ']':
+        token.type = ttRightBracket;
+        ++c;
+        break;
+    case '(':
+        token.type = ttRavBegin;
+        ++c;
+        break;
+    case ')':
+        token.type = ttRavEnd;
+        ++c;
+        break;
+    case '*':
+        token.type = ttTermination;
+        ++c;
+        break;
+    case '"':
+        c = readString(c, token);
+        break;
+    case '{':
+        c = readComment(c, '}', token);
+        break;
+    case ';':
+        c = readComment(c, '\n', token);
+        break;
+    case '$':
+        token.type = ttNAG;
+        ++c;
+        while ( c != end && CHAR_CLASSES.is(*c, ccDigit) )
+        {
+            ++c;
+        }
+        if ( c - m_data == static_cast<std::ptrdiff_t>(token.offset) + 1 )
+        {
+            token.type = ttIllegal;
+        }
+        break;
+    default:
+        if ( CHAR_CLASSES.is(*c, ccAnnotation) )
+        {
+            token.type = ttNAG;
+            ++c;
+            if ( c != end && CHAR_CLASSES.is(*c, ccAnnotation) )
+            {
+                ++c;
+            }
+        } else
+        {
+            token.type = ttIllegal;
+            ++c;
+        }
+        break;
+    }
+
+    /* Length of comments and strings is set by their readers. */
+    m_offset = c - m_data;
+    if ( token.type != ttComment && token.type != ttString )
+    {
+        token.length = m_offset - token.offset;
+    }
+}
+
+void Tokenizer::skipVariation(Token& token)
+{
+    char const* const end = m_data + m_size;
+    char const* c = m_data + m_offset;
+    unsigned depth = 1;
+    for ( ; c != end; ++c )
+    {
+        if ( *c == ')' && --depth == 0 )
+        {
+            break;
+        }
+
+        char const* commentEnd = c;
+        switch ( *c )
+        {
+        case '(':
+            ++depth;
+            break;
+        case '{':
+            commentEnd = static_cast<char const*>(
+                std::memchr(c, '}', end - c));
+            break;
+        case ';':
+            commentEnd = static_cast<char const*>(
+                std::memchr(c, '\n', end - c));
+            break;
+        case '%':
+            if ( c == m_data || c[-1] == '\n' )
+            {
+                commentEnd = static_cast<char const*>(
+                    std::memchr(c, '\n', end - c));
+            }
+            break;
+        default:
+            break;
+        }
+
+        if ( commentEnd == NULL )
+        {
+            c = end;
+            break;
+        }
+        c = commentEnd;
+    }
+
+    if ( c == end )
+    {
+        token.type = ttEnd;
+        token.offset = m_size;
+        token.length = 0;
+        m_offset = m_size;
+        return ;
+    }
+
+    token.type = ttRavEnd;
+    token.offset = c - m_data;
+    token.length = 1;
+    m_offset = token.offset + 1;
+}
+
+char const* Tokenizer::readSymbol(char const* c, Token& token) const
+{
+    char const* const end = m_data + m_size;
+    char const* const begin = c;
+    while ( c != end && CHAR_CLASSES.is(*c, ccDigit) )
+    {
+        ++c;
+    }
+
+    if ( c != begin && ( c == end || !CHAR_CLASSES.is(*c, ccSymbol) ) )
+    {
+        /* Periods are a part of move number, thus "12..." can be
+         * distinguished from "12.". */
+        while ( c != end && *c == '.' )
+        {
+            ++c;
+        }
+        token.type = ttMoveNumber;
+        return c;
+    }
+
+    while ( c != end && CHAR_CLASSES.is(*c, ccSymbol) )
+    {
+        ++c;
+    }
+
+    std::size_t const length = c - begin;
+    if ( ( length == 3 && ( std::memcmp(begin, "1-0", 3) == 0 ||
+            std::memcmp(begin, "0-1", 3) == 0 ) ) ||
+        ( length == 7 && std::memcmp(begin, "1/2-1/2", 7) == 0 ) )
+    {
+        token.type = ttTermination;
+    } else
+    {
+        token.type = ttSymbol;
+    }
+
+    return c;
+}
+
+char const* Tokenizer::readString(char const* c, Token& token) const
+{
+    char const* const end = m_data + m_size;
+    char const* const begin = ++c;
+    while ( c < end && *c != '"' )
+    {
+        /* Escaped character (\" or \\) is skipped. */
+        c += ( *c == '\\' ) ? 2 : 1;
+    }
+
+    if ( c >= end )
+    {
+        token.type = ttIllegal;
+        token.length = m_size - token.offset;
+        return end;
+    }
+
+    token.type = ttString;
+    token.offset = begin - m_data;
+    token.length = c - begin;
+    return c + 1;
+}
+
+char const* Tokenizer::readComment(char const* c, char terminator,
+    Token& token) const
+{
+    char const* const end = m_data + m_size;
+    char const* const begin = ++c;
+    c = static_cast<char const*>(std::memchr(begin, terminator, end - begin));
+    if ( c == NULL && terminator == '}' )
+    {
+        token.type = ttIllegal;
+        token.length = m_size - token.offset;
+        return end;
+    }
+
+    c = ( c == NULL ) ? end : c;
+    token.type = ttComment;
+    token.offset = begin - m_data;
+    token.length = c - begin;
+    if ( terminator == '\n' && token.length != 0 && c[-1] == '\r' )
+    {
+        --token.length;
+    }
+
+    /* The end of line is left, it can be followed by an escaped line. */
+    return ( terminator == '}' ) ? c + 1 : c;
+}
+
+} /* namespace pgn */
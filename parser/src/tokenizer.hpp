@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PGN_TOKENIZER_HPP
+#define PGN_TOKENIZER_HPP
+
+#include <cstddef>
+
+namespace pgn
+{
+
+typedef enum
+{
+    ttLeftBracket,      /* [ */
+    ttRightBracket,     /* ] */
+    ttString,           /* "..." without quotes, escapes are not decoded */
+    ttSymbol,           /* tag name or SAN */
+    ttMoveNumber,       /* 12. or 12... (periods are included) */
+    ttNAG,              /* $12 or suffix annotation (!, ?, !!, ??, !?, ?!) */
+    ttComment,          /* {...} or ;... without delimiters */
+    ttRavBegin,         /* ( */
+    ttRavEnd,           /* ) */
+    ttTermination,      /* 1-0, 0-1, 1/2-1/2 or * */
+    ttIllegal,          /* unknown character, unterminated string or comment */
+    ttEnd               /* end of data */
+} token_t;
+
+/* A token is a view into the data (usually mapped PGN file), thus nothing
+ * is copied. */
+struct Token
+{
+    token_t type;
+    std::size_t offset; /* from the beginning of the data */
+    std::size_t length;
+};
+
+/* Hand-written tokenizer of a PGN game (both tag pair and movetext
+ * sections). It doesn't allocate memory and looks at each byte once, a
+ * table of character classes is used for dispatching. Escaped lines (%) are
+ * skipped. */
+class Tokenizer
+{
+public:
+    Tokenizer(char const* data, std::size_t size) : m_data(data),
+        m_size(size), m_offset(0) {}
+
+    /* Get the next token. At the end of data ttEnd is returned (again and
+     * again). */
+    void next(Token& token);
+
+    /* Skip the rest of a variation after its ttRavBegin token. Nested
+     * variations and comments are skipped, but other tokens aren't
+     * recognized. The token is ttRavEnd of the variation, or ttEnd if the
+     * variation isn't closed. */
+    void skipVariation(Token& token);
+
+    char const* getData() const { return m_data; }
+    std::size_t getSize() const { return m_size; }
+
+private:
+    /* Readers get the first character of a token and return the next
+     * character after it. */
+    char const* readSymbol(char const* c, Token& token) const;
+    char const* readString(char const* c, Token& token) const;
+    char const* readComment(char const* c, char terminator,
+        Token& token) const;
+
+    char const* const m_data;
+    std::size_t const m_size;
+    std::size_t m_offset; /* offset of the next byte */
+};
+
+} /* namespace pgn */
+
+#endif /* #ifndef PGN_TOKENIZER_HPP */
@@ -0,0 +1,316 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "board.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+/* Square by its name, e.g. "e4". */
+int toSquare(char const* name)
+{
+    return ( name[0] - 'a' ) + 8 * ( name[1] - '1' );
+}
+
+pgn::packed_move_t makeMove(char const* from, char const* to,
+    pgn::piece_t promotion = pgn::pcNone)
+{
+    pgn::packed_move_t move = static_cast<pgn::packed_move_t>(
+        toSquare(from) | ( toSquare(to) << 6 ));
+    if ( promotion != pgn::pcNone )
+    {
+        move |= static_cast<pgn::packed_move_t>(0x4000 |
+            ( ( promotion - pgn::pcKnight ) << 12 ));
+    }
+
+    return move;
+}
+
+pgn::Board makeBoard(char const* fen)
+{
+    pgn::Board board;
+    BOOST_REQUIRE(board.setFEN(fen));
+    return board;
+}
+
+/* The move written in SAN or NULL_MOVE if it isn't found. */
+pgn::packed_move_t findMove(pgn::Board const& board, char const* san)
+{
+    pgn::packed_move_t move = pgn::NULL_MOVE;
+    return board.findMove(san, std::strlen(san), move) ? move :
+        pgn::NULL_MOVE;
+}
+
+pgn::packed_move_t findMove(char const* fen, char const* san)
+{
+    return findMove(makeBoard(fen), san);
+}
+
+std::string writeSAN(pgn::Board const& board, pgn::packed_move_t move)
+{
+    char san[pgn::Board::MAX_SAN_LENGTH + 1];
+    std::size_t const length = board.writeSAN(move, san);
+    BOOST_CHECK_EQUAL(length, std::strlen(san));
+    return san;
+}
+
+std::string writeSAN(char const* fen, pgn::packed_move_t move)
+{
+    return writeSAN(makeBoard(fen), move);
+}
+
+} /* unnamed namespace */
+
+BOOST_AUTO_TEST_SUITE(board)
+
+BOOST_AUTO_TEST_CASE(fen_is_validated)
+{
+    pgn::Board board;
+    BOOST_CHECK(board.setFEN(
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"));
+    BOOST_CHECK_EQUAL(board.getSideToMove(), 1u);
+    BOOST_CHECK(board.setFEN("4k3/8/8/8/8/8/8/4K3 w"));
+    BOOST_CHECK_EQUAL(board.getSideToMove(), 0u);
+
+    BOOST_CHECK(!board.setFEN("4k3/8/8/8/8/8/8/4K3"));
+    BOOST_CHECK(!board.setFEN("4k3/8/8/8/8/8/8/8 w - -"));
+    BOOST_CHECK(!board.setFEN("4k3/8/8/8/8/8/8/4KK2 w - -"));
+    BOOST_CHECK(!board.setFEN("4k3/9/8/8/8/8/8/4K3 w - -"));
+    BOOST_CHECK(!board.setFEN("4k3/8/8/8/8/8/4K3 w - -"));
+    BOOST_CHECK(!board.setFEN("4k3/8/8/8/8/8/8/4K2X w - -"));
+    BOOST_CHECK(!board.setFEN("4k3/8/8/8/8/8/8/R3K3 w A -"));
+}
+
+BOOST_AUTO_TEST_CASE(disambiguation_by_file)
+{
+    char const* const fen = "4k3/8/8/8/8/8/8/R4RK1 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(fen, "Rd1"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "Rad1"), makeMove("a1", "d1"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Rfd1"), makeMove("f1", "d1"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Rbd1"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "d1")), "Rad1");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("f1", "d1")), "Rfd1");
+
+    /* Only one rook reaches the square. */
+    BOOST_CHECK_EQUAL(findMove(fen, "Ra4"), makeMove("a1", "a4"));
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "a4")), "Ra4");
+}
+
+BOOST_AUTO_TEST_CASE(disambiguation_by_rank)
+{
+    char const* const fen = "4k3/8/8/R7/8/8/8/R3K3 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(fen, "Ra3"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "Raa3"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "R1a3"), makeMove("a1", "a3"));
+    BOOST_CHECK_EQUAL(findMove(fen, "R5a3"), makeMove("a5", "a3"));
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "a3")), "R1a3");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a5", "a3")), "R5a3");
+}
+
+BOOST_AUTO_TEST_CASE(disambiguation_by_file_and_rank)
+{
+    /* Queens on a1, a3 and c1 attack b2. */
+    char const* const fen = "7K/8/8/7k/8/Q7/8/Q1Q5 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(fen, "Qb2"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "Qab2"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "Q1b2"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "Qa1b2"), makeMove("a1", "b2"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Qa1xb2"), makeMove("a1", "b2"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Qcb2"), makeMove("c1", "b2"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Q3b2"), makeMove("a3", "b2"));
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "b2")), "Qa1b2");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("c1", "b2")), "Qcb2");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a3", "b2")), "Q3b2");
+}
+
+BOOST_AUTO_TEST_CASE(pinned_pieces)
+{
+    /* The knight on c1 is pinned by the rook, thus Nd3 isn't ambiguous. */
+    char const* const knights = "4k3/8/8/4N3/8/8/8/K1N4r w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(knights, "Nd3"), makeMove("e5", "d3"));
+    BOOST_CHECK_EQUAL(findMove(knights, "Ncd3"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(writeSAN(knights, makeMove("e5", "d3")), "Nd3");
+
+    /* A pinned bishop moves along the pin only. */
+    char const* const bishop = "4k3/8/8/8/8/2b5/3B4/4K3 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(bishop, "Bxc3"), makeMove("d2", "c3"));
+    BOOST_CHECK_EQUAL(findMove(bishop, "Be3"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(bishop, "Kf2"), makeMove("e1", "f2"));
+
+    /* The king in check. */
+    char const* const check = "4k3/8/8/8/8/8/4r3/R3K3 w Q - 0 1";
+    BOOST_CHECK_EQUAL(findMove(check, "Kxe2"), makeMove("e1", "e2"));
+    BOOST_CHECK_EQUAL(findMove(check, "Ra2"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(check, "O-O-O"), pgn::NULL_MOVE);
+}
+
+BOOST_AUTO_TEST_CASE(castling)
+{
+    char const* const fen = "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1";
+    BOOST_CHECK_EQUAL(findMove(fen, "O-O"), makeMove("e1", "g1"));
+    BOOST_CHECK_EQUAL(findMove(fen, "0-0"), makeMove("e1", "g1"));
+    BOOST_CHECK_EQUAL(findMove(fen, "O-O-O"), makeMove("e1", "c1"));
+    BOOST_CHECK_EQUAL(findMove(fen, "0-0-0"), makeMove("e1", "c1"));
+    BOOST_CHECK_EQUAL(findMove(fen, "O-0"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "O-O-O-O"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "OO"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("e1", "g1")), "O-O");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("e1", "c1")), "O-O-O");
+
+    char const* const black = "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1";
+    BOOST_CHECK_EQUAL(findMove(black, "O-O"), makeMove("e8", "g8"));
+    BOOST_CHECK_EQUAL(findMove(black, "0-0-0"), makeMove("e8", "c8"));
+
+    /* No castling right, a blocked path, an attacked square. */
+    BOOST_CHECK_EQUAL(findMove("r3k2r/8/8/8/8/8/8/R3K2R w Qkq - 0 1",
+        "O-O"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove("r3k2r/8/8/8/8/8/8/RN2K2R w KQkq - 0 1",
+        "O-O-O"), pgn::NULL_MOVE);
+    char const* const attacked = "4kr2/8/8/8/8/8/8/R3K2R w KQ - 0 1";
+    BOOST_CHECK_EQUAL(findMove(attacked, "O-O"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(attacked, "O-O-O"), makeMove("e1", "c1"));
+
+    /* The rook gives check. */
+    char const* const check = "5k2/8/8/8/8/8/8/4K2R w K - 0 1";
+    BOOST_CHECK_EQUAL(findMove(check, "O-O+"), makeMove("e1", "g1"));
+    BOOST_CHECK_EQUAL(writeSAN(check, makeMove("e1", "g1")), "O-O+");
+}
+
+BOOST_AUTO_TEST_CASE(en_passant)
+{
+    char const* const fen = "4k3/8/8/3pP3/8/8/8/3RK3 w - d6 0 1";
+    pgn::Board board = makeBoard(fen);
+    pgn::packed_move_t const capture = findMove(board, "exd6");
+    BOOST_CHECK_EQUAL(capture, makeMove("e5", "d6"));
+    BOOST_CHECK_EQUAL(writeSAN(board, capture), "exd6");
+
+    /* The captured pawn is removed, thus the rook passes d5. */
+    board.makeMove(capture);
+    board.makeMove(findMove(board, "Kf8"));
+    BOOST_CHECK_EQUAL(findMove(board, "Rd5"), makeMove("d1", "d5"));
+    BOOST_CHECK_EQUAL(writeSAN(board, makeMove("d1", "d5")), "Rd5");
+
+    /* The en passant square is required. */
+    BOOST_CHECK_EQUAL(findMove("4k3/8/8/3pP3/8/8/8/4K3 w - - 0 1", "exd6"),
+        pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove("4k3/8/8/8/3Pp3/8/8/4K3 b - d3 0 1", "exd3"),
+        makeMove("e4", "d3"));
+
+    /* Both pawns leave the rank and open the king. */
+    char const* const pinned = "8/8/8/K2pP2r/8/8/8/4k3 w - d6 0 1";
+    BOOST_CHECK_EQUAL(findMove(pinned, "exd6"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(pinned, "e6"), makeMove("e5", "e6"));
+}
+
+BOOST_AUTO_TEST_CASE(promotion)
+{
+    char const* const fen = "7k/P7/8/8/8/8/8/K7 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(fen, "a8=Q"),
+        makeMove("a7", "a8", pgn::pcQueen));
+    BOOST_CHECK_EQUAL(findMove(fen, "a8Q"),
+        makeMove("a7", "a8", pgn::pcQueen));
+    BOOST_CHECK_EQUAL(findMove(fen, "a8=N"),
+        makeMove("a7", "a8", pgn::pcKnight));
+    BOOST_CHECK_EQUAL(findMove(fen, "a8R"),
+        makeMove("a7", "a8", pgn::pcRook));
+    BOOST_CHECK_EQUAL(findMove(fen, "a8"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(findMove(fen, "a8=K"), pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a7", "a8", pgn::pcQueen)),
+        "a8=Q+");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a7", "a8", pgn::pcBishop)),
+        "a8=B");
+
+    char const* const capture = "1r5k/P7/8/8/8/8/8/K7 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(capture, "axb8=Q"),
+        makeMove("a7", "b8", pgn::pcQueen));
+    BOOST_CHECK_EQUAL(findMove(capture, "axb8N"),
+        makeMove("a7", "b8", pgn::pcKnight));
+    BOOST_CHECK_EQUAL(writeSAN(capture, makeMove("a7", "b8", pgn::pcQueen)),
+        "axb8=Q+");
+
+    char const* const black = "k7/8/8/8/8/8/p7/7K b - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(black, "a1=Q+"),
+        makeMove("a2", "a1", pgn::pcQueen));
+    BOOST_CHECK_EQUAL(writeSAN(black, makeMove("a2", "a1", pgn::pcQueen)),
+        "a1=Q+");
+
+    /* Promotion is allowed on the last rank only. */
+    BOOST_CHECK_EQUAL(findMove(pgn::Board(), "e4=Q"), pgn::NULL_MOVE);
+}
+
+BOOST_AUTO_TEST_CASE(check_and_mate)
+{
+    char const* const fen = "7k/8/6K1/8/8/8/8/Q7 w - - 0 1";
+    BOOST_CHECK_EQUAL(findMove(fen, "Qa8"), makeMove("a1", "a8"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Qa8+"), makeMove("a1", "a8"));
+    BOOST_CHECK_EQUAL(findMove(fen, "Qa8#"), makeMove("a1", "a8"));
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "a8")), "Qa8#");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "h1")), "Qh1+");
+    BOOST_CHECK_EQUAL(writeSAN(fen, makeMove("a1", "b1")), "Qb1");
+
+    /* Stalemate is neither check nor mate. */
+    BOOST_CHECK_EQUAL(writeSAN("7k/8/6K1/8/8/8/8/5Q2 w - - 0 1",
+        makeMove("f1", "f7")), "Qf7");
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+    /* Every SAN of the games is resolved and written back unchanged. */
+    static char const* const games[] =
+    {
+        "e4 e5 Nf3 Nc6 Bb5 a6 Ba4 Nf6 O-O Be7 Re1 b5 Bb3 d6 c3 O-O h3 Nb8 "
+            "d4 Nbd7 c4 c6 cxb5 axb5 Nc3 Bb7 Bg5 b4 Nb1 h6 Bh4 c5 dxe5 "
+            "Nxe4 Bxe7 Qxe7 exd6 Qf6 Nbd2 Nxd6 Nc4 Nxc4 Bxc4 Nb6 Ne5 Rae8 "
+            "Bxf7+ Rxf7 Nxf7 Rxe1+ Qxe1 Kxf7 Qe3 Qg5 Qxg5 hxg5 b3 Ke6 a3 "
+            "Kd6 axb4 cxb4 Ra5 Nd5 f3 Bc8 Kf2 Bf5 Ra7 g6 Ra6+ Kc5 Ke1 Nf4 "
+            "g3 Nxh3 Kd2 Kb5 Rd6 Kc5 Ra6 Nf2 g4 Bd3 Re6",
+        "e4 e5 Bc4 Nc6 Qh5 Nf6 Qxf7#",
+        "e4 d5 exd5 c6 dxc6 Qb6 cxb7 Kd8 bxa8=Q Qxb2 Bxb2",
+        "e4 Nf6 e5 d5 exd6 exd6 d4 Be7 Nf3 O-O Bd3 Re8 O-O",
+        "f3 e5 g4 Qh4#"
+    };
+
+    for ( std::size_t i = 0; i < sizeof(games) / sizeof(games[0]); ++i )
+    {
+        pgn::Board board;
+        std::string const line = games[i];
+        std::size_t first = 0;
+        while ( first < line.size() )
+        {
+            std::size_t last = line.find(' ', first);
+            if ( last == std::string::npos )
+            {
+                last = line.size();
+            }
+            std::string const san = line.substr(first, last - first);
+            pgn::packed_move_t const move = findMove(board, san.c_str());
+            BOOST_REQUIRE_MESSAGE(move != pgn::NULL_MOVE, san);
+            BOOST_CHECK_EQUAL(writeSAN(board, move), san);
+            board.makeMove(move);
+            first = last + 1;
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
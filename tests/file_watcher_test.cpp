@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_watcher.hpp"
+
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/ref.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace
+{
+
+/* Files are created in the working directory of the test. */
+char const DIRECTORY[] = "file_watcher_test.dir";
+char const PGN_PATH[] = "file_watcher_test.dir/test.pgn";
+char const OTHER_PATHS[][32] =
+{
+    "file_watcher_test.dir/a.pgn",
+    "file_watcher_test.dir/b.pgn"
+};
+
+/* The watcher reports a modification after 50 ms without events. */
+unsigned const TIMEOUT = 2000; /* ms */
+unsigned const QUIET_TIME = 300; /* ms */
+
+void appendFile(char const* path, char const* text)
+{
+    std::FILE* const file = std::fopen(path, "ab");
+    BOOST_REQUIRE(file != NULL);
+    std::fputs(text, file);
+    std::fclose(file);
+}
+
+void waitQuietly(unsigned ms)
+{
+    boost::this_thread::sleep(boost::posix_time::milliseconds(ms));
+}
+
+/* The callback counts notifications. It can be blocked, thus the thread of
+ * the watcher doesn't read events. */
+class Counter
+{
+public:
+    Counter() : m_count(0), m_isBlocked(false) {}
+
+    void operator()()
+    {
+        boost::mutex::scoped_lock lock(m_lock);
+        ++m_count;
+        m_changed.notify_all();
+        while ( m_isBlocked )
+        {
+            m_changed.wait(lock);
+        }
+    }
+
+    /* The method returns false if there are less notifications after the
+     * timeout. */
+    bool waitFor(unsigned count)
+    {
+        boost::system_time const deadline = boost::get_system_time() +
+            boost::posix_time::milliseconds(TIMEOUT);
+        boost::mutex::scoped_lock lock(m_lock);
+        while ( m_count < count )
+        {
+            if ( !m_changed.timed_wait(lock, deadline) )
+            {
+                return m_count >= count;
+            }
+        }
+        return true;
+    }
+
+    unsigned getCount()
+    {
+        boost::mutex::scoped_lock lock(m_lock);
+        return m_count;
+    }
+
+    void setBlocked(bool isBlocked)
+    {
+        boost::mutex::scoped_lock lock(m_lock);
+        m_isBlocked = isBlocked;
+        m_changed.notify_all();
+    }
+
+private:
+    boost::mutex m_lock;
+    boost::condition_variable m_changed;
+    unsigned m_count;
+    bool m_isBlocked;
+};
+
+class Fixture
+{
+public:
+    Fixture()
+    {
+        mkdir(DIRECTORY, 0755);
+        appendFile(PGN_PATH, "[Event \"?\"]\n\n1. e4 *\n\n");
+    }
+
+    ~Fixture()
+    {
+        m_watcher.stop();
+        std::remove(PGN_PATH);
+        std::remove(OTHER_PATHS[0]);
+        std::remove(OTHER_PATHS[1]);
+        rmdir(DIRECTORY);
+    }
+
+    bool start()
+    {
+        return m_watcher.start(pgn::FilePath(PGN_PATH),
+            boost::ref(m_counter));
+    }
+
+    pgn::FileWatcher m_watcher;
+    Counter m_counter;
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(file_watcher, Fixture)
+
+BOOST_AUTO_TEST_CASE(directory_is_required)
+{
+    BOOST_CHECK(!m_watcher.start(
+        pgn::FilePath("file_watcher_test.none/test.pgn"),
+        boost::ref(m_counter)));
+}
+
+/* Bursts of modifications are reported once. */
+BOOST_AUTO_TEST_CASE(modifications_are_reported)
+{
+    BOOST_REQUIRE(start());
+    appendFile(PGN_PATH, "[Event \"?\"]\n\n1. d4 *\n\n");
+    BOOST_CHECK(m_counter.waitFor(1));
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        appendFile(PGN_PATH, "\n");
+    }
+    BOOST_CHECK(m_counter.waitFor(2));
+    waitQuietly(QUIET_TIME);
+    BOOST_CHECK_EQUAL(m_counter.getCount(), 2u);
+
+    m_watcher.stop();
+    appendFile(PGN_PATH, "\n");
+    waitQuietly(QUIET_TIME);
+    BOOST_CHECK_EQUAL(m_counter.getCount(), 2u);
+}
+
+/* The file can be replaced by another file of the directory. */
+BOOST_AUTO_TEST_CASE(other_files_are_ignored)
+{
+    BOOST_REQUIRE(start());
+    appendFile(OTHER_PATHS[0], "[Event \"?\"]\n\n1. c4 *\n\n");
+    waitQuietly(QUIET_TIME);
+    BOOST_CHECK_EQUAL(m_counter.getCount(), 0u);
+
+    BOOST_REQUIRE(std::rename(OTHER_PATHS[0], PGN_PATH) == 0);
+    BOOST_CHECK(m_counter.waitFor(1));
+}
+
+/* Events of the file can be lost on overflow of the queue, thus the
+ * overflow is reported as a modification. The queue is filled by events of
+ * other files while the callback is blocked. */
+BOOST_AUTO_TEST_CASE(queue_overflow_is_reported)
+{
+    unsigned maxEvents = 16384;
+    std::FILE* const limit = std::fopen(
+        "/proc/sys/fs/inotify/max_queued_events", "r");
+    if ( limit != NULL )
+    {
+        BOOST_REQUIRE(std::fscanf(limit, "%u", &maxEvents) == 1);
+        std::fclose(limit);
+    }
+
+    BOOST_REQUIRE(start());
+    m_counter.setBlocked(true);
+    appendFile(PGN_PATH, "\n");
+    BOOST_REQUIRE(m_counter.waitFor(1));
+
+    /* Each append gives IN_MODIFY and IN_CLOSE_WRITE. Files are
+     * alternated, otherwise equal events are merged. */
+    for ( unsigned i = 0; i < maxEvents / 2 + 16; ++i )
+    {
+        appendFile(OTHER_PATHS[0], "\n");
+        appendFile(OTHER_PATHS[1], "\n");
+    }
+    m_counter.setBlocked(false);
+    BOOST_CHECK(m_counter.waitFor(2));
+}
+
+/* The file is gone with the directory, it is the last notification. */
+BOOST_AUTO_TEST_CASE(directory_is_removed)
+{
+    BOOST_REQUIRE(start());
+    BOOST_REQUIRE(std::remove(PGN_PATH) == 0);
+    BOOST_CHECK(m_counter.waitFor(1));
+
+    BOOST_REQUIRE(rmdir(DIRECTORY) == 0);
+    BOOST_CHECK(m_counter.waitFor(2));
+
+    mkdir(DIRECTORY, 0755);
+    appendFile(PGN_PATH, "[Event \"?\"]\n\n1. e4 *\n\n");
+    waitQuietly(QUIET_TIME);
+    BOOST_CHECK_EQUAL(m_counter.getCount(), 2u);
+    m_watcher.stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
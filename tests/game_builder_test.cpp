@@ -0,0 +1,459 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/move.hpp>
+#include "game_builder.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+/* Build a game from PGN text, the text should outlive the game. */
+boost::intrusive_ptr<pgn::GameImpl> build(std::string const& pgn)
+{
+    boost::intrusive_ptr<pgn::GameImpl> const game(new pgn::GameImpl(1));
+    pgn::GameBuilder builder(false, pgn::GameBuilder::ErrorReporter());
+    std::size_t moveTextOffset = 0;
+    BOOST_REQUIRE(builder.buildTagPairs(pgn.data(), pgn.size(), *game,
+        moveTextOffset));
+    builder.buildMoveText(pgn.data() + moveTextOffset,
+        pgn.size() - moveTextOffset, *game);
+    return game;
+}
+
+/* Moves of the variation with their numbers, e.g. "1.e4 1.e5 2.Nf3". */
+std::string getLine(pgn::IGame const& game, pgn::variation_t v)
+{
+    std::string line;
+    for ( unsigned n = 1; n <= game.getMoveCount(v); ++n )
+    {
+        pgn::IMove const* const move = game.getMove(n, v);
+        std::ostringstream text;
+        text << ( n != 1 ? " " : "" ) << move->getMoveNumber() << '.' <<
+            move->getSAN();
+        line += text.str();
+    }
+
+    return line;
+}
+
+char const* const RESULT_NAMES[] = { "1-0", "0-1", "1/2-1/2", "*" };
+
+/* Elements of a game as text, e.g. "[Event=?] e4/1 $1 {text} ( d4/1 ) *".
+ * A syntax error is written as "error:<code>". */
+class Recorder : public pgn::IGameVisitor
+{
+public:
+    std::string const& getEvents() const { return m_events; }
+
+private:
+    void add(std::string const& event)
+    {
+        m_events += ( m_events.empty() ? "" : " " ) + event;
+    }
+
+    void onTagPair(char const* name, std::size_t nameLength,
+        char const* value, std::size_t valueLength)
+    {
+        add('[' + std::string(name, nameLength) + '=' +
+            std::string(value, valueLength) + ']');
+    }
+    void onMove(char const* san, std::size_t length, unsigned moveNumber)
+    {
+        std::ostringstream text;
+        text << std::string(san, length) << '/' << moveNumber;
+        add(text.str());
+    }
+    void onNAG(pgn::NAG_t nag)
+    {
+        std::ostringstream text;
+        text << '$' << nag;
+        add(text.str());
+    }
+    void onComment(char const* comment, std::size_t length)
+    {
+        add('{' + std::string(comment, length) + '}');
+    }
+    void onVariationBegin() { add("("); }
+    void onVariationEnd() { add(")"); }
+    void onResult(pgn::game_result_t result) { add(RESULT_NAMES[result]); }
+    void onSyntaxError(pgn::syntax_error_t code)
+    {
+        std::ostringstream text;
+        text << "error:" << code;
+        add(text.str());
+    }
+
+    std::string m_events;
+};
+
+/* Reported errors as "<code>@<offset>", critical ones are marked with '!',
+ * e.g. "!1@12 5@30". */
+class ErrorLog
+{
+public:
+    explicit ErrorLog(bool isAccepted) : m_isAccepted(isAccepted) {}
+
+    bool report(bool isCritical, pgn::syntax_error_t code,
+        wchar_t const* description, std::size_t offset)
+    {
+        BOOST_CHECK(description != NULL && *description != L'\0');
+        std::ostringstream text;
+        text << ( m_errors.empty() ? "" : " " ) << ( isCritical ? "!" : "" ) <<
+            code << '@' << offset;
+        m_errors += text.str();
+        return m_isAccepted;
+    }
+
+    std::string const& getErrors() const { return m_errors; }
+
+private:
+    bool const m_isAccepted;
+    std::string m_errors;
+};
+
+/* Parse a game (both sections) with GameParser. */
+std::string parse(std::string const& pgn, bool isStrict, ErrorLog& log)
+{
+    pgn::GameParser parser(isStrict, boost::bind(&ErrorLog::report, &log,
+        _1, _2, _3, _4));
+    Recorder recorder;
+    parser.parse(pgn.data(), pgn.size(), recorder);
+    return recorder.getEvents();
+}
+
+std::string parse(std::string const& pgn)
+{
+    ErrorLog log(true);
+    std::string const events = parse(pgn, true, log);
+    BOOST_CHECK_EQUAL(log.getErrors(), "");
+    return events;
+}
+
+} /* unnamed namespace */
+
+BOOST_AUTO_TEST_SUITE(game_builder)
+
+/* nagNull is the end of the list of NAGs, thus unknown NAGs aren't kept. */
+BOOST_AUTO_TEST_CASE(unknown_nags_are_dropped)
+{
+    std::string const pgn = "[Event \"?\"]\n\n"
+        "1. e4 $300 $1 $0 !! $256 e5 $0 *\n";
+    boost::intrusive_ptr<pgn::GameImpl> const game = build(pgn);
+    pgn::IMove const* const e4 = game->getMove(1, pgn::MAIN_LINE);
+    BOOST_REQUIRE(e4 != NULL);
+    BOOST_CHECK_EQUAL(e4->getNAG(), pgn::nagGoodMove);
+    BOOST_CHECK_EQUAL(e4->getNAG(), pgn::nagVeryGoodMove);
+    BOOST_CHECK_EQUAL(e4->getNAG(), pgn::nagNull);
+
+    pgn::NAG_t nags[4];
+    BOOST_CHECK_EQUAL(e4->getNAGs(nags, 4), 2u);
+    BOOST_CHECK_EQUAL(nags[0], pgn::nagGoodMove);
+    BOOST_CHECK_EQUAL(nags[1], pgn::nagVeryGoodMove);
+
+    pgn::IMove const* const e5 = game->getMove(2, pgn::MAIN_LINE);
+    BOOST_REQUIRE(e5 != NULL);
+    BOOST_CHECK_EQUAL(e5->getNAG(), pgn::nagNull);
+    BOOST_CHECK_EQUAL(e5->getNAGs(NULL, 0), 0u);
+}
+
+/* Moves are stored packed, SAN is rendered when moves are requested. */
+BOOST_AUTO_TEST_CASE(packed_moves_are_exposed)
+{
+    std::string const first = "[Event \"?\"]\n\n"
+        "1. e4 e5 2. Nf3 (2. f4 exf4) Nc6 3. Bb5 a6 *\n";
+    std::string const second = "[Event \"?\"]\n\n"
+        "1. e4 {x} e5 $1 2. Nf3 Nc6 (2... d6) 3. Bb5 a6 *\n";
+    boost::intrusive_ptr<pgn::GameImpl> const firstGame = build(first);
+    boost::intrusive_ptr<pgn::GameImpl> const secondGame = build(second);
+
+    unsigned firstCount = 0;
+    unsigned secondCount = 0;
+    pgn::packed_move_t const* const firstMoves =
+        firstGame->getPackedMoves(pgn::MAIN_LINE, firstCount);
+    pgn::packed_move_t const* const secondMoves =
+        secondGame->getPackedMoves(pgn::MAIN_LINE, secondCount);
+    BOOST_REQUIRE_EQUAL(firstCount, 6u);
+    BOOST_REQUIRE_EQUAL(secondCount, 6u);
+    BOOST_CHECK(std::memcmp(firstMoves, secondMoves,
+        firstCount * sizeof(pgn::packed_move_t)) == 0);
+
+    /* e2-e4: squares are numbered from a1 (0) rank by rank. */
+    BOOST_CHECK_EQUAL(firstMoves[0], 12 | ( 28 << 6 ));
+
+    unsigned variationCount = 0;
+    pgn::packed_move_t const* const variation =
+        firstGame->getPackedMoves(1, variationCount);
+    BOOST_REQUIRE_EQUAL(variationCount, 2u);
+    BOOST_CHECK_EQUAL(variation[0], 13 | ( 29 << 6 ));
+    BOOST_CHECK(firstGame->getPackedMoves(2, variationCount) == NULL);
+    BOOST_CHECK_EQUAL(variationCount, 0u);
+
+    BOOST_CHECK_EQUAL(getLine(*firstGame, pgn::MAIN_LINE),
+        "1.e4 1.e5 2.Nf3 2.Nc6 3.Bb5 3.a6");
+    BOOST_CHECK_EQUAL(getLine(*firstGame, 1), "2.f4 2.exf4");
+
+    /* The same object is returned for the move. */
+    BOOST_CHECK(firstGame->getMove(3, pgn::MAIN_LINE) ==
+        firstGame->getMove(3, pgn::MAIN_LINE));
+}
+
+/* Comments, NAGs and child variations of a move can be separated by other
+ * moves in the movetext. */
+BOOST_AUTO_TEST_CASE(extras_follow_their_moves)
+{
+    std::string const pgn = "[Event \"?\"]\n\n"
+        "{before} 1. e4 {a} (1. d4 $2 {b} (1. c4 $3) $4 d5 {c}) $1 {d} "
+        "(1. Nf3 $5) e5 $6 *\n";
+    boost::intrusive_ptr<pgn::GameImpl> const game = build(pgn);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(), 4u);
+
+    pgn::IMove const* const e4 = game->getMove(1, pgn::MAIN_LINE);
+    BOOST_CHECK_EQUAL(e4->getComment(), "before a d");
+    BOOST_CHECK_EQUAL(e4->getNAG(1), pgn::nagGoodMove);
+    BOOST_CHECK_EQUAL(e4->getNAG(2), pgn::nagNull);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(e4), 2u);
+    pgn::variation_t const d4Line = game->getVariation(e4, 1);
+    pgn::variation_t const nf3Line = game->getVariation(e4, 2);
+    BOOST_CHECK_EQUAL(getLine(*game, d4Line), "1.d4 1.d5");
+    BOOST_CHECK_EQUAL(getLine(*game, nf3Line), "1.Nf3");
+
+    pgn::IMove const* const d4 = game->getMove(1, d4Line);
+    BOOST_CHECK_EQUAL(d4->getVariation(), d4Line);
+    BOOST_CHECK_EQUAL(d4->getComment(), "b");
+    BOOST_CHECK_EQUAL(d4->getNAG(1), pgn::nagPoorMove);
+    BOOST_CHECK_EQUAL(d4->getNAG(2), pgn::nagVeryPoorMove);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(d4), 1u);
+    pgn::variation_t const c4Line = game->getVariation(d4, 1);
+    BOOST_CHECK_EQUAL(getLine(*game, c4Line), "1.c4");
+    BOOST_CHECK_EQUAL(game->getMove(1, c4Line)->getNAG(1),
+        pgn::nagVeryGoodMove);
+    BOOST_CHECK_EQUAL(game->getMove(2, d4Line)->getComment(), "c");
+    BOOST_CHECK_EQUAL(game->getMove(1, nf3Line)->getNAG(1),
+        pgn::nagSpeculativeMove);
+
+    pgn::IMove const* const e5 = game->getMove(2, pgn::MAIN_LINE);
+    BOOST_CHECK(e5->getComment() == NULL);
+    BOOST_CHECK_EQUAL(e5->getNAG(1), pgn::nagQuestionableMove);
+    BOOST_CHECK_EQUAL(game->getVariationCount(e5), 0u);
+}
+
+/* Numbers are counted by plies from the first move of the main line, a
+ * variation starts at the ply of its parent. */
+BOOST_AUTO_TEST_CASE(moves_are_numbered_by_plies)
+{
+    std::string const blackToMove = "[Event \"?\"]\n[FEN \"rnbqkbnr/"
+        "pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1\"]\n\n"
+        "1... e5 2. Nf3 (2. Nc3 Nc6) Nc6 *\n";
+    boost::intrusive_ptr<pgn::GameImpl> game = build(blackToMove);
+    BOOST_CHECK_EQUAL(getLine(*game, pgn::MAIN_LINE), "1.e5 2.Nf3 2.Nc6");
+    BOOST_CHECK_EQUAL(getLine(*game, 1), "2.Nc3 2.Nc6");
+
+    /* The position is unknown, the second move tells that black made the
+     * first one. */
+    std::string const unknownPosition = "[Event \"?\"]\n"
+        "[FEN \"garbage\"]\n\n1... e5 2. Nf3 Nc6 *\n";
+    game = build(unknownPosition);
+    BOOST_CHECK_EQUAL(getLine(*game, pgn::MAIN_LINE), "1.e5 2.Nf3 2.Nc6");
+
+    std::string const whiteFirst = "[Event \"?\"]\n"
+        "[FEN \"garbage\"]\n\n12. e4 e5 13. Nf3 *\n";
+    game = build(whiteFirst);
+    BOOST_CHECK_EQUAL(getLine(*game, pgn::MAIN_LINE), "12.e4 12.e5 13.Nf3");
+
+    /* Wrong numbers of the movetext are ignored. */
+    std::string const wrongNumbers = "[Event \"?\"]\n\n"
+        "1. e4 e5 5. Nf3 Nc6 9... a6 (7. d6) *\n";
+    game = build(wrongNumbers);
+    BOOST_CHECK_EQUAL(getLine(*game, pgn::MAIN_LINE),
+        "1.e4 1.e5 2.Nf3 2.Nc6 3.a6");
+    BOOST_CHECK_EQUAL(getLine(*game, 1), "3.d6");
+}
+
+/* A move which isn't resolved and next moves of its variation keep their
+ * SAN, other variations are resolved. */
+BOOST_AUTO_TEST_CASE(unresolved_moves_keep_san)
+{
+    std::string const pgn = "[Event \"?\"]\n\n"
+        "1. e4 e5 2. Ke3 (2. Nf3 Nc6) Nc6 3. 0-0 *\n";
+    boost::intrusive_ptr<pgn::GameImpl> const game = build(pgn);
+    BOOST_CHECK_EQUAL(getLine(*game, pgn::MAIN_LINE),
+        "1.e4 1.e5 2.Ke3 2.Nc6 3.O-O");
+    BOOST_CHECK_EQUAL(getLine(*game, 1), "2.Nf3 2.Nc6");
+    BOOST_CHECK_EQUAL(pgn::IGame::isMoveValid(game->getMove(2,
+        pgn::MAIN_LINE)), pgn::seValid);
+    BOOST_CHECK_EQUAL(pgn::IGame::isMoveValid(game->getMove(3,
+        pgn::MAIN_LINE)), pgn::seIllegalMove);
+    BOOST_CHECK_EQUAL(pgn::IGame::isMoveValid(game->getMove(4,
+        pgn::MAIN_LINE)), pgn::seValid);
+
+    unsigned count = 0;
+    pgn::packed_move_t const* const moves =
+        game->getPackedMoves(pgn::MAIN_LINE, count);
+    BOOST_REQUIRE_EQUAL(count, 5u);
+    BOOST_CHECK(moves[1] != pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(moves[2], pgn::NULL_MOVE);
+    BOOST_CHECK_EQUAL(moves[3], pgn::NULL_MOVE);
+}
+
+BOOST_AUTO_TEST_CASE(variations_are_nested)
+{
+    std::string const pgn = "[Event \"?\"]\n\n1. e4 (1. d4 d5 (1... Nf6 "
+        "2. c4) 2. c4 ()) (1. c4) e5 {x} $1 (1... c5) *\n";
+    BOOST_CHECK_EQUAL(parse(pgn), "[Event=?] e4/1 ( d4/1 d5/1 ( Nf6/1 c4/2 ) "
+        "c4/2 ( ) ) ( c4/1 ) e5/1 {x} $1 ( c5/1 ) *");
+
+    boost::intrusive_ptr<pgn::GameImpl> const game = build(pgn);
+    BOOST_CHECK_EQUAL(game->getVariationCount(), 6u);
+    pgn::IMove const* const e4 = game->getMove(1, pgn::MAIN_LINE);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(e4), 2u);
+    pgn::variation_t const d4Line = game->getVariation(e4, 1);
+    BOOST_CHECK_EQUAL(getLine(*game, d4Line), "1.d4 1.d5 2.c4");
+    BOOST_CHECK_EQUAL(getLine(*game, game->getVariation(e4, 2)), "1.c4");
+    pgn::IMove const* const d5 = game->getMove(2, d4Line);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(d5), 1u);
+    BOOST_CHECK_EQUAL(getLine(*game, game->getVariation(d5, 1)),
+        "1.Nf6 2.c4");
+    pgn::IMove const* const c4 = game->getMove(3, d4Line);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(c4), 1u);
+    BOOST_CHECK_EQUAL(game->getMoveCount(game->getVariation(c4, 1)), 0u);
+    pgn::IMove const* const e5 = game->getMove(2, pgn::MAIN_LINE);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(e5), 1u);
+    BOOST_CHECK_EQUAL(getLine(*game, game->getVariation(e5, 1)), "1.c5");
+}
+
+BOOST_AUTO_TEST_CASE(termination_markers)
+{
+    std::string const moves = "[Event \"?\"]\n\n1. e4 e5 ";
+    BOOST_CHECK_EQUAL(parse(moves + "1-0"), "[Event=?] e4/1 e5/1 1-0");
+    BOOST_CHECK_EQUAL(parse(moves + "0-1"), "[Event=?] e4/1 e5/1 0-1");
+    BOOST_CHECK_EQUAL(parse(moves + "1/2-1/2"),
+        "[Event=?] e4/1 e5/1 1/2-1/2");
+    BOOST_CHECK_EQUAL(parse(moves + "*"), "[Event=?] e4/1 e5/1 *");
+
+    /* Parsing is stopped at the marker. */
+    BOOST_CHECK_EQUAL(parse(moves + "1-0 2. Nf3 ) ["),
+        "[Event=?] e4/1 e5/1 1-0");
+
+    /* The marker is checked against Result tag. Without the marker the
+     * result is taken from the tag, the error is at the end of moves. */
+    std::string const result = "[Result \"1-0\"]\n\n1. e4 e5";
+    ErrorLog strict(true);
+    BOOST_CHECK_EQUAL(parse(result + " 1-0", true, strict),
+        "[Result=1-0] e4/1 e5/1 1-0");
+    BOOST_CHECK_EQUAL(strict.getErrors(), "");
+    BOOST_CHECK_EQUAL(parse(result + " \n", true, strict),
+        "[Result=1-0] e4/1 e5/1 1-0");
+    BOOST_CHECK_EQUAL(parse(result + " 0-1", true, strict),
+        "[Result=1-0] e4/1 e5/1 0-1");
+    std::ostringstream errors;
+    errors << pgn::seIllegalTerminationMarker << '@' << result.size() <<
+        ' ' << pgn::seIllegalTerminationMarker << '@' << result.size() + 1;
+    BOOST_CHECK_EQUAL(strict.getErrors(), errors.str());
+    BOOST_CHECK_EQUAL(parse("1. e4", true, strict), "e4/1 *");
+
+    ErrorLog lenient(true);
+    BOOST_CHECK_EQUAL(parse(result + " 0-1", false, lenient),
+        "[Result=1-0] e4/1 e5/1 0-1");
+    BOOST_CHECK_EQUAL(parse(result, false, lenient),
+        "[Result=1-0] e4/1 e5/1 1-0");
+    BOOST_CHECK_EQUAL(lenient.getErrors(), "");
+}
+
+/* Critical errors stop parsing in any mode, their offset is at the token
+ * which is wrong. */
+BOOST_AUTO_TEST_CASE(critical_errors)
+{
+    struct Case
+    {
+        char const* pgn;
+        pgn::syntax_error_t code;
+        char const* token; /* the first occurrence in the PGN */
+        char const* events;
+    };
+    static Case const cases[] =
+    {
+        { "[1Event \"?\"]", pgn::seIllegalTagName, "1Event", "error:3" },
+        { "[Event \"?\"][$ \"?\"]", pgn::seIllegalTagName, "$",
+            "[Event=?] error:3" },
+        { "[Event ?]", pgn::seIllegalTagValue, "?", "error:2" },
+        { "[Event \"?\" e4", pgn::seIllegalToken, "e4", "error:1" },
+        { "(1. e4) e5 *", pgn::seIllegalToken, "(", "error:1" },
+        { "1. e4 ) *", pgn::seIllegalToken, ")", "e4/1 error:1" },
+        { "1. e4 (1. d4 *", pgn::seIllegalToken, "*",
+            "e4/1 ( d4/1 error:1" },
+        { "1. e4 (1. d4", pgn::seIllegalToken, NULL, "e4/1 ( d4/1 error:1" },
+        { "1. e4 [ *", pgn::seIllegalToken, "[", "e4/1 error:1" },
+        { "1. e4 {x *", pgn::seIllegalToken, "{", "e4/1 error:1" },
+        { "1. e4 & *", pgn::seIllegalToken, "&", "e4/1 error:1" }
+    };
+
+    for ( std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i )
+    {
+        std::string const pgn = cases[i].pgn;
+        std::size_t const offset = ( cases[i].token != NULL ) ?
+            pgn.find(cases[i].token) : pgn.size();
+        std::ostringstream expected;
+        expected << '!' << cases[i].code << '@' << offset;
+        for ( int isStrict = 0; isStrict < 2; ++isStrict )
+        {
+            ErrorLog log(true);
+            BOOST_CHECK_EQUAL(parse(pgn, isStrict != 0, log),
+                cases[i].events);
+            BOOST_CHECK_EQUAL(log.getErrors(), expected.str());
+        }
+    }
+}
+
+/* Non-critical errors are reported in strict mode only, parsing goes on if
+ * the reporter accepts the error. */
+BOOST_AUTO_TEST_CASE(non_critical_errors)
+{
+    std::string const pgn = "1. e4 e5 2. 0-0 Nc6 *";
+    std::ostringstream expected;
+    expected << pgn::seIllegalMove << '@' << pgn.find("0-0");
+
+    ErrorLog lenient(false);
+    BOOST_CHECK_EQUAL(parse(pgn, false, lenient), "e4/1 e5/1 0-0/2 Nc6/2 *");
+    BOOST_CHECK_EQUAL(lenient.getErrors(), "");
+
+    ErrorLog accepted(true);
+    BOOST_CHECK_EQUAL(parse(pgn, true, accepted), "e4/1 e5/1 0-0/2 Nc6/2 *");
+    BOOST_CHECK_EQUAL(accepted.getErrors(), expected.str());
+
+    ErrorLog rejected(false);
+    BOOST_CHECK_EQUAL(parse(pgn, true, rejected), "e4/1 e5/1 0-0/2 error:4");
+    BOOST_CHECK_EQUAL(rejected.getErrors(), expected.str());
+
+    /* A critical error is passed to the visitor without a reporter. */
+    pgn::GameParser parser(true, pgn::GameParser::ErrorReporter());
+    Recorder recorder;
+    std::string const illegal = "1. e4 ) *";
+    parser.parse(illegal.data(), illegal.size(), recorder);
+    BOOST_CHECK_EQUAL(recorder.getEvents(), "e4/1 error:1");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
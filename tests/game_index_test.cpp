@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "game_index.hpp"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+/* Contiguous games of various sizes (a huge one is in the middle) and
+ * games without tag pairs (movetext at the start of the game). */
+std::vector<pgn::GameInFile> makeGames(std::size_t count,
+    unsigned long long offset = 0)
+{
+    std::vector<pgn::GameInFile> games;
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        pgn::GameInFile game;
+        game.offset[pgn::goTagPairSection] = offset;
+        game.offset[pgn::goMoveTextSection] = offset + ( i % 5 ) * 37;
+        game.size = static_cast<unsigned>(( i % 5 ) * 37 + 1 + i % 300 +
+            ( i % 97 == 0 ? 100000 : 0 ) +
+            ( i == count / 2 ? 0xf0000000u : 0 ));
+        game.quickhash = static_cast<unsigned>(i * 2654435761u);
+        game.isSelected = i % 3 == 0;
+        games.push_back(game);
+        offset += game.size;
+    }
+
+    return games;
+}
+
+void checkIndex(pgn::GameIndex const& index,
+    std::vector<pgn::GameInFile> const& games)
+{
+    BOOST_REQUIRE_EQUAL(index.size(), games.size());
+    BOOST_CHECK_EQUAL(index.empty(), games.empty());
+    for ( std::size_t i = 0; i < games.size(); ++i )
+    {
+        pgn::GameInFile const game = index[i];
+        BOOST_CHECK_EQUAL(game.offset[pgn::goTagPairSection],
+            games[i].offset[pgn::goTagPairSection]);
+        BOOST_CHECK_EQUAL(game.offset[pgn::goMoveTextSection],
+            games[i].offset[pgn::goMoveTextSection]);
+        BOOST_CHECK_EQUAL(game.size, games[i].size);
+        BOOST_CHECK_EQUAL(game.quickhash, games[i].quickhash);
+        BOOST_CHECK_EQUAL(game.isSelected, games[i].isSelected);
+    }
+}
+
+void pushGames(pgn::GameIndex& index,
+    std::vector<pgn::GameInFile> const& games)
+{
+    for ( std::size_t i = 0; i < games.size(); ++i )
+    {
+        index.push_back(games[i]);
+    }
+}
+
+} /* unnamed namespace */
+
+BOOST_AUTO_TEST_SUITE(game_index)
+
+BOOST_AUTO_TEST_CASE(empty_index)
+{
+    pgn::GameIndex index;
+    BOOST_CHECK(index.empty());
+    BOOST_CHECK_EQUAL(index.size(), 0u);
+    BOOST_CHECK_EQUAL(index.getSelectedCount(), 0u);
+}
+
+/* Sealed blocks are bit packed, the last block isn't. */
+BOOST_AUTO_TEST_CASE(games_are_decoded_from_blocks)
+{
+    std::vector<pgn::GameInFile> const games =
+        makeGames(10 * pgn::GameIndex::BLOCK_SIZE + 17);
+    pgn::GameIndex index;
+    pushGames(index, games);
+    checkIndex(index, games);
+
+    pgn::GameInFile const last = index.back();
+    BOOST_CHECK_EQUAL(last.offset[pgn::goTagPairSection],
+        games.back().offset[pgn::goTagPairSection]);
+}
+
+BOOST_AUTO_TEST_CASE(offsets_above_4gb)
+{
+    std::vector<pgn::GameInFile> const games =
+        makeGames(5 * pgn::GameIndex::BLOCK_SIZE + 1, 5ull << 32);
+    pgn::GameIndex index;
+    pushGames(index, games);
+    checkIndex(index, games);
+}
+
+BOOST_AUTO_TEST_CASE(full_blocks_only)
+{
+    std::vector<pgn::GameInFile> const games =
+        makeGames(3 * pgn::GameIndex::BLOCK_SIZE);
+    pgn::GameIndex index;
+    pushGames(index, games);
+    checkIndex(index, games);
+}
+
+/* Games of the same size give zero width of deltas of movetext. */
+BOOST_AUTO_TEST_CASE(zero_width_deltas)
+{
+    std::vector<pgn::GameInFile> games;
+    for ( std::size_t i = 0; i < 2 * pgn::GameIndex::BLOCK_SIZE; ++i )
+    {
+        pgn::GameInFile game;
+        game.offset[pgn::goTagPairSection] = i * 10;
+        game.offset[pgn::goMoveTextSection] = i * 10;
+        game.size = 10;
+        games.push_back(game);
+    }
+
+    pgn::GameIndex index;
+    pushGames(index, games);
+    checkIndex(index, games);
+}
+
+/* Removing the first game of the tail unseals the previous block. */
+BOOST_AUTO_TEST_CASE(pop_back_unseals_block)
+{
+    std::size_t const count = 2 * pgn::GameIndex::BLOCK_SIZE + 3;
+    std::vector<pgn::GameInFile> games = makeGames(count);
+    pgn::GameIndex index;
+    pushGames(index, games);
+
+    while ( games.size() > pgn::GameIndex::BLOCK_SIZE - 5 )
+    {
+        index.pop_back();
+        games.pop_back();
+        checkIndex(index, games);
+    }
+
+    /* Other games are appended where the last one ends now. */
+    std::vector<pgn::GameInFile> const appended = makeGames(
+        2 * pgn::GameIndex::BLOCK_SIZE, games.back().offset[
+            pgn::goTagPairSection] + games.back().size);
+    pushGames(index, appended);
+    games.insert(games.end(), appended.begin(), appended.end());
+    checkIndex(index, games);
+
+    while ( !games.empty() )
+    {
+        index.pop_back();
+        games.pop_back();
+    }
+    checkIndex(index, games);
+}
+
+BOOST_AUTO_TEST_CASE(selected_games)
+{
+    std::vector<pgn::GameInFile> games =
+        makeGames(pgn::GameIndex::BLOCK_SIZE + 4);
+    pgn::GameIndex index;
+    pushGames(index, games);
+
+    std::vector<std::size_t> selected;
+    for ( std::size_t i = 0; i < games.size(); ++i )
+    {
+        if ( games[i].isSelected )
+        {
+            selected.push_back(i);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(index.getSelectedCount(), selected.size());
+    for ( std::size_t i = 0; i < selected.size(); ++i )
+    {
+        BOOST_CHECK_EQUAL(index.getSelected(i), selected[i]);
+    }
+
+    /* The last game (67, zero-based) isn't selected, the previous one is. */
+    index.pop_back();
+    BOOST_CHECK_EQUAL(index.getSelectedCount(), selected.size());
+    index.pop_back();
+    BOOST_CHECK_EQUAL(index.getSelectedCount(), selected.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(clear_and_swap)
+{
+    std::vector<pgn::GameInFile> const games =
+        makeGames(pgn::GameIndex::BLOCK_SIZE + 1);
+    pgn::GameIndex index;
+    pushGames(index, games);
+
+    pgn::GameIndex other;
+    other.swap(index);
+    checkIndex(other, games);
+    checkIndex(index, std::vector<pgn::GameInFile>());
+
+    other.clear();
+    checkIndex(other, std::vector<pgn::GameInFile>());
+    pushGames(other, games);
+    checkIndex(other, games);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
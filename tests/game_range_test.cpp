@@ -0,0 +1,290 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/game_range.hpp>
+#include <pgn/parser.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+unsigned const GAME_COUNT = 10;
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "game_range_test.pgn";
+
+/* Games with Site "x" are selected by the filter: 1-3, 5 and 7-8. */
+bool isSelected(unsigned n)
+{
+    return n <= 3 || n == 5 || n == 7 || n == 8;
+}
+
+/* The parser passes calls to the real parser and logs batches, e.g.
+ * "read 1+4 prefetch 5+4". It can pretend that the file is truncated. */
+class LoggingParser : public pgn::IParser
+{
+public:
+    explicit LoggingParser(pgn::IParser* parser) : m_parser(parser),
+        m_counter(0), m_gameLimit(GAME_COUNT) {}
+
+    /* The object is owned by the test. */
+    unsigned addRef() const { return ++m_counter; }
+    unsigned release() const { return --m_counter; }
+    unsigned getCounter() const { return m_counter; }
+
+    std::string const& getLog() const { return m_log; }
+
+    /* Games after the limit aren't read. */
+    void setGameLimit(unsigned gameLimit) { m_gameLimit = gameLimit; }
+
+    void setErrorHandler(pgn::IErrorHandlerCallback* callback)
+    {
+        m_parser->setErrorHandler(callback);
+    }
+    unsigned getGameCount() const { return m_parser->getGameCount(); }
+    pgn::IGame const* readGame(unsigned gameN)
+    {
+        return m_parser->readGame(gameN);
+    }
+    unsigned readGames(unsigned firstGame, unsigned count,
+        pgn::IGame const** games)
+    {
+        log("read", firstGame, count);
+        count = std::min(count, m_gameLimit >= firstGame ?
+            m_gameLimit - firstGame + 1 : 0);
+        return m_parser->readGames(firstGame, count, games);
+    }
+    void prefetchGames(unsigned firstGame, unsigned count)
+    {
+        log("prefetch", firstGame, count);
+        m_parser->prefetchGames(firstGame, count);
+    }
+    bool visitGame(pgn::IGameVisitor& visitor, unsigned gameN)
+    {
+        return m_parser->visitGame(visitor, gameN);
+    }
+    bool refresh() { return m_parser->refresh(); }
+    void setMappedSizeLimit(unsigned long long size)
+    {
+        m_parser->setMappedSizeLimit(size);
+    }
+    void getIndexingProgress(unsigned long long& scannedSize,
+        unsigned long long& fileSize, unsigned& gameCount) const
+    {
+        m_parser->getIndexingProgress(scannedSize, fileSize, gameCount);
+    }
+    void cancelIndexing() { m_parser->cancelIndexing(); }
+    void setFileChangeHandler(pgn::IFileChangeCallback* callback)
+    {
+        m_parser->setFileChangeHandler(callback);
+    }
+    void setProjection(char const* const* tagNames, unsigned parts)
+    {
+        m_parser->setProjection(tagNames, parts);
+    }
+    unsigned getSelectedGameCount() const
+    {
+        return m_parser->getSelectedGameCount();
+    }
+    unsigned getSelectedGame(unsigned n) const
+    {
+        return m_parser->getSelectedGame(n);
+    }
+
+private:
+    void log(char const* call, unsigned firstGame, unsigned count)
+    {
+        char entry[64];
+        std::sprintf(entry, "%s%s %u+%u", m_log.empty() ? "" : " ", call,
+            firstGame, count);
+        m_log += entry;
+    }
+
+    boost::intrusive_ptr<pgn::IParser> const m_parser;
+    mutable unsigned m_counter;
+    unsigned m_gameLimit;
+    std::string m_log;
+};
+
+class Fixture
+{
+public:
+    Fixture()
+    {
+        std::FILE* const file = std::fopen(PGN_PATH, "wb");
+        BOOST_REQUIRE(file != NULL);
+        for ( unsigned n = 1; n <= GAME_COUNT; ++n )
+        {
+            std::fprintf(file, "[Event \"game %u\"]\n[Site \"%s\"]\n\n"
+                "1. e4 *\n\n", n, isSelected(n) ? "x" : "y");
+        }
+        std::fclose(file);
+    }
+
+    ~Fixture()
+    {
+        std::remove(PGN_PATH);
+    }
+
+    /* Numbers of games of the range, e.g. "1 2 3". */
+    static std::string iterate(pgn::GameRange& range)
+    {
+        std::string numbers;
+        for ( pgn::GameRange::iterator it = range.begin(); it != range.end();
+            ++it )
+        {
+            char number[16];
+            std::sprintf(number, "%u", it->getSequenceNumber());
+            BOOST_CHECK_EQUAL(( *it ).getTagEvent(),
+                "game " + std::string(number));
+            numbers += ( numbers.empty() ? "" : " " ) + std::string(number);
+        }
+
+        return numbers;
+    }
+};
+
+pgn::IParser* createParser(bool isFiltered)
+{
+    pgn::tag_predicate_t const filter[] =
+    {
+        { "Site", pgn::tpEqual, "x", NULL, false },
+        { NULL, pgn::tpEqual, NULL, NULL, false }
+    };
+    pgn::IParser* const parser = pgn::IParser::create(PGN_PATH, false,
+        pgn::poDefault, isFiltered ? filter : NULL);
+    BOOST_REQUIRE(parser != NULL);
+    return parser;
+}
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(game_range, Fixture)
+
+/* The range ends when a batch is empty. */
+BOOST_AUTO_TEST_CASE(all_games_by_batches)
+{
+    LoggingParser parser(createParser(false));
+    {
+        pgn::GameRange range(&parser, pgn::roDefault, 4);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2 3 4 5 6 7 8 9 10");
+        BOOST_CHECK(range.begin() == range.end());
+        BOOST_CHECK_EQUAL(parser.getCounter(), 1u);
+    }
+    BOOST_CHECK_EQUAL(parser.getLog(), "read 1+4 read 5+4 read 9+4 read 11+4");
+    BOOST_CHECK_EQUAL(parser.getCounter(), 0u);
+
+    LoggingParser exact(createParser(false));
+    {
+        pgn::GameRange range(&exact, pgn::roDefault, 5);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2 3 4 5 6 7 8 9 10");
+    }
+    BOOST_CHECK_EQUAL(exact.getLog(), "read 1+5 read 6+5 read 11+5");
+
+    /* A batch has one game at least. */
+    LoggingParser single(createParser(false));
+    single.setGameLimit(2);
+    {
+        pgn::GameRange range(&single, pgn::roDefault, 0);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2");
+    }
+    BOOST_CHECK_EQUAL(single.getLog(), "read 1+1 read 2+1 read 3+1");
+}
+
+/* The next batch is prefetched after each batch which isn't empty, even at
+ * the end of the file. */
+BOOST_AUTO_TEST_CASE(batches_are_prefetched)
+{
+    LoggingParser parser(createParser(false));
+    {
+        pgn::GameRange range(&parser, pgn::roPrefetch, 4);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2 3 4 5 6 7 8 9 10");
+    }
+    BOOST_CHECK_EQUAL(parser.getLog(), "read 1+4 prefetch 5+4 read 5+4 "
+        "prefetch 9+4 read 9+4 prefetch 11+4 read 11+4");
+}
+
+/* Selected games are read by runs of consecutive games, a run is split by
+ * the end of a batch. */
+BOOST_AUTO_TEST_CASE(selected_games_by_runs)
+{
+    LoggingParser parser(createParser(true));
+    {
+        pgn::GameRange range(&parser, pgn::roSelectedOnly, 4);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2 3 5 7 8");
+    }
+    BOOST_CHECK_EQUAL(parser.getLog(), "read 1+3 read 5+1 read 7+2");
+
+    LoggingParser prefetched(createParser(true));
+    {
+        pgn::GameRange range(&prefetched,
+            pgn::roSelectedOnly | pgn::roPrefetch, 2);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2 3 5 7 8");
+    }
+    BOOST_CHECK_EQUAL(prefetched.getLog(), "read 1+2 prefetch 3+1 "
+        "prefetch 5+1 read 3+1 read 5+1 prefetch 7+2 read 7+2");
+
+    /* Without a filter every game is selected. */
+    LoggingParser unfiltered(createParser(false));
+    {
+        pgn::GameRange range(&unfiltered, pgn::roSelectedOnly, 8);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2 3 4 5 6 7 8 9 10");
+    }
+    BOOST_CHECK_EQUAL(unfiltered.getLog(), "read 1+8 read 9+2");
+}
+
+/* The range ends at the first game which can't be read. */
+BOOST_AUTO_TEST_CASE(truncated_file)
+{
+    LoggingParser parser(createParser(true));
+    parser.setGameLimit(2);
+    {
+        pgn::GameRange range(&parser, pgn::roSelectedOnly, 4);
+        BOOST_CHECK_EQUAL(iterate(range), "1 2");
+    }
+    BOOST_CHECK_EQUAL(parser.getLog(), "read 1+3 read 3+1");
+}
+
+/* A game can be kept after its batch. */
+BOOST_AUTO_TEST_CASE(games_are_owned_by_range)
+{
+    LoggingParser parser(createParser(false));
+    pgn::IGame const* game = NULL;
+    {
+        pgn::GameRange range(&parser, pgn::roDefault, 2);
+        pgn::GameRange::iterator it = range.begin();
+        game = &*it;
+        game->addRef();
+        ++it;
+        ++it;
+        BOOST_CHECK_EQUAL(it->getSequenceNumber(), 3u);
+    }
+    BOOST_CHECK_EQUAL(game->getTagEvent(), "game 1");
+    BOOST_CHECK_EQUAL(game->getMoveCount(pgn::MAIN_LINE), 1u);
+    game->release();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,221 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/parser.hpp>
+#include "game_scanner.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+std::size_t const GAME_COUNT = 400;
+
+/* Games which are hard to split: game starts inside comments (one of them
+ * is longer than a chunk of parallel scanning), rest of line comments with
+ * braces, escaped lines, CRLF line ends, indented tag pairs and games which
+ * aren't separated by an empty line. */
+std::string makePgn()
+{
+    std::string pgn;
+    for ( std::size_t i = 0; i < GAME_COUNT; ++i )
+    {
+        char event[64];
+        std::sprintf(event, "[Event \"game %u\"]", static_cast<unsigned>(i));
+        switch ( i % 8 )
+        {
+        case 0:
+            pgn += std::string(event) + "\n[Site \"?\"]\n\n1. e4 e5 *\n\n";
+            break;
+        case 1:
+            pgn += std::string(event) + "\n\n1. e4 {comment\n\n"
+                "[Event \"fake\"]\n} e5 1-0\n\n";
+            break;
+        case 2:
+            pgn += std::string(event) + "\n\n1. e4 ; { isn't a comment\n"
+                "e5 0-1\n\n";
+            break;
+        case 3:
+            pgn += "%[Event \"escaped\"]\n" + std::string(event) +
+                "\n\n1. d4 *\n\n";
+            break;
+        case 4:
+            pgn += std::string(event) + "\r\n\r\n1. c4 c5 *\r\n\r\n";
+            break;
+        case 5:
+            pgn += "  " + std::string(event) + "\n\n1. Nf3 *\n";
+            break;
+        case 6:
+            pgn += std::string(event) + "\n\n1. e4 {";
+            for ( std::size_t j = 0; j < 200; ++j )
+            {
+                pgn += "\n\n[Event \"fake\"]\n\n1. d4 *\n";
+            }
+            pgn += "} 1/2-1/2\n\n";
+            break;
+        default:
+            pgn += std::string(event) + "\n\n1. e4 (1. d4) *\n\n";
+            break;
+        }
+    }
+
+    return pgn;
+}
+
+/* Scan data by pieces of given size (0 means at once). */
+pgn::GameIndex scan(std::string const& pgn, std::size_t pieceSize,
+    unsigned threadCount)
+{
+    pgn::GameScanner scanner;
+    pgn::GameIndex games;
+    if ( pieceSize == 0 )
+    {
+        pieceSize = pgn.size();
+    }
+    for ( std::size_t offset = 0; offset < pgn.size(); offset += pieceSize )
+    {
+        std::size_t const size = std::min(pieceSize, pgn.size() - offset);
+        if ( threadCount > 1 )
+        {
+            scanner.scanInParallel(pgn.data() + offset, size, threadCount,
+                games);
+        } else
+        {
+            scanner.scan(pgn.data() + offset, size, games);
+        }
+    }
+    scanner.finish(games);
+
+    return games;
+}
+
+void checkSameGames(pgn::GameIndex const& games,
+    pgn::GameIndex const& expected)
+{
+    BOOST_REQUIRE_EQUAL(games.size(), expected.size());
+    for ( std::size_t i = 0; i < games.size(); ++i )
+    {
+        pgn::GameInFile const game = games[i];
+        pgn::GameInFile const expectedGame = expected[i];
+        BOOST_CHECK_EQUAL(game.offset[pgn::goTagPairSection],
+            expectedGame.offset[pgn::goTagPairSection]);
+        BOOST_CHECK_EQUAL(game.offset[pgn::goMoveTextSection],
+            expectedGame.offset[pgn::goMoveTextSection]);
+        BOOST_CHECK_EQUAL(game.size, expectedGame.size);
+        BOOST_CHECK_EQUAL(game.quickhash, expectedGame.quickhash);
+    }
+}
+
+unsigned getGameCount(char const* pgnfile, unsigned options)
+{
+    pgn::IParser* const parser = pgn::IParser::create(pgnfile, false,
+        options);
+    BOOST_REQUIRE(parser != NULL);
+    parser->addRef();
+    unsigned const count = parser->getGameCount();
+    parser->release();
+    return count;
+}
+
+} /* unnamed namespace */
+
+BOOST_AUTO_TEST_SUITE(game_scanner)
+
+BOOST_AUTO_TEST_CASE(games_are_found)
+{
+    std::string const pgn = makePgn();
+    pgn::GameIndex const games = scan(pgn, 0, 1);
+    BOOST_REQUIRE_EQUAL(games.size(), GAME_COUNT);
+
+    /* Each game starts with its first tag pair (or the escaped line). */
+    for ( std::size_t i = 0; i < games.size(); ++i )
+    {
+        pgn::GameInFile const game = games[i];
+        std::string const text = pgn.substr(static_cast<std::size_t>(
+            game.offset[pgn::goTagPairSection]), game.size);
+        char event[32];
+        std::sprintf(event, "[Event \"game %u\"]", static_cast<unsigned>(i));
+        BOOST_CHECK_MESSAGE(text.find(event) < 32, "game " << i);
+        BOOST_CHECK(game.offset[pgn::goMoveTextSection] >
+            game.offset[pgn::goTagPairSection]);
+        BOOST_CHECK(game.quickhash != pgn::NULL_QUICKHASH);
+    }
+    BOOST_CHECK_EQUAL(games.back().offset[pgn::goTagPairSection] +
+        games.back().size, pgn.size());
+}
+
+/* The state of the scanner is kept between pieces. */
+BOOST_AUTO_TEST_CASE(pieces_give_same_games)
+{
+    std::string const pgn = makePgn();
+    pgn::GameIndex const expected = scan(pgn, 0, 1);
+    std::size_t const pieceSizes[] = { 1, 7, 64, 1000, 4096 };
+    for ( std::size_t i = 0; i < sizeof(pieceSizes) / sizeof(pieceSizes[0]);
+        ++i )
+    {
+        BOOST_TEST_CHECKPOINT("piece size " << pieceSizes[i]);
+        checkSameGames(scan(pgn, pieceSizes[i], 1), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_scan_gives_same_games)
+{
+    std::string const pgn = makePgn();
+    pgn::GameIndex const expected = scan(pgn, 0, 1);
+    unsigned const threadCounts[] = { 2, 3, 4, 8, 64 };
+    std::size_t const pieceSizes[] = { 0, 5000, 777 };
+    for ( std::size_t i = 0;
+        i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i )
+    {
+        for ( std::size_t j = 0;
+            j < sizeof(pieceSizes) / sizeof(pieceSizes[0]); ++j )
+        {
+            BOOST_TEST_CHECKPOINT(threadCounts[i] << " threads, piece size "
+                << pieceSizes[j]);
+            checkSameGames(scan(pgn, pieceSizes[j], threadCounts[i]),
+                expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(empty_data)
+{
+    BOOST_CHECK_EQUAL(scan(std::string(), 0, 1).size(), 0u);
+    BOOST_CHECK_EQUAL(scan(std::string("\n\n  \n"), 0, 4).size(), 0u);
+}
+
+/* Numbers of games in test files, they are the same with each option. */
+BOOST_AUTO_TEST_CASE(game_count_of_test_files)
+{
+    unsigned const options[] = { pgn::poDefault, pgn::poParallelIndexing,
+        pgn::poAsyncIndexing };
+    for ( std::size_t i = 0; i < sizeof(options) / sizeof(options[0]); ++i )
+    {
+        BOOST_CHECK_EQUAL(getGameCount(PGN_TESTS_DIR "/simple/test.pgn",
+            options[i]), 1u);
+        BOOST_CHECK_EQUAL(getGameCount(PGN_TESTS_DIR "/empty/test.pgn",
+            options[i]), 0u);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
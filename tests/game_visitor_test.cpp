@@ -0,0 +1,307 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/game_visitor.hpp>
+#include <pgn/move.hpp>
+#include <pgn/parser.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "game_visitor_test.pgn";
+
+/* Comments before the first move of a variation, nested variations, an
+ * unknown NAG and a game from a position with black to move. */
+char const PGN[] =
+    "[Event \"annotated\"]\n[Site \"?\"]\n[White \"A\"]\n[Black \"B\"]\n"
+    "[Result \"1-0\"]\n\n"
+    "{opening} 1. e4 $1 {best by test} e5 (1... c5 $2 (1... e6 {french} "
+    "2. d4) 2. Nf3) (1... {rare} d5) 2. Nf3 $0 Nc6 3. Bb5 $14 $36 a6 1-0\n\n"
+    "[Event \"position\"]\n[Result \"0-1\"]\n[SetUp \"1\"]\n"
+    "[FEN \"3r2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 20\"]\n\n"
+    "20... Rd1# 0-1\n\n"
+    "[Event \"draw\"]\n[Opening \"QGA\"]\n[Result \"1/2-1/2\"]\n\n"
+    "1. d4 d5 2. c4 dxc4 (2... e6 3. Nc3 (3. Nf3) Nf6) 3. e3 1/2-1/2\n";
+
+unsigned const GAME_COUNT = 3;
+
+class ErrorCounter : public pgn::IErrorHandlerCallback
+{
+public:
+    ErrorCounter() : m_count(0) {}
+
+    unsigned addRef() const { return 1; }
+    unsigned release() const { return 1; }
+
+    bool operator()(bool /* isCritical */, pgn::syntax_error_t /* code */,
+        wchar_t const* /* description */, unsigned long long /* line */,
+        unsigned /* column */)
+    {
+        ++m_count;
+        return true;
+    }
+
+    unsigned getCount() const { return m_count; }
+
+private:
+    unsigned m_count;
+};
+
+char const* const RESULTS[] = { "1-0", "0-1", "1/2-1/2", "*" };
+
+/* Elements of a game are written like "[Event=x] 1.e4 $1 {c} ( 1.d4 )
+ * =1-0". The game keeps NAGs and comments with the move (comments are
+ * joined, a comment before the first move of a variation belongs to the
+ * move), thus they are written after the move in the same way. */
+class Recorder : public pgn::IGameVisitor
+{
+public:
+    Recorder() : m_hasMove(1, false) {}
+
+    std::string const& getText() const { return m_text; }
+
+    void onTagPair(char const* name, std::size_t nameLength,
+        char const* value, std::size_t valueLength)
+    {
+        m_text += " [" + std::string(name, nameLength) + "=" +
+            std::string(value, valueLength) + "]";
+    }
+
+    void onMove(char const* san, std::size_t length, unsigned moveNumber)
+    {
+        std::string comment;
+        comment.swap(m_pending);
+        flush();
+        char number[16];
+        std::sprintf(number, " %u.", moveNumber);
+        m_text += number + std::string(san, length);
+        m_comment.swap(comment);
+        m_hasMove.back() = true;
+    }
+
+    void onNAG(pgn::NAG_t nag)
+    {
+        char text[16];
+        std::sprintf(text, " $%d", static_cast<int>(nag));
+        m_nags += text;
+    }
+
+    void onComment(char const* comment, std::size_t length)
+    {
+        std::string& text = m_hasMove.back() ? m_comment : m_pending;
+        text += ( text.empty() ? "" : " " ) + std::string(comment, length);
+    }
+
+    void onVariationBegin()
+    {
+        flush();
+        m_text += " (";
+        m_hasMove.push_back(false);
+    }
+
+    void onVariationEnd()
+    {
+        flush();
+        m_text += " )";
+        m_hasMove.pop_back();
+    }
+
+    void onResult(pgn::game_result_t result)
+    {
+        flush();
+        m_text += " =" + std::string(RESULTS[result]);
+    }
+
+    void onSyntaxError(pgn::syntax_error_t code)
+    {
+        flush();
+        char text[16];
+        std::sprintf(text, " !%d", static_cast<int>(code));
+        m_text += text;
+    }
+
+private:
+    /* Write NAGs and the comment of the last move. */
+    void flush()
+    {
+        m_text += m_nags;
+        if ( !m_comment.empty() )
+        {
+            m_text += " {" + m_comment + "}";
+        }
+        m_nags.clear();
+        m_comment.clear();
+        m_pending.clear();
+    }
+
+    std::string m_text;
+    std::string m_nags; /* NAGs of the last move */
+    std::string m_comment; /* comments of the last move */
+    std::string m_pending; /* comments before the first move */
+    std::vector<bool> m_hasMove; /* for the main line and open variations */
+};
+
+/* A move is valid until the next call of getMove(), thus its variations
+ * are described after it. */
+void describeVariation(pgn::IGame const& game, pgn::variation_t v,
+    std::string& text)
+{
+    for ( unsigned n = 1; n <= game.getMoveCount(v); ++n )
+    {
+        pgn::IMove const* const move = game.getMove(n, v);
+        BOOST_REQUIRE(move != NULL);
+        char number[16];
+        std::sprintf(number, " %u.", move->getMoveNumber());
+        text += number + std::string(move->getSAN());
+        for ( unsigned i = 1; i <= move->getNAGs(NULL, 0); ++i )
+        {
+            char nag[16];
+            std::sprintf(nag, " $%d", static_cast<int>(move->getNAG(i)));
+            text += nag;
+        }
+        if ( move->getComment() != NULL )
+        {
+            text += " {" + std::string(move->getComment()) + "}";
+        }
+
+        std::vector<pgn::variation_t> variations;
+        for ( unsigned i = 1; i <= game.getVariationCount(move); ++i )
+        {
+            variations.push_back(game.getVariation(move, i));
+        }
+        for ( std::size_t i = 0; i < variations.size(); ++i )
+        {
+            text += " (";
+            describeVariation(game, variations[i], text);
+            text += " )";
+        }
+    }
+}
+
+/* The game is written like Recorder does. */
+std::string describe(pgn::IGame const& game)
+{
+    std::string text;
+    for ( unsigned n = 1; n <= game.getTagPairCount(); ++n )
+    {
+        pgn::tag_pair_t const tagPair = game.getTagPair(n);
+        text += " [" + std::string(tagPair.name) + "=" + tagPair.value + "]";
+    }
+    describeVariation(game, pgn::MAIN_LINE, text);
+    return text + " =" + RESULTS[game.getResult()];
+}
+
+class Fixture
+{
+public:
+    Fixture()
+    {
+        std::FILE* const file = std::fopen(PGN_PATH, "wb");
+        BOOST_REQUIRE(file != NULL);
+        std::fputs(PGN, file);
+        std::fclose(file);
+    }
+
+    ~Fixture()
+    {
+        std::remove(PGN_PATH);
+    }
+
+    /* Both ways of reading the game should give the same elements. */
+    static void checkGames(char const* path, unsigned gameCount)
+    {
+        ErrorCounter errors;
+        boost::intrusive_ptr<pgn::IParser> const parser(
+            pgn::IParser::create(path, true));
+        BOOST_REQUIRE(parser);
+        parser->setErrorHandler(&errors);
+        for ( unsigned n = 1; n <= gameCount; ++n )
+        {
+            Recorder recorder;
+            BOOST_REQUIRE(parser->visitGame(recorder, n));
+            pgn::IGame const* const game = parser->readGame(n);
+            BOOST_REQUIRE(game != NULL);
+            BOOST_CHECK_EQUAL(recorder.getText(), describe(*game));
+            game->release();
+        }
+        BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+    }
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(game_visitor, Fixture)
+
+BOOST_AUTO_TEST_CASE(annotated_games)
+{
+    checkGames(PGN_PATH, GAME_COUNT);
+
+    ErrorCounter errors;
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, true));
+    parser->setErrorHandler(&errors);
+    Recorder recorder;
+    BOOST_REQUIRE(parser->visitGame(recorder, 1));
+    BOOST_CHECK_EQUAL(recorder.getText(), " [Event=annotated] [Site=?] "
+        "[White=A] [Black=B] [Result=1-0] 1.e4 $1 {opening best by test} "
+        "1.e5 ( 1.c5 $2 ( 1.e6 {french} 2.d4 ) 2.Nf3 ) ( 1.d5 {rare} ) "
+        "2.Nf3 2.Nc6 3.Bb5 $14 $36 3.a6 =1-0");
+
+    recorder = Recorder();
+    BOOST_REQUIRE(parser->visitGame(recorder, 2));
+    BOOST_CHECK_EQUAL(recorder.getText(), " [Event=position] [Result=0-1] "
+        "[SetUp=1] [FEN=3r2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 20] 20.Rd1# "
+        "=0-1");
+    BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(long_game)
+{
+    checkGames(PGN_TESTS_DIR "/simple/test.pgn", 1);
+}
+
+/* Games are visited one by one like readGame() reads them. */
+BOOST_AUTO_TEST_CASE(next_game_is_visited)
+{
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, true));
+    for ( unsigned n = 1; n <= GAME_COUNT; ++n )
+    {
+        Recorder recorder;
+        BOOST_REQUIRE(parser->visitGame(recorder));
+        pgn::IGame const* const game = parser->readGame(n);
+        BOOST_REQUIRE(game != NULL);
+        BOOST_CHECK_EQUAL(recorder.getText(), describe(*game));
+        game->release();
+    }
+    Recorder recorder;
+    BOOST_CHECK(!parser->visitGame(recorder));
+    BOOST_CHECK_EQUAL(recorder.getText(), "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,208 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/parser.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+/* Two blocks of the index and the tail. */
+unsigned const GAME_COUNT = 150;
+
+/* Files are created in the working directory of the test. */
+char const PGN_PATH[] = "index_file_test.pgn";
+char const INDEX_PATH[] = "index_file_test.pgn.idx";
+
+std::string makeGame(unsigned n)
+{
+    char game[128];
+    std::sprintf(game, "[Event \"game %u\"]\n[Site \"?\"]\n\n1. e4 %s*\n\n",
+        n, ( n % 3 == 0 ) ? "{ comment } e5 " : "");
+    return game;
+}
+
+void writeFile(char const* path, std::string const& data)
+{
+    std::FILE* const file = std::fopen(path, "wb");
+    BOOST_REQUIRE(file != NULL);
+    BOOST_REQUIRE_EQUAL(std::fwrite(data.data(), 1, data.size(), file),
+        data.size());
+    std::fclose(file);
+}
+
+std::string readFile(char const* path)
+{
+    std::string data;
+    std::FILE* const file = std::fopen(path, "rb");
+    if ( file != NULL )
+    {
+        char buffer[4096];
+        std::size_t size;
+        while ( ( size = std::fread(buffer, 1, sizeof(buffer), file) ) != 0 )
+        {
+            data.append(buffer, size);
+        }
+        std::fclose(file);
+    }
+
+    return data;
+}
+
+/* Open the PGN file with the index and check that each game is read from
+ * its place. */
+void checkGames(unsigned gameCount)
+{
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false, pgn::poIndexFile));
+    BOOST_REQUIRE(parser);
+    BOOST_REQUIRE_EQUAL(parser->getGameCount(), gameCount);
+    for ( unsigned n = 1; n <= gameCount; ++n )
+    {
+        pgn::IGame const* const game = parser->readGame(n);
+        BOOST_REQUIRE(game != NULL);
+        char event[32];
+        std::sprintf(event, "game %u", n);
+        BOOST_CHECK_EQUAL(game->getTagEvent(), event);
+        BOOST_CHECK_EQUAL(game->getMoveCount(pgn::MAIN_LINE),
+            ( n % 3 == 0 ) ? 2u : 1u);
+        game->release();
+    }
+}
+
+/* The PGN file and its index which is written by lightweight parsing. */
+struct IndexFileFixture
+{
+    IndexFileFixture()
+    {
+        std::remove(INDEX_PATH);
+        for ( unsigned n = 1; n <= GAME_COUNT; ++n )
+        {
+            pgn += makeGame(n);
+        }
+        writeFile(PGN_PATH, pgn);
+
+        checkGames(GAME_COUNT);
+        index = readFile(INDEX_PATH);
+        BOOST_REQUIRE(!index.empty());
+    }
+
+    ~IndexFileFixture()
+    {
+        std::remove(PGN_PATH);
+        std::remove(INDEX_PATH);
+    }
+
+    /* Write the corrupted index and check that the PGN file is parsed
+     * again: games are right and the index is written anew. */
+    void checkCorruptedIndex(std::string const& corruptedIndex)
+    {
+        writeFile(INDEX_PATH, corruptedIndex);
+        checkGames(GAME_COUNT);
+        BOOST_CHECK(readFile(INDEX_PATH) == index);
+    }
+
+    std::string pgn;
+    std::string index;
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(index_file, IndexFileFixture)
+
+BOOST_AUTO_TEST_CASE(index_is_reused)
+{
+    checkGames(GAME_COUNT);
+    BOOST_CHECK(readFile(INDEX_PATH) == index);
+}
+
+BOOST_AUTO_TEST_CASE(truncated_index_is_rejected)
+{
+    checkCorruptedIndex(index.substr(0, index.size() - 1));
+    checkCorruptedIndex(index.substr(0, 16));
+    checkCorruptedIndex(std::string());
+}
+
+BOOST_AUTO_TEST_CASE(index_of_other_version_is_rejected)
+{
+    /* The version follows the magic. */
+    std::string corrupted = index;
+    corrupted[8] ^= 0x7f;
+    checkCorruptedIndex(corrupted);
+
+    corrupted = index;
+    corrupted[0] = 'X';
+    checkCorruptedIndex(corrupted);
+}
+
+/* Quickhashes of games are the last array of the index, a sample of games
+ * is checked against the PGN file. */
+BOOST_AUTO_TEST_CASE(index_with_wrong_hash_is_rejected)
+{
+    std::size_t const quickhashOffset = index.size() - GAME_COUNT * 4;
+    std::size_t const games[] = { 0, GAME_COUNT - 1 };
+    for ( std::size_t i = 0; i < sizeof(games) / sizeof(games[0]); ++i )
+    {
+        std::string corrupted = index;
+        corrupted[quickhashOffset + games[i] * 4] ^= 0x01;
+        checkCorruptedIndex(corrupted);
+    }
+}
+
+/* A change of a byte of the index must not crash the parser: the index is
+ * either rejected or it gives right games. */
+BOOST_AUTO_TEST_CASE(corrupted_index_is_safe)
+{
+    for ( std::size_t offset = 0; offset < index.size(); offset += 7 )
+    {
+        BOOST_TEST_CHECKPOINT("offset " << offset);
+        std::string corrupted = index;
+        corrupted[offset] ^= 0x55;
+        writeFile(INDEX_PATH, corrupted);
+
+        boost::intrusive_ptr<pgn::IParser> const parser(pgn::IParser::create(
+            PGN_PATH, false, pgn::poIndexFile | pgn::poVerifyHash));
+        BOOST_REQUIRE(parser);
+        for ( unsigned n = 1; n <= parser->getGameCount(); ++n )
+        {
+            pgn::IGame const* const game = parser->readGame(n);
+            if ( game != NULL )
+            {
+                game->release();
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(changed_pgn_file_is_parsed_again)
+{
+    writeFile(PGN_PATH, pgn + makeGame(GAME_COUNT + 1));
+    checkGames(GAME_COUNT + 1);
+    BOOST_CHECK(readFile(INDEX_PATH) != index);
+    checkGames(GAME_COUNT + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,216 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/move.hpp>
+#include <pgn/parser.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "lazy_parsing_test.pgn";
+
+/* Castling with zeros is reported in strict mode each time the movetext is
+ * parsed, thus the reports count the parses. */
+char const PGN[] =
+    "[Event \"lazy\"]\n[Result \"1-0\"]\n\n"
+    "1. e4 e5 2. Nf3 Nc6 (2... d6) 3. Bc4 Bc5 4. 0-0 Nf6 1-0\n\n"
+    "[Event \"next\"]\n\n1. d4 *\n";
+
+class ErrorCounter : public pgn::IErrorHandlerCallback
+{
+public:
+    ErrorCounter() : m_count(0) {}
+
+    unsigned addRef() const { return 1; }
+    unsigned release() const { return 1; }
+
+    bool operator()(bool isCritical, pgn::syntax_error_t code,
+        wchar_t const* /* description */, unsigned long long line,
+        unsigned /* column */)
+    {
+        BOOST_CHECK(!isCritical);
+        BOOST_CHECK_EQUAL(code, pgn::seIllegalMove);
+        BOOST_CHECK_EQUAL(line, 4u);
+        ++m_count;
+        return true;
+    }
+
+    unsigned getCount() const { return m_count; }
+
+private:
+    unsigned m_count;
+};
+
+/* A method of IGame which parses the movetext. */
+typedef void (*Accessor)(pgn::IGame const& game);
+
+void getMove(pgn::IGame const& game)
+{
+    pgn::IMove const* const move = game.getMove(7);
+    BOOST_REQUIRE(move != NULL);
+    BOOST_CHECK_EQUAL(move->getSAN(), "O-O");
+}
+
+void getMoveCount(pgn::IGame const& game)
+{
+    BOOST_CHECK_EQUAL(game.getMoveCount(pgn::MAIN_LINE), 8u);
+}
+
+void getVariationCount(pgn::IGame const& game)
+{
+    BOOST_CHECK_EQUAL(game.getVariationCount(), 2u);
+}
+
+void getMoveText(pgn::IGame const& game)
+{
+    BOOST_CHECK_EQUAL(game.getMoveText(),
+        "1. e4 e5 2. Nf3 Nc6 (2... d6) 3. Bc4 Bc5 4. 0-0 Nf6");
+}
+
+void getResult(pgn::IGame const& game)
+{
+    BOOST_CHECK_EQUAL(game.getResult(), pgn::grWhiteWin);
+}
+
+Accessor const ACCESSORS[] =
+{
+    getMove, getMoveCount, getVariationCount, getMoveText, getResult
+};
+std::size_t const ACCESSOR_COUNT = sizeof(ACCESSORS) / sizeof(ACCESSORS[0]);
+
+class Fixture
+{
+public:
+    Fixture()
+    {
+        std::FILE* const file = std::fopen(PGN_PATH, "wb");
+        BOOST_REQUIRE(file != NULL);
+        BOOST_REQUIRE_EQUAL(std::fwrite(PGN, 1, std::strlen(PGN), file),
+            std::strlen(PGN));
+        std::fclose(file);
+    }
+
+    ~Fixture()
+    {
+        std::remove(PGN_PATH);
+    }
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(lazy_parsing, Fixture)
+
+/* Tags are known after readGame(), the movetext isn't parsed yet. */
+BOOST_AUTO_TEST_CASE(movetext_is_pending)
+{
+    ErrorCounter errors;
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, true));
+    BOOST_REQUIRE(parser);
+    parser->setErrorHandler(&errors);
+
+    pgn::IGame const* const game = parser->readGame();
+    BOOST_REQUIRE(game != NULL);
+    BOOST_CHECK_EQUAL(game->getTagValue("Event"), "lazy");
+    BOOST_CHECK_EQUAL(game->getTagPairCount(), 2u);
+    BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+
+    /* The next game doesn't parse the movetext of the previous one. */
+    pgn::IGame const* const next = parser->readGame();
+    BOOST_REQUIRE(next != NULL);
+    BOOST_CHECK_EQUAL(next->getMoveCount(pgn::MAIN_LINE), 1u);
+    BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+    next->release();
+
+    getMoveCount(*game);
+    BOOST_CHECK_EQUAL(errors.getCount(), 1u);
+    game->release();
+}
+
+/* Any method which needs the movetext parses it, others reuse it. The
+ * parser reports an error once, thus each game is read by a new parser and
+ * objects of the game are checked to be the same after next calls. */
+BOOST_AUTO_TEST_CASE(movetext_is_parsed_once)
+{
+    for ( std::size_t first = 0; first < ACCESSOR_COUNT; ++first )
+    {
+        BOOST_TEST_MESSAGE("the first accessor is " << first);
+        ErrorCounter errors;
+        boost::intrusive_ptr<pgn::IParser> const parser(
+            pgn::IParser::create(PGN_PATH, true));
+        BOOST_REQUIRE(parser);
+        parser->setErrorHandler(&errors);
+        pgn::IGame const* const game = parser->readGame();
+        BOOST_REQUIRE(game != NULL);
+        BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+
+        ACCESSORS[first](*game);
+        BOOST_CHECK_EQUAL(errors.getCount(), 1u);
+        pgn::IMove const* const move = game->getMove(1);
+        char const* const moveText = game->getMoveText();
+        for ( std::size_t i = 0; i < ACCESSOR_COUNT; ++i )
+        {
+            ACCESSORS[i](*game);
+        }
+        BOOST_CHECK_EQUAL(pgn::IParser::isGameValid(game), pgn::seValid);
+        BOOST_CHECK_EQUAL(errors.getCount(), 1u);
+        BOOST_CHECK(game->getMove(1) == move);
+        BOOST_CHECK(game->getMoveText() == moveText);
+        game->release();
+    }
+}
+
+/* A game keeps its data after the parser is released, errors aren't
+ * reported any more. */
+BOOST_AUTO_TEST_CASE(game_outlives_parser)
+{
+    ErrorCounter errors;
+    boost::intrusive_ptr<pgn::IParser> parser(
+        pgn::IParser::create(PGN_PATH, true));
+    BOOST_REQUIRE(parser);
+    parser->setErrorHandler(&errors);
+    pgn::IGame const* const game = parser->readGame(1);
+    BOOST_REQUIRE(game != NULL);
+    parser.reset();
+
+    for ( std::size_t i = 0; i < ACCESSOR_COUNT; ++i )
+    {
+        ACCESSORS[i](*game);
+    }
+    pgn::IMove const* const move = game->getMove(4);
+    BOOST_REQUIRE(move != NULL);
+    BOOST_REQUIRE_EQUAL(game->getVariationCount(move), 1u);
+    pgn::IMove const* const d6 = game->getMove(1,
+        game->getVariation(move, 1));
+    BOOST_REQUIRE(d6 != NULL);
+    BOOST_CHECK_EQUAL(d6->getSAN(), "d6");
+    BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+    game->release();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/move.hpp>
+#include <pgn/parallel_parser.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+unsigned const GAME_COUNT = 500;
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "parallel_parser_test.pgn";
+
+/* Knights go forth and back, thus any number of moves is legal. */
+char const* const SHUFFLE[] = { "Nf3", "Nf6", "Ng1", "Ng8" };
+
+/* Some games are much longer than others, thus workers finish them out of
+ * order. */
+std::string makePgn()
+{
+    std::string pgn;
+    for ( unsigned n = 1; n <= GAME_COUNT; ++n )
+    {
+        char tagPairs[64];
+        std::sprintf(tagPairs, "[Event \"game %u\"]\n\n", n);
+        pgn += tagPairs;
+        unsigned const moveCount = ( n % 37 == 0 ) ? 200 : 1;
+        for ( unsigned i = 1; i <= moveCount; ++i )
+        {
+            pgn += SHUFFLE[( i - 1 ) % 4];
+            pgn += ' ';
+        }
+        pgn += "*\n\n";
+    }
+
+    return pgn;
+}
+
+void checkGame(pgn::IGame const* game)
+{
+    unsigned const n = game->getSequenceNumber();
+    char event[32];
+    std::sprintf(event, "game %u", n);
+    BOOST_CHECK_EQUAL(game->getTagEvent(), event);
+    unsigned const moveCount = game->getMoveCount(pgn::MAIN_LINE);
+    BOOST_CHECK_EQUAL(moveCount, ( n % 37 == 0 ) ? 200u : 1u);
+    for ( unsigned i = 1; i <= moveCount; ++i )
+    {
+        pgn::IMove const* const move = game->getMove(i, pgn::MAIN_LINE);
+        BOOST_REQUIRE(move != NULL);
+        BOOST_CHECK_EQUAL(move->getSAN(), SHUFFLE[( i - 1 ) % 4]);
+        BOOST_CHECK_EQUAL(pgn::IGame::isMoveValid(move), pgn::seValid);
+    }
+}
+
+struct ParallelParserFixture
+{
+    ParallelParserFixture()
+    {
+        std::string const pgn = makePgn();
+        std::FILE* const file = std::fopen(PGN_PATH, "wb");
+        BOOST_REQUIRE(file != NULL);
+        BOOST_REQUIRE_EQUAL(std::fwrite(pgn.data(), 1, pgn.size(), file),
+            pgn.size());
+        std::fclose(file);
+    }
+
+    ~ParallelParserFixture()
+    {
+        std::remove(PGN_PATH);
+    }
+
+    /* The parser is released by the caller, it is kept by the parallel
+     * parser. */
+    boost::intrusive_ptr<pgn::IParallelParser> create(
+        pgn::delivery_order_t order, unsigned threadCount)
+    {
+        boost::intrusive_ptr<pgn::IParser> const parser(
+            pgn::IParser::create(PGN_PATH));
+        BOOST_REQUIRE(parser);
+        boost::intrusive_ptr<pgn::IParallelParser> const parallelParser(
+            pgn::IParallelParser::create(parser.get(), order, threadCount));
+        BOOST_REQUIRE(parallelParser);
+        return parallelParser;
+    }
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(parallel_parser, ParallelParserFixture)
+
+BOOST_AUTO_TEST_CASE(games_are_delivered_in_file_order)
+{
+    unsigned const threadCounts[] = { 1, 2, 4 };
+    for ( std::size_t i = 0;
+        i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i )
+    {
+        BOOST_TEST_CHECKPOINT(threadCounts[i] << " threads");
+        boost::intrusive_ptr<pgn::IParallelParser> const parallelParser =
+            create(pgn::doFileOrder, threadCounts[i]);
+        for ( unsigned n = 1; n <= GAME_COUNT; ++n )
+        {
+            pgn::IGame const* const game = parallelParser->readGame();
+            BOOST_REQUIRE(game != NULL);
+            BOOST_REQUIRE_EQUAL(game->getSequenceNumber(), n);
+            checkGame(game);
+            game->release();
+        }
+        BOOST_CHECK(parallelParser->readGame() == NULL);
+        BOOST_CHECK(parallelParser->readGame() == NULL);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(each_game_is_delivered_once)
+{
+    boost::intrusive_ptr<pgn::IParallelParser> const parallelParser =
+        create(pgn::doReadyOrder, 4);
+    std::vector<bool> isDelivered(GAME_COUNT + 1, false);
+    pgn::IGame const* game;
+    while ( ( game = parallelParser->readGame() ) != NULL )
+    {
+        unsigned const n = game->getSequenceNumber();
+        BOOST_REQUIRE(n >= 1 && n <= GAME_COUNT);
+        BOOST_CHECK_MESSAGE(!isDelivered[n], "game " << n);
+        isDelivered[n] = true;
+        checkGame(game);
+        game->release();
+    }
+    BOOST_CHECK(std::count(isDelivered.begin() + 1, isDelivered.end(),
+        true) == static_cast<std::ptrdiff_t>(GAME_COUNT));
+}
+
+/* Games which are parsed ahead are dropped. */
+BOOST_AUTO_TEST_CASE(cancelled_parser_returns_no_games)
+{
+    boost::intrusive_ptr<pgn::IParallelParser> const parallelParser =
+        create(pgn::doFileOrder, 2);
+    for ( unsigned n = 1; n <= 10; ++n )
+    {
+        pgn::IGame const* const game = parallelParser->readGame();
+        BOOST_REQUIRE(game != NULL);
+        BOOST_CHECK_EQUAL(game->getSequenceNumber(), n);
+        game->release();
+    }
+    parallelParser->cancel();
+    BOOST_CHECK(parallelParser->readGame() == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
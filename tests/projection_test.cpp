@@ -0,0 +1,239 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/move.hpp>
+#include <pgn/parser.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace
+{
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "projection_test.pgn";
+
+/* Castling with zeros in the variation is reported in strict mode if the
+ * variation is parsed. */
+char const PGN[] =
+    "[Event \"projected\"]\n[Site \"?\"]\n[White \"A\"]\n[Result \"1-0\"]\n\n"
+    "1. e4 {best} $1 e5 (1... c5 {sicilian} $2 (1... e6) 2. Nf3 d6 3. d4 "
+    "cxd4 4. Nxd4 Nf6 5. Nc3 a6 6. Be2 e5 7. Nb3 Be7 8. 0-0) 2. Nf3 $3 "
+    "1-0\n";
+
+class ErrorCounter : public pgn::IErrorHandlerCallback
+{
+public:
+    ErrorCounter() : m_count(0) {}
+
+    unsigned addRef() const { return 1; }
+    unsigned release() const { return 1; }
+
+    bool operator()(bool /* isCritical */, pgn::syntax_error_t /* code */,
+        wchar_t const* /* description */, unsigned long long /* line */,
+        unsigned /* column */)
+    {
+        ++m_count;
+        return true;
+    }
+
+    unsigned getCount() const { return m_count; }
+
+private:
+    unsigned m_count;
+};
+
+/* Parts of the game which are present, e.g. "Event,Site,White,Result
+ * moves:3 variations:3 comments:2 nags:3 1-0". */
+std::string describe(pgn::IGame const* game)
+{
+    std::string parts;
+    for ( unsigned n = 1; n <= game->getTagPairCount(); ++n )
+    {
+        parts += ( n != 1 ? "," : "" );
+        parts += game->getTagPair(n).name;
+    }
+
+    unsigned comments = 0;
+    unsigned nags = 0;
+    for ( pgn::variation_t v = 0; v < game->getVariationCount(); ++v )
+    {
+        for ( unsigned n = 1; n <= game->getMoveCount(v); ++n )
+        {
+            pgn::IMove const* const move = game->getMove(n, v);
+            comments += ( move->getComment() != NULL ) ? 1 : 0;
+            nags += move->getNAGs(NULL, 0);
+        }
+    }
+
+    static char const* const RESULTS[] = { "1-0", "0-1", "1/2-1/2", "*" };
+    char counts[128];
+    std::sprintf(counts, " moves:%u variations:%u comments:%u nags:%u %s",
+        game->getMoveCount(pgn::MAIN_LINE), game->getVariationCount(),
+        comments, nags, RESULTS[game->getResult()]);
+    return parts + counts;
+}
+
+std::string readGame(pgn::IParser& parser)
+{
+    pgn::IGame const* const game = parser.readGame(1);
+    BOOST_REQUIRE(game != NULL);
+    std::string const parts = describe(game);
+    game->release();
+    return parts;
+}
+
+class Fixture
+{
+public:
+    Fixture() : parser(NULL)
+    {
+        std::FILE* const file = std::fopen(PGN_PATH, "wb");
+        BOOST_REQUIRE(file != NULL);
+        BOOST_REQUIRE_EQUAL(std::fwrite(PGN, 1, std::strlen(PGN), file),
+            std::strlen(PGN));
+        std::fclose(file);
+        parser = pgn::IParser::create(PGN_PATH, true);
+        BOOST_REQUIRE(parser);
+        parser->setErrorHandler(&errors);
+    }
+
+    ~Fixture()
+    {
+        parser.reset();
+        std::remove(PGN_PATH);
+    }
+
+    ErrorCounter errors;
+    boost::intrusive_ptr<pgn::IParser> parser;
+};
+
+/* It switches the projection until it is stopped. */
+void switchProjection(pgn::IParser* parser, bool const volatile* isStopped)
+{
+    for ( unsigned i = 0; !*isStopped; ++i )
+    {
+        parser->setProjection(NULL, ( i % 2 == 0 ) ? pgn::gpMoves :
+            pgn::gpAll);
+        boost::this_thread::yield();
+    }
+}
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(projection, Fixture)
+
+BOOST_AUTO_TEST_CASE(complete_game)
+{
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:3 comments:2 nags:3 1-0");
+    BOOST_CHECK_EQUAL(errors.getCount(), 1u);
+
+    parser->setProjection(NULL, pgn::gpAll);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:3 comments:2 nags:3 1-0");
+}
+
+/* Result tag is kept anyway. */
+BOOST_AUTO_TEST_CASE(tags_are_skipped)
+{
+    char const* const tagNames[] = { "White", "Round", NULL };
+    parser->setProjection(tagNames);
+    BOOST_CHECK_EQUAL(readGame(*parser), "White,Result "
+        "moves:3 variations:3 comments:2 nags:3 1-0");
+
+    char const* const noTags[] = { NULL };
+    parser->setProjection(noTags, pgn::gpNone);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Result "
+        "moves:0 variations:1 comments:0 nags:0 1-0");
+}
+
+/* Variations are skipped without tokenizing, thus their errors aren't
+ * reported. */
+BOOST_AUTO_TEST_CASE(parts_of_movetext_are_skipped)
+{
+    parser->setProjection(NULL, pgn::gpMoves);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:1 comments:0 nags:0 1-0");
+    parser->setProjection(NULL, pgn::gpMoves | pgn::gpComments);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:1 comments:1 nags:0 1-0");
+    parser->setProjection(NULL, pgn::gpMoves | pgn::gpNAGs);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:1 comments:0 nags:2 1-0");
+    BOOST_CHECK_EQUAL(errors.getCount(), 0u);
+
+    parser->setProjection(NULL, pgn::gpMoves | pgn::gpVariations);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:3 comments:0 nags:0 1-0");
+    BOOST_CHECK_EQUAL(errors.getCount(), 1u);
+
+    /* Other parts require moves. */
+    parser->setProjection(NULL, pgn::gpVariations | pgn::gpComments |
+        pgn::gpNAGs);
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:0 variations:1 comments:0 nags:0 1-0");
+}
+
+/* The movetext is parsed with the projection of the time when the game was
+ * read. */
+BOOST_AUTO_TEST_CASE(projection_is_kept_by_game)
+{
+    parser->setProjection(NULL, pgn::gpMoves);
+    pgn::IGame const* const game = parser->readGame(1);
+    BOOST_REQUIRE(game != NULL);
+    parser->setProjection(NULL, pgn::gpAll);
+    BOOST_CHECK_EQUAL(describe(game), "Event,Site,White,Result "
+        "moves:3 variations:1 comments:0 nags:0 1-0");
+    game->release();
+
+    BOOST_CHECK_EQUAL(readGame(*parser), "Event,Site,White,Result "
+        "moves:3 variations:3 comments:2 nags:3 1-0");
+}
+
+/* Each game is built with one projection while it is switched by another
+ * thread. */
+BOOST_AUTO_TEST_CASE(projection_is_switched_by_another_thread)
+{
+    std::string const complete = "Event,Site,White,Result "
+        "moves:3 variations:3 comments:2 nags:3 1-0";
+    std::string const movesOnly = "Event,Site,White,Result "
+        "moves:3 variations:1 comments:0 nags:0 1-0";
+    bool volatile isStopped = false;
+    boost::thread thread(switchProjection, parser.get(), &isStopped);
+    for ( unsigned i = 0; i < 2000; ++i )
+    {
+        std::string const parts = readGame(*parser);
+        if ( parts != complete && parts != movesOnly )
+        {
+            BOOST_ERROR("a game is built with two projections: " << parts);
+            break;
+        }
+    }
+    isStopped = true;
+    thread.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/parser.hpp>
+
+#include <cstdio>
+#include <string>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+unsigned const GAME_COUNT = 5;
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "read_games_test.pgn";
+
+class Fixture
+{
+public:
+    Fixture()
+    {
+        std::FILE* const file = std::fopen(PGN_PATH, "wb");
+        BOOST_REQUIRE(file != NULL);
+        for ( unsigned n = 1; n <= GAME_COUNT; ++n )
+        {
+            std::fprintf(file, "[Event \"game %u\"]\n\n1. e4 *\n\n", n);
+        }
+        std::fclose(file);
+        parser = pgn::IParser::create(PGN_PATH);
+        BOOST_REQUIRE(parser);
+    }
+
+    ~Fixture()
+    {
+        parser.reset();
+        std::remove(PGN_PATH);
+    }
+
+    /* Read games by readGames() and release them. The method returns their
+     * numbers, e.g. "2 3 4". */
+    std::string readGames(unsigned firstGame, unsigned count)
+    {
+        IGameArray games;
+        unsigned const readCount = parser->readGames(firstGame, count,
+            games);
+        BOOST_REQUIRE(readCount <= count && readCount <= GAME_COUNT);
+        std::string numbers;
+        for ( unsigned i = 0; i < readCount; ++i )
+        {
+            numbers += ( i != 0 ? " " : "" ) + getNumber(games[i]);
+            games[i]->release();
+        }
+
+        return numbers;
+    }
+
+    /* Read a game by readGame(), "-" if there is no game. */
+    std::string readGame(unsigned gameN = pgn::NEXT_ITEM)
+    {
+        pgn::IGame const* const game = parser->readGame(gameN);
+        if ( game == NULL )
+        {
+            return "-";
+        }
+
+        std::string const number = getNumber(game);
+        game->release();
+        return number;
+    }
+
+    boost::intrusive_ptr<pgn::IParser> parser;
+
+private:
+    /* No more games than the file has are returned, thus the array is
+     * enough for any count. */
+    typedef pgn::IGame const* IGameArray[GAME_COUNT];
+
+    /* The number is checked against the event of the game. */
+    static std::string getNumber(pgn::IGame const* game)
+    {
+        char number[16];
+        std::sprintf(number, "%u", game->getSequenceNumber());
+        BOOST_CHECK_EQUAL(game->getTagEvent(), "game " + std::string(number));
+        return number;
+    }
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(read_games, Fixture)
+
+BOOST_AUTO_TEST_CASE(consecutive_games)
+{
+    BOOST_CHECK_EQUAL(readGames(2, 3), "2 3 4");
+    BOOST_CHECK_EQUAL(readGames(1, 1), "1");
+    BOOST_CHECK_EQUAL(readGames(1, GAME_COUNT), "1 2 3 4 5");
+    BOOST_CHECK_EQUAL(readGames(3, 0), "");
+}
+
+/* readGames(NEXT_ITEM, ...) continues from readGame() and vice versa. */
+BOOST_AUTO_TEST_CASE(next_item_cursor)
+{
+    BOOST_CHECK_EQUAL(readGame(), "1");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, 2), "2 3");
+    BOOST_CHECK_EQUAL(readGame(), "4");
+
+    BOOST_CHECK_EQUAL(readGame(2), "2");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, 1), "3");
+    BOOST_CHECK_EQUAL(readGames(1, 2), "1 2");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, 2), "3 4");
+
+    /* The cursor is moved to the game after the requested ones. */
+    BOOST_CHECK_EQUAL(readGames(2, 0), "");
+    BOOST_CHECK_EQUAL(readGame(), "2");
+}
+
+BOOST_AUTO_TEST_CASE(short_read_at_eof)
+{
+    BOOST_CHECK_EQUAL(readGames(4, 3), "4 5");
+    BOOST_CHECK_EQUAL(readGame(), "-");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, 2), "");
+    BOOST_CHECK_EQUAL(readGames(GAME_COUNT + 1, 2), "");
+    BOOST_CHECK_EQUAL(readGames(GAME_COUNT, 2), "5");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, 1), "");
+}
+
+/* The count is clamped, thus the cursor doesn't wrap around to the first
+ * game. */
+BOOST_AUTO_TEST_CASE(count_is_clamped)
+{
+    unsigned const maxCount = static_cast<unsigned>(-1);
+    BOOST_CHECK_EQUAL(readGames(3, maxCount), "3 4 5");
+    BOOST_CHECK_EQUAL(readGame(), "-");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, maxCount), "");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, 1), "");
+
+    BOOST_CHECK_EQUAL(readGame(1), "1");
+    BOOST_CHECK_EQUAL(readGames(pgn::NEXT_ITEM, maxCount), "2 3 4 5");
+    BOOST_CHECK_EQUAL(readGame(), "-");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
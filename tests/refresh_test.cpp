@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pgn/game.hpp>
+#include <pgn/parser.hpp>
+
+#include <cstdio>
+#include <string>
+
+#include <boost/intrusive_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace
+{
+
+/* The file is created in the working directory of the test. */
+char const PGN_PATH[] = "refresh_test.pgn";
+
+/* Notifications of the watcher come after 50 ms without modifications. */
+unsigned const TIMEOUT = 2000; /* ms */
+
+void writeFile(char const* mode, char const* text)
+{
+    std::FILE* const file = std::fopen(PGN_PATH, mode);
+    BOOST_REQUIRE(file != NULL);
+    std::fputs(text, file);
+    std::fclose(file);
+}
+
+/* Notifications are logged like "appended:2+3 rewritten:1+2". */
+class ChangeLog : public pgn::IFileChangeCallback
+{
+public:
+    unsigned addRef() const { return 1; }
+    unsigned release() const { return 1; }
+
+    void operator()(bool isRewritten, unsigned firstGame, unsigned gameCount)
+    {
+        char entry[64];
+        std::sprintf(entry, "%s%s:%u+%u", m_log.empty() ? "" : " ",
+            isRewritten ? "rewritten" : "appended", firstGame, gameCount);
+        boost::mutex::scoped_lock lock(m_lock);
+        m_log += entry;
+        m_changed.notify_all();
+    }
+
+    /* The method returns the log after the notification or after the
+     * timeout. */
+    std::string waitFor(std::string const& log)
+    {
+        boost::system_time const deadline = boost::get_system_time() +
+            boost::posix_time::milliseconds(TIMEOUT);
+        boost::mutex::scoped_lock lock(m_lock);
+        while ( m_log != log && m_changed.timed_wait(lock, deadline) )
+        {
+        }
+        return m_log;
+    }
+
+private:
+    boost::mutex m_lock;
+    boost::condition_variable m_changed;
+    std::string m_log;
+};
+
+class Fixture
+{
+public:
+    Fixture()
+    {
+        writeFile("wb", "[Event \"game 1\"]\n\n1. e4 *\n\n"
+            "[Event \"game 2\"]\n\n1. d4 *\n\n");
+    }
+
+    ~Fixture()
+    {
+        std::remove(PGN_PATH);
+    }
+
+    static std::string getEvent(pgn::IParser& parser, unsigned gameN)
+    {
+        pgn::IGame const* const game = parser.readGame(gameN);
+        if ( game == NULL )
+        {
+            return "-";
+        }
+
+        std::string const event = game->getTagEvent();
+        game->release();
+        return event;
+    }
+};
+
+} /* unnamed namespace */
+
+BOOST_FIXTURE_TEST_SUITE(refresh, Fixture)
+
+BOOST_AUTO_TEST_CASE(unchanged_file)
+{
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false));
+    BOOST_REQUIRE(parser);
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+    BOOST_CHECK(parser->refresh());
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+    BOOST_CHECK_EQUAL(getEvent(*parser, 2), "game 2");
+}
+
+/* Numbers of games which were read before stay the same. */
+BOOST_AUTO_TEST_CASE(games_are_appended)
+{
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false));
+    BOOST_REQUIRE(parser);
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+    BOOST_CHECK_EQUAL(getEvent(*parser, 3), "-");
+
+    writeFile("ab", "[Event \"game 3\"]\n\n1. c4 *\n\n"
+        "[Event \"game 4\"]\n\n1. f4 *\n\n");
+    BOOST_CHECK(parser->refresh());
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 4u);
+    BOOST_CHECK_EQUAL(getEvent(*parser, 1), "game 1");
+    BOOST_CHECK_EQUAL(getEvent(*parser, 3), "game 3");
+    BOOST_CHECK_EQUAL(getEvent(*parser, 4), "game 4");
+}
+
+/* The last game is scanned again, new moves can be appended to it. */
+BOOST_AUTO_TEST_CASE(last_game_is_continued)
+{
+    writeFile("wb", "[Event \"game 1\"]\n\n1. e4 *\n\n"
+        "[Event \"game 2\"]\n\n1. d4");
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false));
+    BOOST_REQUIRE(parser);
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+
+    writeFile("ab", " d5 2. c4 *\n\n");
+    BOOST_CHECK(parser->refresh());
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+    pgn::IGame const* const game = parser->readGame(2);
+    BOOST_REQUIRE(game != NULL);
+    BOOST_CHECK_EQUAL(game->getMoveCount(pgn::MAIN_LINE), 3u);
+    game->release();
+}
+
+/* Nothing from the index is used, games are found again. */
+BOOST_AUTO_TEST_CASE(file_is_rewritten)
+{
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false));
+    BOOST_REQUIRE(parser);
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+
+    writeFile("wb", "[Event \"other 1\"]\n\n1. Nf3 *\n\n"
+        "[Event \"other 2\"]\n\n1. b3 *\n\n[Event \"other 3\"]\n\n1. g3 *\n");
+    BOOST_CHECK(!parser->refresh());
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 3u);
+    BOOST_CHECK_EQUAL(getEvent(*parser, 1), "other 1");
+    BOOST_CHECK_EQUAL(getEvent(*parser, 3), "other 3");
+}
+
+BOOST_AUTO_TEST_CASE(file_is_removed)
+{
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false));
+    BOOST_REQUIRE(parser);
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+
+    BOOST_REQUIRE(std::remove(PGN_PATH) == 0);
+    BOOST_CHECK(!parser->refresh());
+
+    writeFile("wb", "[Event \"game 1\"]\n\n1. e4 *\n\n");
+    BOOST_CHECK(!parser->refresh());
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 1u);
+}
+
+/* The index is updated by the watcher, the handler gets new games. */
+BOOST_AUTO_TEST_CASE(file_is_watched)
+{
+    ChangeLog changes;
+    boost::intrusive_ptr<pgn::IParser> const parser(
+        pgn::IParser::create(PGN_PATH, false, pgn::poWatchFile));
+    BOOST_REQUIRE(parser);
+    parser->setFileChangeHandler(&changes);
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 2u);
+
+    writeFile("ab", "[Event \"game 3\"]\n\n1. c4 *\n\n");
+    BOOST_CHECK_EQUAL(changes.waitFor("appended:2+2"), "appended:2+2");
+    BOOST_CHECK_EQUAL(parser->getGameCount(), 3u);
+    BOOST_CHECK_EQUAL(getEvent(*parser, 3), "game 3");
+
+    writeFile("wb", "[Event \"other 1\"]\n\n1. Nf3 *\n\n");
+    BOOST_CHECK_EQUAL(changes.waitFor("appended:2+2 rewritten:1+1"),
+        "appended:2+2 rewritten:1+1");
+    BOOST_CHECK_EQUAL(getEvent(*parser, 1), "other 1");
+
+    parser->setFileChangeHandler(NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
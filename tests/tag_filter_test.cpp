@@ -0,0 +1,292 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tag_filter.hpp"
+#include "game_scanner.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+pgn::tag_predicate_t makePredicate(char const* name,
+    pgn::tag_predicate_kind_t kind, char const* value,
+    char const* maxValue = NULL, bool isAlternative = false)
+{
+    pgn::tag_predicate_t const predicate =
+        { name, kind, value, maxValue, isAlternative };
+    return predicate;
+}
+
+pgn::tag_predicate_t const END = makePredicate(NULL, pgn::tpEqual, NULL);
+
+/* Check tag pair lines of a game, lines are separated by '\n'. */
+bool isSelected(pgn::TagFilter const& filter, char const* tagPairs)
+{
+    pgn::TagFilter::Matches matches(filter.getPredicateCount(), false);
+    char const* line = tagPairs;
+    char const* const end = tagPairs + std::strlen(tagPairs);
+    while ( line < end )
+    {
+        char const* lineEnd = std::strchr(line, '\n');
+        if ( lineEnd == NULL )
+        {
+            lineEnd = end;
+        }
+        filter.checkTagLine(line, lineEnd, matches);
+        line = lineEnd + 1;
+    }
+
+    return filter.isSelected(matches);
+}
+
+/* A filter with one predicate. */
+bool isSelected(pgn::tag_predicate_t const& predicate, char const* tagPairs)
+{
+    pgn::tag_predicate_t const predicates[] = { predicate, END };
+    return isSelected(pgn::TagFilter(predicates), tagPairs);
+}
+
+} /* unnamed namespace */
+
+BOOST_AUTO_TEST_SUITE(tag_filter)
+
+BOOST_AUTO_TEST_CASE(equal_and_prefix)
+{
+    pgn::tag_predicate_t const equal =
+        makePredicate("White", pgn::tpEqual, "Carlsen, Magnus");
+    BOOST_CHECK(isSelected(equal, "[White \"Carlsen, Magnus\"]"));
+    BOOST_CHECK(!isSelected(equal, "[White \"Carlsen, M\"]"));
+    BOOST_CHECK(!isSelected(equal, "[White \"Carlsen, Magnus Jr\"]"));
+    BOOST_CHECK(!isSelected(equal, "[Black \"Carlsen, Magnus\"]"));
+    BOOST_CHECK(!isSelected(equal, "[Event \"?\"]"));
+
+    pgn::tag_predicate_t const prefix =
+        makePredicate("White", pgn::tpPrefix, "Carlsen");
+    BOOST_CHECK(isSelected(prefix, "[White \"Carlsen, Magnus\"]"));
+    BOOST_CHECK(isSelected(prefix, "[White \"Carlsen\"]"));
+    BOOST_CHECK(!isSelected(prefix, "[White \"Carl\"]"));
+}
+
+/* Values are unescaped, spaces inside brackets are allowed. */
+BOOST_AUTO_TEST_CASE(tag_pair_syntax)
+{
+    pgn::tag_predicate_t const equal =
+        makePredicate("Event", pgn::tpEqual, "The \"Cup\" \\ 1");
+    BOOST_CHECK(isSelected(equal, "[Event \"The \\\"Cup\\\" \\\\ 1\"]"));
+    BOOST_CHECK(isSelected(equal,
+        "[ Event   \"The \\\"Cup\\\" \\\\ 1\" ]"));
+    BOOST_CHECK(!isSelected(equal, "[Event \"The \\\"Cup\\\"\"]"));
+
+    /* Several tag pairs in a line. */
+    pgn::tag_predicate_t const site =
+        makePredicate("Site", pgn::tpEqual, "Oslo");
+    BOOST_CHECK(isSelected(site, "[Event \"x\"] [Site \"Oslo\"]"));
+
+    /* The first value of a duplicated tag is used. */
+    BOOST_CHECK(isSelected(site, "[Site \"Oslo\"]\n[Site \"Bergen\"]"));
+}
+
+BOOST_AUTO_TEST_CASE(number_range)
+{
+    pgn::tag_predicate_t const range =
+        makePredicate("WhiteElo", pgn::tpNumberRange, "2600", "2700");
+    BOOST_CHECK(isSelected(range, "[WhiteElo \"2600\"]"));
+    BOOST_CHECK(isSelected(range, "[WhiteElo \"2650\"]"));
+    BOOST_CHECK(isSelected(range, "[WhiteElo \"2700\"]"));
+    BOOST_CHECK(isSelected(range, "[WhiteElo \"+2650\"]"));
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \"2599\"]"));
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \"2701\"]"));
+
+    /* Anything else isn't a number. */
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \"\"]"));
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \"-\"]"));
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \"?\"]"));
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \"2650x\"]"));
+    BOOST_CHECK(!isSelected(range, "[WhiteElo \" 2650\"]"));
+    BOOST_CHECK(!isSelected(range,
+        "[WhiteElo \"2650000000000000000000\"]"));
+}
+
+/* A bound which is NULL or can't be parsed doesn't limit the range. */
+BOOST_AUTO_TEST_CASE(open_number_range)
+{
+    pgn::tag_predicate_t const from =
+        makePredicate("Round", pgn::tpNumberRange, "-5", NULL);
+    BOOST_CHECK(isSelected(from, "[Round \"-5\"]"));
+    BOOST_CHECK(isSelected(from, "[Round \"1000000\"]"));
+    BOOST_CHECK(!isSelected(from, "[Round \"-6\"]"));
+
+    pgn::tag_predicate_t const till =
+        makePredicate("Round", pgn::tpNumberRange, "x", "10");
+    BOOST_CHECK(isSelected(till, "[Round \"-1000\"]"));
+    BOOST_CHECK(isSelected(till, "[Round \"10\"]"));
+    BOOST_CHECK(!isSelected(till, "[Round \"11\"]"));
+}
+
+BOOST_AUTO_TEST_CASE(date_range)
+{
+    pgn::tag_predicate_t const year2023 =
+        makePredicate("Date", pgn::tpDateRange, "2023.01.01", "2023.12.31");
+    BOOST_CHECK(isSelected(year2023, "[Date \"2023.01.01\"]"));
+    BOOST_CHECK(isSelected(year2023, "[Date \"2023.06.15\"]"));
+    BOOST_CHECK(isSelected(year2023, "[Date \"2023.12.31\"]"));
+    BOOST_CHECK(!isSelected(year2023, "[Date \"2022.12.31\"]"));
+    BOOST_CHECK(!isSelected(year2023, "[Date \"2024.01.01\"]"));
+    BOOST_CHECK(!isSelected(year2023, "[Date \"2023-06-15\"]"));
+    BOOST_CHECK(!isSelected(year2023, "[Date \"\"]"));
+
+    /* Unknown parts of the date match any month or day. */
+    BOOST_CHECK(isSelected(year2023, "[Date \"2023.??.??\"]"));
+    BOOST_CHECK(isSelected(year2023, "[Date \"2023.11.??\"]"));
+    BOOST_CHECK(isSelected(year2023, "[Date \"2023\"]"));
+    BOOST_CHECK(!isSelected(year2023, "[Date \"2022.??.??\"]"));
+    BOOST_CHECK(!isSelected(year2023, "[Date \"????.??.??\"]"));
+}
+
+/* Bounds can be partial dates too: the lower one is the first day, the
+ * upper one is the last day. */
+BOOST_AUTO_TEST_CASE(partial_date_bounds)
+{
+    pgn::tag_predicate_t const june =
+        makePredicate("Date", pgn::tpDateRange, "2023.06", "2023.06");
+    BOOST_CHECK(isSelected(june, "[Date \"2023.06.01\"]"));
+    BOOST_CHECK(isSelected(june, "[Date \"2023.06.30\"]"));
+    BOOST_CHECK(!isSelected(june, "[Date \"2023.05.31\"]"));
+    BOOST_CHECK(!isSelected(june, "[Date \"2023.07.01\"]"));
+
+    /* A game of an unknown month of the year can be played in June. */
+    BOOST_CHECK(isSelected(june, "[Date \"2023.??.??\"]"));
+
+    pgn::tag_predicate_t const since =
+        makePredicate("Date", pgn::tpDateRange, "2020", NULL);
+    BOOST_CHECK(isSelected(since, "[Date \"2020.01.01\"]"));
+    BOOST_CHECK(isSelected(since, "[Date \"2999.12.31\"]"));
+    BOOST_CHECK(!isSelected(since, "[Date \"2019.12.31\"]"));
+}
+
+/* "White or Black is X, and Date is in 2023". */
+BOOST_AUTO_TEST_CASE(alternatives)
+{
+    pgn::tag_predicate_t const predicates[] =
+    {
+        makePredicate("White", pgn::tpEqual, "X"),
+        makePredicate("Black", pgn::tpEqual, "X", NULL, true),
+        makePredicate("Date", pgn::tpDateRange, "2023", "2023"),
+        END
+    };
+    pgn::TagFilter const filter(predicates);
+    BOOST_CHECK_EQUAL(filter.getPredicateCount(), 3u);
+
+    BOOST_CHECK(isSelected(filter,
+        "[Date \"2023.05.01\"]\n[White \"X\"]\n[Black \"Y\"]"));
+    BOOST_CHECK(isSelected(filter,
+        "[Date \"2023.05.01\"]\n[White \"Y\"]\n[Black \"X\"]"));
+    BOOST_CHECK(!isSelected(filter,
+        "[Date \"2023.05.01\"]\n[White \"Y\"]\n[Black \"Z\"]"));
+    BOOST_CHECK(!isSelected(filter,
+        "[Date \"2022.05.01\"]\n[White \"X\"]\n[Black \"X\"]"));
+    BOOST_CHECK(!isSelected(filter, "[White \"X\"]"));
+}
+
+BOOST_AUTO_TEST_CASE(empty_filter)
+{
+    pgn::TagFilter const filter(&END);
+    BOOST_CHECK_EQUAL(filter.getPredicateCount(), 0u);
+    BOOST_CHECK(isSelected(filter, "[Event \"?\"]"));
+}
+
+/* Tag pair lines which are split by pieces or chunks of parallel scanning
+ * give the same selection. */
+BOOST_AUTO_TEST_CASE(games_are_selected_by_scanner)
+{
+    std::string pgn;
+    for ( unsigned i = 0; i < 300; ++i )
+    {
+        char tagPairs[128];
+        std::sprintf(tagPairs, "[Event \"%u\"]\n[WhiteElo \"%u\"]\n"
+            "[Date \"20%02u.01.01\"]\n\n", i, 2000 + i * 3, i % 30);
+        pgn += tagPairs;
+        pgn += ( i % 7 == 0 ) ? "1. e4 {\n[WhiteElo \"2500\"]\n} *\n\n" :
+            "1. e4 *\n\n";
+    }
+
+    pgn::tag_predicate_t const predicates[] =
+    {
+        makePredicate("WhiteElo", pgn::tpNumberRange, "2300", "2600"),
+        makePredicate("Date", pgn::tpDateRange, "2010", "2019"),
+        END
+    };
+    pgn::TagFilter const filter(predicates);
+
+    std::size_t const pieceSizes[] = { 0, 1, 13, 4096 };
+    unsigned const threadCounts[] = { 1, 3 };
+    for ( std::size_t i = 0; i < sizeof(pieceSizes) / sizeof(pieceSizes[0]);
+        ++i )
+    {
+        for ( std::size_t j = 0;
+            j < sizeof(threadCounts) / sizeof(threadCounts[0]); ++j )
+        {
+            BOOST_TEST_CHECKPOINT("piece size " << pieceSizes[i] << ", "
+                << threadCounts[j] << " threads");
+            std::size_t const pieceSize = ( pieceSizes[i] != 0 ) ?
+                pieceSizes[i] : pgn.size();
+            pgn::GameScanner scanner;
+            scanner.setFilter(&filter);
+            pgn::GameIndex games;
+            for ( std::size_t offset = 0; offset < pgn.size();
+                offset += pieceSize )
+            {
+                std::size_t const size = std::min(pieceSize,
+                    pgn.size() - offset);
+                if ( threadCounts[j] > 1 )
+                {
+                    scanner.scanInParallel(pgn.data() + offset, size,
+                        threadCounts[j], games);
+                } else
+                {
+                    scanner.scan(pgn.data() + offset, size, games);
+                }
+            }
+            scanner.finish(games);
+
+            BOOST_REQUIRE_EQUAL(games.size(), 300u);
+            std::size_t selectedCount = 0;
+            for ( unsigned n = 0; n < 300; ++n )
+            {
+                unsigned const elo = 2000 + n * 3;
+                bool const isExpected = elo >= 2300 && elo <= 2600 &&
+                    n % 30 >= 10 && n % 30 <= 19;
+                BOOST_CHECK_EQUAL(games[n].isSelected, isExpected);
+                if ( isExpected )
+                {
+                    BOOST_CHECK_EQUAL(games.getSelected(selectedCount), n);
+                    ++selectedCount;
+                }
+            }
+            BOOST_CHECK_EQUAL(games.getSelectedCount(), selectedCount);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,205 @@
+/**
+ * Copyright (C) 2010-2012 Nikita Manovich <nikita.manovich@gmail.com>
+ *
+ * This file is part of C++ PGN parser, http://code.google.com/p/pgnparser-cpp
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tokenizer.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+
+char const* const TYPE_NAMES[] =
+{
+    "[", "]", "string", "symbol", "number", "nag", "comment", "(", ")",
+    "end-of-game", "illegal", "end"
+};
+
+/* Tokens of the data as "type:text" separated by spaces, e.g.
+ * "symbol:e4 nag:!". Tokenizing stops at the first ttEnd. */
+std::string tokenize(std::string const& data)
+{
+    pgn::Tokenizer tokenizer(data.data(), data.size());
+    std::string tokens;
+    pgn::Token token;
+    do
+    {
+        tokenizer.next(token);
+        BOOST_REQUIRE(token.offset + token.length <= data.size());
+        tokens += ( tokens.empty() ? "" : " " );
+        tokens += TYPE_NAMES[token.type];
+        if ( token.length != 0 )
+        {
+            tokens += ':' + data.substr(token.offset, token.length);
+        }
+    } while ( token.type != pgn::ttEnd );
+
+    return tokens;
+}
+
+/* Skip the variation which follows the first '(' of the data. The method
+ * returns offset of the token after the variation and the rest of tokens
+ * in the tokens. */
+std::size_t skipVariation(std::string const& data, std::string& tokens)
+{
+    pgn::Tokenizer tokenizer(data.data(), data.size());
+    pgn::Token token;
+    do
+    {
+        tokenizer.next(token);
+    } while ( token.type != pgn::ttRavBegin && token.type != pgn::ttEnd );
+    BOOST_REQUIRE(token.type == pgn::ttRavBegin);
+
+    tokenizer.skipVariation(token);
+    std::size_t const offset = token.offset;
+    tokens = TYPE_NAMES[token.type];
+    while ( token.type != pgn::ttEnd )
+    {
+        tokenizer.next(token);
+        tokens += std::string(" ") + TYPE_NAMES[token.type];
+    }
+
+    return offset;
+}
+
+} /* unnamed namespace */
+
+BOOST_AUTO_TEST_SUITE(tokenizer)
+
+BOOST_AUTO_TEST_CASE(token_types)
+{
+    BOOST_CHECK_EQUAL(tokenize("[Event \"Open\"]\n"),
+        "[:[ symbol:Event string:Open ]:] end");
+    BOOST_CHECK_EQUAL(tokenize("1. e4 e5 2.Nf3 Nc6 3... a6 *"),
+        "number:1. symbol:e4 symbol:e5 number:2. symbol:Nf3 symbol:Nc6 "
+        "number:3... symbol:a6 end-of-game:* end");
+    BOOST_CHECK_EQUAL(tokenize("e8=Q+ O-O-O# exd5 Rxa1 0-0"),
+        "symbol:e8=Q+ symbol:O-O-O# symbol:exd5 symbol:Rxa1 symbol:0-0 end");
+    BOOST_CHECK_EQUAL(tokenize("(e4 (d4)) $12 ! ?? !? $"),
+        "(:( symbol:e4 (:( symbol:d4 ):) ):) nag:$12 nag:! nag:?? nag:!? "
+        "illegal:$ end");
+    BOOST_CHECK_EQUAL(tokenize("e4!!! Nf3?"),
+        "symbol:e4 nag:!! nag:! symbol:Nf3 nag:? end");
+    BOOST_CHECK_EQUAL(tokenize("1-0 0-1 1/2-1/2 * 1-01"),
+        "end-of-game:1-0 end-of-game:0-1 end-of-game:1/2-1/2 end-of-game:* "
+        "symbol:1-01 end");
+    BOOST_CHECK_EQUAL(tokenize("e4 & e5 <x>"),
+        "symbol:e4 illegal:& symbol:e5 illegal:< symbol:x illegal:> end");
+}
+
+BOOST_AUTO_TEST_CASE(move_numbers_and_periods)
+{
+    /* Periods without number are skipped, a number at the end of data is
+     * a move number. */
+    BOOST_CHECK_EQUAL(tokenize("12 12. 12.. ... e4. 7"),
+        "number:12 number:12. number:12.. symbol:e4 number:7 end");
+    BOOST_CHECK_EQUAL(tokenize("12.e4 12...e5"),
+        "number:12. symbol:e4 number:12... symbol:e5 end");
+}
+
+BOOST_AUTO_TEST_CASE(end_is_repeated)
+{
+    std::string const data = "e4  \n";
+    pgn::Tokenizer tokenizer(data.data(), data.size());
+    pgn::Token token;
+    tokenizer.next(token);
+    BOOST_CHECK_EQUAL(token.type, pgn::ttSymbol);
+    for ( int i = 0; i < 3; ++i )
+    {
+        tokenizer.next(token);
+        BOOST_CHECK_EQUAL(token.type, pgn::ttEnd);
+        BOOST_CHECK_EQUAL(token.offset, data.size());
+        BOOST_CHECK_EQUAL(token.length, 0u);
+    }
+
+    BOOST_CHECK_EQUAL(tokenize(""), "end");
+    BOOST_CHECK_EQUAL(tokenize(" \t\r\n\v\f"), "end");
+}
+
+BOOST_AUTO_TEST_CASE(strings_with_escapes)
+{
+    /* Escaped characters aren't decoded. */
+    BOOST_CHECK_EQUAL(tokenize("\"a \\\"b\\\" c\" x"),
+        "string:a \\\"b\\\" c symbol:x end");
+    BOOST_CHECK_EQUAL(tokenize("\"\\\\\" x"), "string:\\\\ symbol:x end");
+    BOOST_CHECK_EQUAL(tokenize("\"\" x"), "string symbol:x end");
+    BOOST_CHECK_EQUAL(tokenize("\"{;(\" x"), "string:{;( symbol:x end");
+
+    /* An unterminated string takes the rest of data (its offset is at the
+     * quote), an escape can't go past the end. */
+    BOOST_CHECK_EQUAL(tokenize("x \"abc"), "symbol:x illegal:\"abc end");
+    BOOST_CHECK_EQUAL(tokenize("x \"abc\\\""), "symbol:x illegal:\"abc\\\" "
+        "end");
+    BOOST_CHECK_EQUAL(tokenize("x \"abc\\"), "symbol:x illegal:\"abc\\ end");
+}
+
+BOOST_AUTO_TEST_CASE(comments)
+{
+    BOOST_CHECK_EQUAL(tokenize("e4 {a good\nmove; \"really\"} e5"),
+        "symbol:e4 comment:a good\nmove; \"really\" symbol:e5 end");
+    BOOST_CHECK_EQUAL(tokenize("{} {\\}"), "comment comment:\\ end");
+
+    /* A rest of line comment doesn't include the end of line. */
+    BOOST_CHECK_EQUAL(tokenize("e4 ; best {by test}\r\ne5"),
+        "symbol:e4 comment: best {by test} symbol:e5 end");
+    BOOST_CHECK_EQUAL(tokenize("e4 ;\ne5 ;x"),
+        "symbol:e4 comment symbol:e5 comment:x end");
+
+    BOOST_CHECK_EQUAL(tokenize("e4 {never closed"),
+        "symbol:e4 illegal:{never closed end");
+}
+
+BOOST_AUTO_TEST_CASE(escaped_lines)
+{
+    /* '%' escapes a line only at its beginning. */
+    BOOST_CHECK_EQUAL(tokenize("%skip [\"\ne4\n%{\n% x"), "symbol:e4 end");
+    BOOST_CHECK_EQUAL(tokenize("e4 ;x\n%skip\ne5"),
+        "symbol:e4 comment:x symbol:e5 end");
+    BOOST_CHECK_EQUAL(tokenize("e4 %x"), "symbol:e4 illegal:% symbol:x end");
+}
+
+BOOST_AUTO_TEST_CASE(variations_are_skipped)
+{
+    std::string tokens;
+    std::string const nested = "1. e4 (1. d4 (1. c4) d5) e5 *";
+    BOOST_CHECK_EQUAL(skipVariation(nested, tokens), nested.find(") e5"));
+    BOOST_CHECK_EQUAL(tokens, ") symbol end-of-game end");
+
+    /* Parentheses in comments and escaped lines don't count, strings
+     * aren't recognized. */
+    std::string const comments = "e4 ({)} ;)\n%)\nd4 ) e5";
+    BOOST_CHECK_EQUAL(skipVariation(comments, tokens),
+        comments.find(") e5"));
+    BOOST_CHECK_EQUAL(tokens, ") symbol end");
+    std::string const strings = "e4 (\")\" ) e5";
+    BOOST_CHECK_EQUAL(skipVariation(strings, tokens), strings.find(")\""));
+    BOOST_CHECK_EQUAL(tokens, ") illegal end");
+
+    /* Unclosed variations and comments take the rest of data. */
+    std::string const unclosed = "e4 (d4 (c4) e5";
+    BOOST_CHECK_EQUAL(skipVariation(unclosed, tokens), unclosed.size());
+    BOOST_CHECK_EQUAL(tokens, "end");
+    std::string const comment = "e4 (d4 {) e5";
+    BOOST_CHECK_EQUAL(skipVariation(comment, tokens), comment.size());
+    BOOST_CHECK_EQUAL(tokens, "end");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -18,6 +18,8 @@
  */
 
 #include <pgn/parser.hpp>
+#include <pgn/game.hpp>
+#include <pgn/move.hpp>
 
 #include <cstdlib>
 #include <iostream>
@@ -26,10 +28,105 @@
 #ifdef _WIN32
 #define ucerr wcerr
 #define _U(X) L##X
-int wmain(int argc, wchar_t* argv[])
 #else
 #define ucerr cerr
 #define _U(X) X
+#endif
+
+namespace
+{
+
+/* Syntax errors are printed, processing of the file is continued. */
+class ErrorPrinter : public pgn::IErrorHandlerCallback
+{
+public:
+    unsigned addRef() const { return 1; }
+    unsigned release() const { return 1; }
+
+    bool operator()(bool isCritical, pgn::syntax_error_t code,
+        wchar_t const* description, unsigned long long line, unsigned column)
+    {
+        std::wcerr << ( isCritical ? L"Error" : L"Warning" ) << L" (" <<
+            static_cast<int>(code) << L") at " << line << L":" << column <<
+            L": " << description << std::endl;
+        return true;
+    }
+};
+
+/* The first move of a variation is an alternative to its parent move, thus
+ * they are made by the same side. */
+void dumpVariation(pgn::IGame const* game, pgn::variation_t v, bool isWhite)
+{
+    bool isNumberNeeded = true;
+    for ( unsigned n = 1; n <= game->getMoveCount(v); ++n )
+    {
+        pgn::IMove const* move = game->getMove(n, v);
+        if ( n != 1 )
+        {
+            std::cout << ' ';
+        }
+
+        /* Number of black move is printed after a comment or a variation
+         * only. */
+        if ( isWhite )
+        {
+            std::cout << move->getMoveNumber() << ". ";
+        } else if ( isNumberNeeded )
+        {
+            std::cout << move->getMoveNumber() << "... ";
+        }
+        std::cout << move->getSAN();
+        isNumberNeeded = false;
+
+        pgn::NAG_t nag;
+        while ( ( nag = move->getNAG() ) != pgn::nagNull )
+        {
+            std::cout << ' ' << pgn::IMove::toString(nag, pgn::nfNumeric);
+        }
+
+        if ( move->getComment() != NULL )
+        {
+            std::cout << " {" << move->getComment() << '}';
+            isNumberNeeded = true;
+        }
+
+        for ( unsigned i = 1; i <= game->getVariationCount(move); ++i )
+        {
+            std::cout << " (";
+            dumpVariation(game, game->getVariation(move, i), isWhite);
+            std::cout << ')';
+            isNumberNeeded = true;
+        }
+
+        isWhite = !isWhite;
+    }
+}
+
+void dumpGame(pgn::IGame const* game)
+{
+    pgn::tag_pair_t tagPair;
+    while ( ( tagPair = game->getTagPair() ).name != NULL )
+    {
+        std::cout << '[' << tagPair.name << " \"" << tagPair.value << "\"]" <<
+            std::endl;
+    }
+    std::cout << std::endl;
+
+    /* A game from a position (FEN tag) can be started by black. */
+    pgn::IMove const* first = game->getMove(1, pgn::MAIN_LINE);
+    pgn::IMove const* second = game->getMove(2, pgn::MAIN_LINE);
+    dumpVariation(game, pgn::MAIN_LINE, second == NULL ||
+        first->getMoveNumber() == second->getMoveNumber());
+    char const* const results[] = { "1-0", "0-1", "1/2-1/2", "*" };
+    std::cout << ( game->getMoveCount(pgn::MAIN_LINE) != 0 ? " " : "" ) <<
+        results[game->getResult()] << std::endl << std::endl;
+}
+
+} /* unnamed namespace */
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t* argv[])
+#else
 int main(int argc, char* argv[])
 #endif
 {
@@ -49,5 +146,20 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    ErrorPrinter errorPrinter;
+    pgnparser->setErrorHandler(&errorPrinter);
+
+    pgn::IGame const* game;
+    while ((game = pgnparser->readGame()) != NULL)
+    {
+        if (pgn::IParser::isGameValid(game) == pgn::seValid)
+        {
+            dumpGame(game);
+        }
+
+        game->release();
+    }
+
+    pgnparser->setErrorHandler(NULL);
     return EXIT_SUCCESS;
 }